@@ -31,6 +31,7 @@
 // * clear screen
 // * delay 5 seconds
 // * display an image
+// * copy the following image from SD to FLASH while the current one is shown
 // * delay ? seconds
 // * back to image display
 
@@ -39,11 +40,14 @@
 #include <ctype.h>
 
 #include <SPI.h>
+#include <SPI_BUS.h>
 #include <SD.h>
+#include <SD_READER.h>
 #include <FLASH.h>
+#include <FLASH_STORE.h>
 #include <EPD.h>
+#include <TEMPERATURE.h>
 #include <S5813A.h>
-#include <FLASH.h>
 
 
 // Change this for different display size
@@ -91,19 +95,55 @@ const int Pin_SD_CS = 10;
 // the maximum number of characters in an image path
 #define MAXIMUM_PATH_LENGTH 32
 
+// images are copied into two FLASH image store slots, "slide.0" and "slide.1":
+// one holds the image on the panel, the other the next image which is streamed
+// from the SD card while the current one is displayed; the update stages then
+// only read the FLASH.  If the FLASH is missing or full the image is read
+// from the SD card directly.  An image already in a slot (an index of one or
+// two images) is not copied again, and each copy goes after the previous one
+// (FLASH_STORE allocates next fit) so the erases spread over the whole chip.
+#define SLIDE_NAME "slide."
+
+// bytes per SD read when copying an image to the FLASH
+#define PREFETCH_BLOCK_SIZE 32
+
+// SRAM to keep image lines read from the FLASH between stage passes, or a
+// block of the file when an image is read from the SD card
+// (kept small as the SD library already needs a 512 byte block buffer)
+#define LINE_CACHE_SIZE 128
+
 // pre-processor convert to string
 #define MAKE_STRING1(X) #X
 #define MAKE_STRING(X) MAKE_STRING1(X)
 
 
 // define the E-Ink display
-EPD_Class EPD(EPD_SIZE, Pin_PANEL_ON, Pin_BORDER, Pin_DISCHARGE, Pin_PWM, Pin_RESET, Pin_BUSY, Pin_EPD_CS, SPI);
+EPD_Class EPD(EPD_SIZE, Pin_PANEL_ON, Pin_BORDER, Pin_DISCHARGE, Pin_PWM, Pin_RESET, Pin_BUSY, Pin_EPD_CS);
 
 
 File index_file;
 File current_image;
 File next_image;
 
+// FLASH_STORE ids of the slots, -1 if the image is not in the FLASH
+// (both slots have the same id when an image follows itself)
+static int16_t slide_id[2] = {-1, -1};
+// CRC-32 of the file name of each slot's image, to find it again
+static uint32_t slide_file[2];
+// slot of next_image, the current image is in the other one
+static uint8_t slide = 1;
+
+// only one image source is in use at a time, so they share the cache
+static uint8_t line_cache[LINE_CACHE_SIZE];
+static SD_reader image_reader(line_cache, sizeof(line_cache));
+
+
+// function prototypes
+void set_spi_for_sd();
+void set_spi_for_epd();
+static void prefetch(uint8_t slot, const char *filename);
+static void flash_read(void *buffer, uint32_t address, uint16_t length);
+
 
 void open_index() {
 	index_file.close();
@@ -117,10 +157,12 @@ void open_index() {
 }
 
 
-// open up the next image an return the delay
+// open up the next image, copy it to the FLASH and return the delay
 int get_image() {
+	set_spi_for_sd();
 	current_image.close();
 	current_image = next_image;
+	slide ^= 1;
 
 	// get seconds, first non-digit ends number
 	int seconds = 0;
@@ -176,34 +218,119 @@ int get_image() {
 			delay(1000);
 		}
 	}
+	set_spi_for_epd();
+	prefetch(slide, filename);
 	return seconds;
 }
 
+// set the SPI up for the SD card
+void set_spi_for_sd() {
+	SPI_BUS.acquire(&SD_READER_spi);
+}
+
 // ensure clock is ok for EPD
-// as any SD operation alters the SPI configuration
+// as any SD operation alters the SPI configuration,
+// the next EPD or FLASH access will then set it up again
 void set_spi_for_epd() {
-	SPI.setBitOrder(MSBFIRST);
-	SPI.setDataMode(SPI_MODE0);
-	SPI.setClockDivider(SPI_CLOCK_DIV4);
+	SPI_BUS.invalidate();
+}
+
+
+// true if the slot holds the image of file (name CRC and length)
+static bool slot_holds(uint8_t slot, uint32_t file, uint32_t length) {
+	FLASH_STORE_entry entry;
+	return slide_id[slot] >= 0 && file == slide_file[slot]
+		&& FLASH_STORE.get(slide_id[slot], &entry) && length == entry.length;
 }
 
 
-// read a block from the current image
-void next_image_reader(void *buffer, uint32_t address, uint16_t length) {
-	byte *my_buffer = (byte *)buffer;
-	for(uint16_t i = 0; i < length; i++){
-		next_image.seek(address + i);
-		*my_buffer++ = next_image.read();
+// copy next_image into the FLASH slot in one sequential pass
+// on any failure the slot is left empty and the image is read from the SD card
+static void prefetch(uint8_t slot, const char *filename) {
+	uint32_t length = next_image.size();
+	uint32_t file = FLASH_STORE.crc32(0, filename, strlen(filename));
+
+	// the slot holds the image displayed before the current one, with a
+	// short index that can be this one again
+	if (slot_holds(slot, file, length)) {
+		return;
+	}
+	if (slide_id[slot] >= 0) {
+		if (slide_id[slot] != slide_id[slot ^ 1]) {
+			FLASH_STORE.remove(slide_id[slot]);
+		}
+		slide_id[slot] = -1;
+	}
+	// or the current image is shown again
+	if (slot_holds(slot ^ 1, file, length)) {
+		slide_id[slot] = slide_id[slot ^ 1];
+		slide_file[slot] = file;
+		return;
+	}
+	if (!FLASH_STORE.mounted()) {
+		return;
+	}
+
+	int16_t sector = FLASH_STORE.allocate(length, false);
+	if (sector < 0) {
+		Serial.println("prefetch: no FLASH space");
+		return;
+	}
+
+	uint32_t address = (uint32_t)sector << FLASH_SECTOR_SHIFT;
+	FLASH_page_writer writer(FLASH, address);
+	uint8_t buffer[PREFETCH_BLOCK_SIZE];
+	uint32_t crc = 0;
+	uint32_t count = 0;
+	while (count < length) {
+		set_spi_for_sd();
+		int n = next_image.read(buffer, sizeof(buffer));
+		set_spi_for_epd();
+		if (n <= 0) {
+			break;
+		}
+		writer.write(buffer, n);
+		crc = FLASH_STORE.crc32(crc, buffer, n);
+		count += n;
+	}
+	writer.finish();
+
+	if (count != length || FLASH_STORE.crc32_flash(address, length) != crc) {
+		Serial.println("prefetch: FLASH copy failed");
+		return;
 	}
-	set_spi_for_epd();  // ensure SPI OK for EPD
+	char name[] = SLIDE_NAME "0";
+	name[sizeof(name) - 2] += slot;
+	slide_id[slot] = FLASH_STORE.add(name, sector, length, EPD_SIZE, FLASH_STORE_XBM, crc);
+	slide_file[slot] = file;
+}
+
+
+// EPD display callback for reading the FLASH
+static void flash_read(void *buffer, uint32_t address, uint16_t length) {
+	FLASH.read(buffer, address, length);
+}
+
+
+// EPD display callback for reading the image file set by image_reader.begin()
+void image_read(void *buffer, uint32_t address, uint16_t length) {
+	image_reader.read(buffer, address, length);
 }
-void current_image_reader(void *buffer, uint32_t address, uint16_t length){
-	byte *my_buffer = (byte *)buffer;
-	for (uint16_t i = 0; i < length; ++i){
-		current_image.seek(address + i);
-		*my_buffer++ = current_image.read();
+
+
+// update stages for one image: from its FLASH slot if it has one,
+// otherwise straight from the SD card
+static void show(uint8_t slot, File &file, EPD_stage first, EPD_stage second) {
+	FLASH_STORE_entry entry;
+	if (slide_id[slot] >= 0 && FLASH_STORE.get(slide_id[slot], &entry)) {
+		EPD_cached_reader_source image(FLASH_STORE.address(&entry), flash_read, line_cache, sizeof(line_cache));
+		EPD.frame_repeat(image, first);
+		EPD.frame_repeat(image, second);
+	} else {
+		image_reader.begin(file);
+		EPD.frame_cb_repeat(0, image_read, first);
+		EPD.frame_cb_repeat(0, image_read, second);
 	}
-	set_spi_for_epd();  // ensure SPI OK for EPD
 }
 
 
@@ -233,6 +360,7 @@ void setup() {
 	SPI.setDataMode(SPI_MODE0);
 	SPI.setClockDivider(SPI_CLOCK_DIV4);
 
+	Serial.begin(9600);
 #if !defined(__MSP430_CPU__)
 	// wait for USB CDC serial port to connect.  Arduino Leonardo only
 	while (!Serial) {
@@ -244,16 +372,29 @@ void setup() {
 	Serial.println("Display: " MAKE_STRING(EPD_SIZE));
 	Serial.println();
 
-	FLASH.begin(Pin_FLASH_CS, SPI);
+	FLASH.begin(Pin_FLASH_CS);
 	if (FLASH.available()) {
 		Serial.println("FLASH chip detected OK");
+		if (!FLASH_STORE.begin()) {
+			Serial.println("FLASH: creating image store");
+			FLASH_STORE.format();
+		}
+		// slots left over from a previous run
+		FLASH_STORE_entry entry;
+		for (uint8_t slot = 0; slot < 2; ++slot) {
+			char name[] = SLIDE_NAME "0";
+			name[sizeof(name) - 2] += slot;
+			int16_t id = FLASH_STORE.find(name, &entry);
+			if (id >= 0) {
+				FLASH_STORE.remove(id);
+			}
+		}
 	} else {
-		Serial.println("unsupported FLASH chip");
+		Serial.println("unsupported FLASH chip: images are read from the SD card");
 	}
 
 	// configure temperature sensor
 	S5813A.begin(Pin_TEMPERATURE);
-	Serial.begin(9600);
 	Serial.print("Initializing SD card...");
 	// On the Ethernet Shield, CS is pin 4. It's set as an output by default.
 	// Note that even if it's not used as the CS pin, the hardware SS pin
@@ -274,6 +415,9 @@ void setup() {
 
 static int state = 0;
 
+// display time of next_image
+static int seconds = 0;
+
 // main loop
 unsigned long int loop_count = 0;
 void loop() {
@@ -282,11 +426,10 @@ void loop() {
 	Serial.print(temperature);
 	Serial.println(" Celcius");
 
-	// get an image
-	int seconds = get_image();
-
-	//*** maybe need to ensure clock is ok for EPD
-	set_spi_for_epd();
+	// the first image has nothing to overlap its copy with
+	if (0 == state) {
+		seconds = get_image();
+	}
 
 	EPD.begin(); // power up the EPD panel
 	EPD.setFactor(temperature); // adjust for current temperature
@@ -299,21 +442,23 @@ void loop() {
 		// clear -> image1
 		EPD.frame_fixed_repeat(0, EPD_compensate);
 		EPD.frame_fixed_repeat(0, EPD_white);
-		EPD.frame_cb_repeat(0, next_image_reader, EPD_inverse);
-		EPD.frame_cb_repeat(0, next_image_reader, EPD_normal);
+		show(slide, next_image, EPD_inverse, EPD_normal);
 		++state;
 		break;
 	case 1:        // swap images
-		EPD.frame_cb_repeat(0, current_image_reader, EPD_compensate);
-		EPD.frame_cb_repeat(0, current_image_reader, EPD_white);
-		EPD.frame_cb_repeat(0, next_image_reader, EPD_inverse);
-		EPD.frame_cb_repeat(0, next_image_reader, EPD_normal);
+		show(slide ^ 1, current_image, EPD_compensate, EPD_white);
+		show(slide, next_image, EPD_inverse, EPD_normal);
 		break;
 	}
 	EPD.end();   // power down the EPD panel
 
-	// wait for 5 seconds
-	for (int x = 0; x < seconds; ++x) {
-		delay(1000);
+	// fetch the following image while this one is displayed
+	unsigned long displayed = millis();
+	unsigned long display_ms = seconds * 1000UL;
+	seconds = get_image();
+
+	// wait for the rest of the display time
+	while (millis() - displayed < display_ms) {
+		delay(10);
 	}
 }
@@ -25,9 +25,13 @@
 
 // required libraries
 #include <SPI.h>
+#include <SPI_BUS.h>
 #include <FLASH.h>
+#include <FLASH_STORE.h>
+#include <UPLOAD.h>
 #include <EPD.h>
 //Temperature sensor
+#include <TEMPERATURE.h>
 #ifndef EMBEDDED_ARTISTS
 #include <S5813A.h>
 #else /* EMBEDDED_ARTISTS */
@@ -39,7 +43,7 @@
 // Change this for different display size
 #define EPD_SIZE EPD_2_7
 
-#define COMMAND_VERSION "2"
+#define COMMAND_VERSION "3"
 
 
 // definition of I/O pins LaunchPad and Arduino are different
@@ -96,13 +100,17 @@ const int Pin_RED_LED = 13;
 // function prototypes
 static void flash_info(void);
 static void flash_read(void *buffer, uint32_t address, uint16_t length);
+static void store_info(void);
+static void display_image(const FLASH_STORE_entry *entry, EPD_stage first, EPD_stage second);
+static bool verify_image(uint8_t id, const FLASH_STORE_entry *entry);
 
 static uint16_t xbm_count;
 static bool xbm_parser(uint8_t *b);
 
-
 static uint8_t Serial_getc();
 static uint16_t Serial_gethex(bool echo);
+static uint8_t Serial_getname(char *name, uint8_t size);
+static int16_t Serial_getimage(FLASH_STORE_entry *entry);
 static void Serial_puthex(uint32_t n, int bits);
 static void Serial_puthex_byte(uint8_t n);
 static void Serial_puthex_word(uint16_t n);
@@ -110,6 +118,14 @@ static void Serial_puthex_double(uint32_t n);
 static void Serial_hex_dump(uint32_t address, const void *buffer, uint16_t length);
 
 
+// SRAM to keep image lines read from the FLASH between stage passes
+// (lines that do not fit are re-read from the FLASH on every pass)
+// four lines of the largest panel, so it still fits on an Uno; a board
+// with more SRAM can keep a whole segment or image
+#define LINE_CACHE_SIZE (4 * 264 / 8)
+static uint8_t line_cache[LINE_CACHE_SIZE];
+
+
 // define the E-Ink display
 EPD_Class EPD(EPD_SIZE, Pin_PANEL_ON, Pin_BORDER, Pin_DISCHARGE, Pin_PWM, Pin_RESET, Pin_BUSY, Pin_EPD_CS);
 
@@ -130,13 +146,8 @@ LM75A_Class LM75A;
 //   L                 H                 H               H
 //   H                 L                 H               L
 //   H                 H                 H               H
-void selectFlash() {
-  digitalWrite(Pin_PANEL_ON, LOW);
-}
-
-void selectEPD() {
-  digitalWrite(Pin_PANEL_ON, HIGH); //Change back to using SSEL for EPD
-}
+//FLASH.begin(Pin_EPD_CS, Pin_PANEL_ON, LOW) has SPI_BUS hold PANEL_ON low for each flash access
+//(and put it back afterwards) so the flash is selected instead of the display.
 
 
 
@@ -189,12 +200,17 @@ void setup() {
 #ifndef EMBEDDED_ARTISTS
 	FLASH.begin(Pin_FLASH_CS);
 #else
-        selectFlash();
-	FLASH.begin(Pin_EPD_CS);
+	FLASH.begin(Pin_EPD_CS, Pin_PANEL_ON, LOW);
 #endif /* ! EMBEDDED_ARTISTS */
 
 	flash_info();
 
+	FLASH_STORE.begin();
+	store_info();
+
+	// binary upload (upload.py) blinks the LED as the data arrives
+	UPLOAD.begin(Pin_RED_LED, LED_OFF);
+
 #ifndef EMBEDDED_ARTISTS
 	// configure temperature sensor
 	S5813A.begin(Pin_TEMPERATURE);
@@ -202,7 +218,6 @@ void setup() {
 }
 
 void startEPD() {
-        selectEPD();
         EPD.begin();
 #ifndef EMBEDDED_ARTISTS
         int temperature = S5813A.read();
@@ -230,17 +245,23 @@ void loop() {
 		Serial.println("h          - this command");
 		Serial.println("d<ss> <ll> - dump sector in hex, ll * 16 bytes");
 		Serial.println("e<ss>      - erase sector to 0xff");
-		Serial.println("u<ss>      - upload XBM to sector");
-		Serial.println("i<ss>      - display an image on white screen");
-		Serial.println("r<ss>      - revert an image back to white");
-		Serial.println("l          - search for non-empty sectors");
+		Serial.println("u<name>    - upload XBM as a new image");
+		Serial.println("b          - binary image upload (upload.py)");
+		Serial.println("i<image>   - display an image on white screen");
+		Serial.println("r<image>   - revert an image back to white");
+		Serial.println("x<image>   - delete an image");
+		Serial.println("v<image>   - verify an image against its CRC");
+		Serial.println("V          - verify all images");
+		Serial.println("l          - list images");
+		Serial.println("s          - search for non-empty sectors");
+		Serial.println("F          - format the image store");
+		Serial.println("           <image> is a name or a hex id");
 		Serial.println("w          - clear screen to white");
 		Serial.println("f          - dump FLASH identification");
 		Serial.println("t          - show temperature");
 		break;
 	case 'd':
 	{
-                selectFlash();
 		uint16_t sector = Serial_gethex(true);
 		Serial.print(' ');
 		uint16_t count = Serial_gethex(true);
@@ -253,18 +274,19 @@ void loop() {
 		Serial.println();
 		uint32_t address = sector;
 		address <<= 12;
+		FLASH.begin_stream(address);
 		for (uint16_t i = 0; i < count; ++i) {
 			uint8_t buffer[16];
-			FLASH.read(buffer, address, sizeof(buffer));
+			FLASH.read_next(buffer, sizeof(buffer));
 			Serial_hex_dump(address, buffer, sizeof(buffer));
 			address += sizeof(buffer);
 		}
+		FLASH.end_stream();
 		break;
 	}
 
 	case 'e':
 	{
-                selectFlash();
 		uint32_t sector = Serial_gethex(true);
 		FLASH.write_enable();
 		FLASH.sector_erase(sector << 12);
@@ -274,81 +296,178 @@ void loop() {
 
 	case 'u':
 	{
-                selectFlash();
-		uint32_t address = Serial_gethex(true);
+		char name[FLASH_STORE_NAME_SIZE];
+		if (0 == Serial_getname(name, sizeof(name))) {
+			Serial.println();
+			Serial.println("missing name");
+			break;
+		}
+		// room for the largest panel, only the sectors used are kept
+		// (the writer erases them as the upload reaches them)
+		const uint16_t space = 264L * 176 / 8;
+		int16_t sector = FLASH_STORE.allocate(space, false);
+		if (sector < 0) {
+			Serial.println();
+			Serial.println("no free sectors");
+			break;
+		}
+		uint32_t address = sector;
 		address <<= 12;
+		uint32_t crc = 0;
 		xbm_count = 0;
 		Serial.println();
 		Serial.println("start upload...");
 
-		for (;;) {
-			uint8_t buffer[16];
-			uint16_t count = 0;
-			for (int i = 0; i < sizeof(buffer); ++i, ++count) {
-				if (!xbm_parser(&buffer[i])) {
-					break;
-				}
-			}
-			FLASH.write_enable();
-			FLASH.write(address, buffer, count);
-			address += count;
-			if (sizeof(buffer) != count) {
-				break;
+		FLASH_page_writer writer(FLASH, address);
+		uint8_t b;
+		bool too_large = false;
+		while (xbm_parser(&b)) {
+			if (too_large || xbm_count > space) {
+				// past the allocated sectors: read the rest, write nothing
+				too_large = true;
+				continue;
 			}
+			writer.write(&b, sizeof(b));
+			crc = FLASH_STORE.crc32(crc, &b, sizeof(b));
 		}
-
-		FLASH.write_disable();
+		writer.finish();
 
 		Serial.println();
 		Serial.print(" read = ");
 		Serial_puthex_word(xbm_count);
-		if (128 * 96 / 8 == xbm_count) {
+		uint8_t panel;
+		if (too_large) {
+			Serial.println(" image too large");
+			break;
+		} else if (128 * 96 / 8 == xbm_count) {
 			Serial.print(" 128x96 1.44");
+			panel = EPD_1_44;
 		} else if (200 * 96 / 8 == xbm_count) {
 			Serial.print(" 200x96 2.0");
+			panel = EPD_2_0;
 		} else if (264L * 176 / 8 == xbm_count) {
 			Serial.print(" 264x176 2.7");
+			panel = EPD_2_7;
 		} else {
-			Serial.print(" invalid image");
+			Serial.println(" invalid image");
+			break;
+		}
+		Serial.println();
+
+		if (FLASH_STORE.crc32_flash(address, xbm_count) != crc) {
+			Serial.println("verify failed");
+			break;
 		}
+
+		// replace an older image of the same name
+		FLASH_STORE_entry entry;
+		int16_t id = FLASH_STORE.find(name, &entry);
+		if (id >= 0) {
+			FLASH_STORE.remove(id);
+		}
+		id = FLASH_STORE.add(name, sector, xbm_count, panel, FLASH_STORE_XBM, crc);
+		if (id < 0) {
+			Serial.println("directory full");
+			break;
+		}
+		Serial.print("image: ");
+		Serial_puthex_byte(id);
 		Serial.println();
 		break;
 	}
 
 	case 'i':
 	{
-		uint32_t address = Serial_gethex(true);
-		address <<= 12;
-                startEPD();
-		EPD.frame_cb_repeat(address, flash_read, EPD_inverse);
-		EPD.frame_cb_repeat(address, flash_read, EPD_normal);
-		EPD.end();
+		FLASH_STORE_entry entry;
+		if (Serial_getimage(&entry) >= 0) {
+			display_image(&entry, EPD_inverse, EPD_normal);
+		}
 		break;
 	}
 
 	case 'r':
 	{
-		uint32_t address = Serial_gethex(true);
-		address <<= 12;
-                startEPD();
-		EPD.frame_cb_repeat(address, flash_read, EPD_compensate);
-		EPD.frame_cb_repeat(address, flash_read, EPD_white);
-		EPD.end();
+		FLASH_STORE_entry entry;
+		if (Serial_getimage(&entry) >= 0) {
+			display_image(&entry, EPD_compensate, EPD_white);
+		}
+		break;
+	}
+
+	case 'x':
+	{
+		FLASH_STORE_entry entry;
+		int16_t id = Serial_getimage(&entry);
+		if (id >= 0) {
+			FLASH_STORE.remove(id);
+		}
+		break;
+	}
+
+	case 'v':
+	{
+		FLASH_STORE_entry entry;
+		int16_t id = Serial_getimage(&entry);
+		if (id >= 0) {
+			Serial.println();
+			verify_image(id, &entry);
+		}
+		break;
+	}
+
+	case 'V':
+	{
+		Serial.println();
+		uint16_t count = 0;
+		uint16_t bad = 0;
+		FLASH_STORE_entry entry;
+		for (int16_t id = FLASH_STORE.next(0, &entry); id >= 0; id = FLASH_STORE.next(id + 1, &entry)) {
+			++count;
+			if (!verify_image(id, &entry)) {
+				++bad;
+			}
+		}
+		Serial.print("verify: images = ");
+		Serial_puthex_byte(count);
+		Serial.print(" bad = ");
+		Serial_puthex_byte(bad);
+		Serial.println();
 		break;
 	}
 
 	case 'l':
 	{
-                selectFlash();
+		Serial.println();
+		FLASH_STORE_entry entry;
+		for (int16_t id = FLASH_STORE.next(0, &entry); id >= 0; id = FLASH_STORE.next(id + 1, &entry)) {
+			Serial_puthex_byte(id);
+			Serial.print(' ');
+			Serial.print(entry.name);
+			for (uint8_t n = strlen(entry.name); n < FLASH_STORE_NAME_SIZE; ++n) {
+				Serial.print(' ');
+			}
+			Serial.print("sector: ");
+			Serial_puthex_byte(entry.first_sector);
+			Serial.print(" length: ");
+			Serial_puthex_word(entry.length);
+			Serial.print(FLASH_STORE_PACKBITS == entry.format ? " packbits" : " xbm");
+			Serial.println();
+		}
+		store_info();
+		break;
+	}
+
+	case 's':
+	{
 		Serial.println();
 		uint16_t per_line = 0;
 		for (uint16_t sector = 0; sector <= 0xff; ++sector) {
+			uint32_t address = sector;
+			address <<= 12;
+			FLASH.begin_stream(address);
 			for (uint16_t i = 0; i < 4096; i += 16) {
 				uint8_t buffer[16];
-				uint32_t address = sector;
-				address <<= 12;
-				address += i;
-				FLASH.read(buffer, address, sizeof(buffer));
+				FLASH.read_next(buffer, sizeof(buffer));
 				bool flag = false;
 				for (uint16_t j = 0; j < sizeof(buffer); ++j) {
 					if (0xff != buffer[j]) {
@@ -367,7 +486,7 @@ void loop() {
 					break;
 				}
 			}
-
+			FLASH.end_stream();
 		}
 		if (0 != per_line) {
 			Serial.println();
@@ -375,9 +494,24 @@ void loop() {
 		break;
 	}
 
+	case 'b':
+		UPLOAD.receive();
+		break;
+
+	case 'F':
+	{
+		Serial.println();
+		Serial.print("erase all images? (y/n) ");
+		if ('y' == Serial_getc()) {
+			FLASH_STORE.format();
+			Serial.println();
+			store_info();
+		}
+		break;
+	}
+
 	case 'f':
 	{
-		selectFlash();
                 Serial.println();
 		flash_info();
 		break;
@@ -419,9 +553,60 @@ static void flash_info(void) {
 
 
 static void flash_read(void *buffer, uint32_t address, uint16_t length) {
-        selectFlash();
 	FLASH.read(buffer, address, length);
-        selectEPD();
+}
+
+
+static void store_info(void) {
+	if (!FLASH_STORE.mounted()) {
+		Serial.println("no image store, use F to create one");
+		return;
+	}
+	Serial.print("image store: free entries = ");
+	Serial_puthex_byte(FLASH_STORE.free_entries());
+	Serial.print(" free sectors = ");
+	Serial_puthex_byte(FLASH_STORE.free_sectors());
+	Serial.println();
+}
+
+
+// one line per image: "verify: <id> <name> <crc> ok|BAD <crc read back>"
+static bool verify_image(uint8_t id, const FLASH_STORE_entry *entry) {
+	uint32_t crc = FLASH_STORE.crc32_flash(FLASH_STORE.address(entry), entry->length);
+	Serial.print("verify: ");
+	Serial_puthex_byte(id);
+	Serial.print(' ');
+	Serial.print(entry->name);
+	Serial.print(' ');
+	Serial_puthex_double(entry->crc);
+	if (crc == entry->crc) {
+		Serial.println(" ok");
+		return true;
+	}
+	Serial.print(" BAD ");
+	Serial_puthex_double(crc);
+	Serial.println();
+	return false;
+}
+
+
+// run two stages of a stored image
+static void display_image(const FLASH_STORE_entry *entry, EPD_stage first, EPD_stage second) {
+	uint32_t address = FLASH_STORE.address(entry);
+	startEPD();
+#if defined(EPD_PACKBITS_SUPPORT)
+	if (FLASH_STORE_PACKBITS == entry->format) {
+		EPD_packbits_source image(address, flash_read);
+		EPD.frame_repeat(image, first);
+		EPD.frame_repeat(image, second);
+		EPD.end();
+		return;
+	}
+#endif
+	EPD_cached_reader_source image(address, flash_read, line_cache, sizeof(line_cache));
+	EPD.frame_repeat(image, first);
+	EPD.frame_repeat(image, second);
+	EPD.end();
 }
 
 
@@ -477,6 +662,45 @@ static uint16_t Serial_gethex(bool echo) {
 }
 
 
+// read a name up to the first space or control character
+static uint8_t Serial_getname(char *name, uint8_t size) {
+	uint8_t length = 0;
+	for (;;) {
+		uint8_t c = Serial_getc();
+		if (!isgraph(c)) {
+			break;
+		}
+		if (length < size - 1) {
+			name[length++] = c;
+			Serial.write(c);
+		}
+	}
+	name[length] = '\0';
+	return length;
+}
+
+
+// image by name, or failing that by hex id
+static int16_t Serial_getimage(FLASH_STORE_entry *entry) {
+	char name[FLASH_STORE_NAME_SIZE];
+	Serial_getname(name, sizeof(name));
+	int16_t id = FLASH_STORE.find(name, entry);
+	if (id < 0) {
+		char *end;
+		unsigned long n = strtoul(name, &end, 16);
+		if ('\0' != name[0] && '\0' == *end && n < FLASH_STORE_ENTRIES
+		    && FLASH_STORE.get(n, entry)) {
+			id = n;
+		}
+	}
+	if (id < 0) {
+		Serial.println();
+		Serial.println("no such image");
+	}
+	return id;
+}
+
+
 static void Serial_puthex(uint32_t n, int bits) {
 	for (int i = bits - 4; i >= 0; i -= 4) {
 		char nibble = ((n >> i) & 0x0f) + '0';
@@ -35,8 +35,10 @@
 
 // required libraries
 #include <SPI.h>
+#include <SPI_BUS.h>
 #include <FLASH.h>
 #include <EPD.h>
+#include <TEMPERATURE.h>
 #include <S5813A.h>
 
 
@@ -15,8 +15,8 @@
 
 // Simple demo with two functions:
 //
-// 1. Copy an included iname to a specified FLSH sector and display it
-// 2. Display a list of already FLASHed images
+// 1. Copy an included image to the FLASH image store and display it
+// 2. Display a list of already FLASHed images (by name)
 //
 // Note: only one function is available at a time.
 
@@ -26,8 +26,11 @@
 
 // required libraries
 #include <SPI.h>
+#include <SPI_BUS.h>
 #include <FLASH.h>
+#include <FLASH_STORE.h>
 #include <EPD.h>
+#include <TEMPERATURE.h>
 #include <S5813A.h>
 
 
@@ -36,14 +39,13 @@
 #define SCREEN_SIZE 0
 
 // select image from:  text_image text-hello cat aphrodite venus saturn
-// select a suitable sector, (size 270 will take two sectors)
+// the image is stored under this name (unless already there)
 #define IMAGE        cat
-#define FLASH_SECTOR 0
 
 // if the display list is defined it will take priority over the flashing
 // (and FLASH code is disbled)
-// define a list of {sector, milliseconds}
-// #define DISPLAY_LIST {0, 5000}, {1, 5000}
+// define a list of {"image name", milliseconds}
+// #define DISPLAY_LIST {"cat", 5000}, {"venus", 5000}
 
 // no futher changed below this point
 
@@ -153,9 +155,17 @@ static void flash_info(void);
 static void flash_read(void *buffer, uint32_t address, uint16_t length);
 
 #if !defined(DISPLAY_LIST)
-static void flash_program(const void *buffer, uint16_t sector, uint16_t length);
+static void flash_program(const char *name, const void *buffer, uint16_t length);
 #endif
 
+// SRAM to keep image lines read from the FLASH between stage passes
+// (lines that do not fit are re-read from the FLASH on every pass)
+// four lines of the largest panel, so it still fits on an Uno; a board
+// with more SRAM can keep a whole segment or image
+#define LINE_CACHE_SIZE (4 * 264 / 8)
+static uint8_t line_cache[LINE_CACHE_SIZE];
+
+
 // define the E-Ink display
 EPD_Class EPD(EPD_SIZE, Pin_PANEL_ON, Pin_BORDER, Pin_DISCHARGE, Pin_PWM, Pin_RESET, Pin_BUSY, Pin_EPD_CS);
 
@@ -198,28 +208,30 @@ void setup() {
 	FLASH.begin(Pin_FLASH_CS);
 	flash_info();
 
+	FLASH_STORE.begin();
+
 	// configure temperature sensor
 	S5813A.begin(Pin_TEMPERATURE);
 
 	// if necessary program the flash
 #if !defined(DISPLAY_LIST)
-	flash_program(FLASH_SECTOR, IMAGE_BITS, sizeof(IMAGE_BITS));
+	flash_program(MAKE_STRING(IMAGE), IMAGE_BITS, sizeof(IMAGE_BITS));
 #endif
 }
 
 
 typedef struct {
-	int sector;
+	const char *name;
 	int delay_ms;
 } display_list_type[];
 
-// list of {FLASH sector, milliseconds} to display
-// if not defined then just display the current flash sector
+// list of {image name, milliseconds} to display
+// if not defined then just display the image just stored
 static const display_list_type display_list = {
 #if defined(DISPLAY_LIST)
 	DISPLAY_LIST
 #else
-	{FLASH_SECTOR, 5000}
+	{MAKE_STRING(IMAGE), 5000}
 #endif
 };
 
@@ -251,19 +263,31 @@ void loop() {
 		break;
 
 	case 1:         // next image
-		uint32_t address = display_list[display_index].sector << 12;
+	{
+		FLASH_STORE_entry entry;
+		if (FLASH_STORE.find(display_list[display_index].name, &entry) < 0) {
+			Serial.print("Missing image: ");
+			Serial.println(display_list[display_index].name);
+			if (++display_index >= DISPLAY_ITEM_COUNT) {
+				display_index = 0;
+			}
+			break;
+		}
+		uint32_t address = FLASH_STORE.address(&entry);
 		Serial.print("Address = 0x");
 		Serial.println(address, HEX);
 		delay_counts = display_list[display_index].delay_ms;
 		EPD.begin();
 		int t = S5813A.read();
 		EPD.setFactor(t);
+		EPD_cached_reader_source image(old_address, flash_read, line_cache, sizeof(line_cache));
 		if (0xffffffff != old_address) {
-			EPD.frame_cb_repeat(old_address, flash_read, EPD_compensate);
-			EPD.frame_cb_repeat(old_address, flash_read, EPD_white);
+			EPD.frame_repeat(image, EPD_compensate);
+			EPD.frame_repeat(image, EPD_white);
 		}
-		EPD.frame_cb_repeat(address, flash_read, EPD_inverse);
-		EPD.frame_cb_repeat(address, flash_read, EPD_normal);
+		image.set_address(address);
+		EPD.frame_repeat(image, EPD_inverse);
+		EPD.frame_repeat(image, EPD_normal);
 		EPD.end();
 		// preserve address for next cycle
 		old_address = address;
@@ -272,6 +296,7 @@ void loop() {
 			display_index = 0;
 		}
 		break;
+	}
 
 	}
 
@@ -306,8 +331,29 @@ static void flash_read(void *buffer, uint32_t address, uint16_t length) {
 
 
 #if !defined(DISPLAY_LIST)
-// program image into FLASH
-static void flash_program(uint16_t sector, const void *buffer, uint16_t length) {
+// store the image in the FLASH image store (unless it is already there)
+static void flash_program(const char *name, const void *buffer, uint16_t length) {
+	uint32_t crc = FLASH_STORE.crc32(0, buffer, length, true);
+
+	if (!FLASH_STORE.mounted()) {
+		Serial.println("FLASH: creating image store");
+		FLASH_STORE.format();
+	}
+	FLASH_STORE_entry entry;
+	int16_t old_id = FLASH_STORE.find(name, &entry);
+	if (old_id >= 0 && length == entry.length && crc == entry.crc && FLASH_STORE.verify(&entry)) {
+		Serial.print("FLASH: ");
+		Serial.print(name);
+		Serial.print(" already stored as image ");
+		Serial.println(old_id, DEC);
+		return;
+	}
+
+	int16_t sector = FLASH_STORE.allocate(length, false);
+	if (sector < 0) {
+		Serial.println("FLASH: no free sectors");
+		return;
+	}
 	Serial.print("FLASH: program sector = ");
 	Serial.println(sector, DEC);
 	Serial.print("       from memory @ 0x");
@@ -315,42 +361,28 @@ static void flash_program(uint16_t sector, const void *buffer, uint16_t length)
 	Serial.print("  total bytes: ");
 	Serial.println(length, DEC);
 
-	uint32_t address = sector << FLASH_SECTOR_SHIFT;
+	// erases each sector and programs whole pages
+	FLASH_page_writer writer(FLASH, (uint32_t)sector << FLASH_SECTOR_SHIFT);
+	writer.write(buffer, length, true);
+	writer.finish();
 
-	// erase required sectors
-	for (int i = 0; i < length; i += FLASH_SECTOR_SIZE, address += FLASH_SECTOR_SIZE) {
-		Serial.print("FLASH: erase = 0x");
-		Serial.println(address, HEX);
-		FLASH.write_enable();
-		FLASH.sector_erase(address);
+	if (FLASH_STORE.crc32_flash((uint32_t)sector << FLASH_SECTOR_SHIFT, length) != crc) {
+		Serial.println("FLASH: verify failed");
+		return;
 	}
 
-	// writable pages are FLASH_PAGE_SIZE bytes
-	const uint8_t *p = (const uint8_t *)buffer;
-	for (address = sector << FLASH_SECTOR_SHIFT; length >= FLASH_PAGE_SIZE;
-	     length -= FLASH_PAGE_SIZE, address += FLASH_PAGE_SIZE, p += FLASH_PAGE_SIZE) {
-		Serial.print("FLASH: write @ 0x");
-		Serial.print(address, HEX);
-		Serial.print("  from: 0x");
-		Serial.print((uint32_t)p, HEX);
-		Serial.print("  bytes: 0x");
-		Serial.println(FLASH_PAGE_SIZE, HEX);
-		FLASH.write_enable();
-		FLASH.write(address, p, FLASH_PAGE_SIZE);
+	// the new copy is complete, so the old one can go
+	if (old_id >= 0) {
+		FLASH_STORE.remove(old_id);
 	}
-	// write any remaining partial page
-	if (length > 0) {
-		Serial.print("FLASH: write @ 0x");
-		Serial.print(address, HEX);
-		Serial.print("  from: 0x");
-		Serial.print((uint32_t)p, HEX);
-		Serial.print("  bytes: 0x");
-		Serial.println(length, HEX);
-		FLASH.write_enable();
-		FLASH.write(address, p, length);
+	int16_t id = FLASH_STORE.add(name, sector, length, EPD_SIZE, FLASH_STORE_XBM, crc);
+	Serial.print("FLASH: ");
+	Serial.print(name);
+	if (id < 0) {
+		Serial.println(" not stored, directory full");
+	} else {
+		Serial.print(" stored as image ");
+		Serial.println(id, DEC);
 	}
-
-	// turn off write - just to be safe
-	FLASH.write_disable();
 }
 #endif
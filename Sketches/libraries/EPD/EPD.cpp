@@ -17,9 +17,14 @@
 #include <limits.h>
 
 #include <SPI.h>
+#include <SPI_BUS.h>
 
 #include "EPD.h"
 
+#if defined(EPD_STAGE_LOOKUP_TABLES)
+#include "EPD_tables.h"
+#endif
+
 // delays - more consistent naming
 #define Delay_ms(ms) delay(ms)
 #define Delay_us(us) delayMicroseconds(us)
@@ -28,6 +33,9 @@
 #define ARRAY(type, ...) ((type[]){__VA_ARGS__})
 #define CU8(...) (ARRAY(const uint8_t, __VA_ARGS__))
 
+// largest line: 0x72 + border + 2 * 264 / 8 pixel bytes + 176 / 4 scan bytes + filler
+#define EPD_LINE_BUFFER_SIZE (1 + 1 + 2 * 264 / 8 + 176 / 4 + 1)
+
 
 static void PWM_start(int pin);
 static void PWM_stop(int pin);
@@ -35,9 +43,46 @@ static void PWM_stop(int pin);
 static void SPI_on();
 static void SPI_off();
 static void SPI_put(uint8_t c);
-static void SPI_put_wait(uint8_t c, int busy_pin);
+#if defined(EPD_PROFILE_SUPPORT)
+#define EPD_PROFILE_START(t) unsigned long t = micros()
+#define EPD_PROFILE_ADD(field, t) this->profile_data.field += micros() - (t)
+#else
+#define EPD_PROFILE_START(t)
+#define EPD_PROFILE_ADD(field, t)
+#endif
+
+
+#if defined(EPD_FACTOR_INTERPOLATION)
+// temperature compensation from the COG driving waveform documents, which
+// give the same table for every panel size
+// each datasheet band keeps its factor from its upper edge down to 2 degrees
+// above the band below, with a ramp over those 2 degrees, so inside a band
+// the factor is the datasheet's and it is never below the step function's
+static PROGMEM const EPD_factor_point EPD_factor_table[] = {
+	{-10, 170},  // below -10
+	{-8, 120},   // -10 .. -5
+	{-5, 120},
+	{-3, 80},    // -5 .. 5
+	{5, 80},
+	{7, 40},     // 5 .. 10
+	{10, 40},
+	{12, 30},    // 10 .. 15
+	{15, 30},
+	{17, 20},    // 15 .. 20
+	{20, 20},
+	{22, 10},    // 20 .. 40
+	{40, 10},
+	{42, 7}      // above 40
+};
+#endif
+
+static uint32_t SPI_send_wait(const uint8_t *buffer, uint16_t length, volatile uint8_t *busy_port, uint8_t busy_mask);
 static void SPI_send(uint8_t cs_pin, const uint8_t *buffer, uint16_t length);
 
+static inline uint8_t read_pixels(const uint8_t *data, bool read_progmem);
+static inline uint8_t encode_even_pixels(uint8_t pixels, EPD_stage stage);
+static inline uint8_t encode_odd_pixels(uint8_t pixels, EPD_stage stage);
+
 
 EPD_Class::EPD_Class(EPD_size size,
 		     uint8_t panel_on_pin,
@@ -62,7 +107,31 @@ EPD_Class::EPD_Class(EPD_size size,
 	this->bytes_per_line = 128 / 8;
 	this->bytes_per_scan = 96 / 4;
 	this->filler = false;
+#if defined(EPD_STAGE_PASSES)
+	// stage_time divided by the frame time at the nominal line rate: the command
+	// preamble and its delays (60us) plus 2us for each byte of the line
+	// 1.44": 480ms / (96 * 176us) rounded up
+	this->stage_passes_1x = 29;
+#endif
+
+#if defined(EPD_FACTOR_INTERPOLATION)
+	// a size below may select its own table
+	this->factor_table = EPD_factor_table;
+	this->factor_table_length = sizeof(EPD_factor_table) / sizeof(EPD_factor_table[0]);
+#endif
+
+	// direct port access for polling BUSY on every line byte
+	this->busy_port = portInputRegister(digitalPinToPort(busy_pin));
+	this->busy_mask = digitalPinToBitMask(busy_pin);
+
+#if defined(EPD_ASYNC_SUPPORT)
+	this->async_active = false;
+	this->async_buffer_index = 0;
+#endif
 
+#if defined(EPD_PROFILE_SUPPORT)
+	this->profile_reset();
+#endif
 
 	// display size dependant items
 	{
@@ -86,6 +155,9 @@ EPD_Class::EPD_Class(EPD_size size,
 		this->bytes_per_line = 200 / 8;
 		this->bytes_per_scan = 96 / 4;
 		this->filler = true;
+#if defined(EPD_STAGE_PASSES)
+		this->stage_passes_1x = 24;  // 480ms / (96 * 212us)
+#endif
 		static uint8_t cs[] = {0x72, 0x00, 0x00, 0x00, 0x00, 0x01, 0xff, 0xe0, 0x00};
 		static uint8_t gs[] = {0x72, 0x03};
 		this->channel_select = cs;
@@ -103,6 +175,9 @@ EPD_Class::EPD_Class(EPD_size size,
 		this->bytes_per_line = 264 / 8;
 		this->bytes_per_scan = 176 / 4;
 		this->filler = true;
+#if defined(EPD_STAGE_PASSES)
+		this->stage_passes_1x = 13;  // 630ms / (176 * 284us)
+#endif
 		static uint8_t cs[] = {0x72, 0x00, 0x00, 0x00, 0x7f, 0xff, 0xfe, 0x00, 0x00};
 		static uint8_t gs[] = {0x72, 0x00};
 		this->channel_select = cs;
@@ -114,6 +189,10 @@ EPD_Class::EPD_Class(EPD_size size,
 	}
 
 	this->factored_stage_time = this->stage_time;
+
+#if defined(EPD_STAGE_PASSES)
+	this->factored_stage_passes = this->stage_passes_1x;
+#endif
 }
 
 
@@ -348,6 +427,29 @@ void EPD_Class::end() {
 // convert a temperature in Celcius to
 // the scale factor for frame_*_repeat methods
 int EPD_Class::temperature_to_factor_10x(int temperature) {
+#if defined(EPD_FACTOR_INTERPOLATION)
+	PROGMEM const EPD_factor_point *p = this->factor_table;
+	int t0 = (int8_t)pgm_read_byte_near(&p->temperature);
+	int f0 = pgm_read_byte_near(&p->factor_10x);
+
+	if (temperature <= t0) {
+		return f0;
+	}
+	for (uint8_t i = 1; i < this->factor_table_length; ++i) {
+		++p;
+		int t1 = (int8_t)pgm_read_byte_near(&p->temperature);
+		int f1 = pgm_read_byte_near(&p->factor_10x);
+		if (temperature <= t1) {
+			// linear between the points, rounded to nearest
+			int span = t1 - t0;
+			int scaled = 2 * (f1 - f0) * (temperature - t0);
+			return f0 + (scaled + (scaled < 0 ? -span : span)) / (2 * span);
+		}
+		t0 = t1;
+		f0 = f1;
+	}
+	return f0;
+#else
 	if (temperature <= -10) {
 		return 170;
 	} else if (temperature <= -5) {
@@ -364,6 +466,7 @@ int EPD_Class::temperature_to_factor_10x(int temperature) {
 		return 10;
 	}
 	return 7;
+#endif
 }
 
 
@@ -375,188 +478,308 @@ int EPD_Class::temperature_to_factor_10x(int temperature) {
 // the image is arranged by line which matches the display size
 // so smallest would have 96 * 32 bytes
 
+// the frame_* and frame_*_repeat calls are wrappers around the
+// frame() and frame_repeat() templates with the matching line source
+
 void EPD_Class::frame_fixed(uint8_t fixed_value, EPD_stage stage, uint16_t first_line_no, uint8_t line_count) {
-    if(line_count == 0)
-    {
-        line_count = this->lines_per_display;
-    }
-	for (uint8_t line = first_line_no; line < line_count + first_line_no ; ++line) {
-		this->line(line, 0, fixed_value, false, stage);
-	}
+	EPD_fixed_source source(fixed_value);
+	this->frame(source, stage, first_line_no, line_count);
 }
 
-//Currently only works with normal data and when subsampled by 2 (both vert. and hor.)
+
 void EPD_Class::frame_data(PROGMEM const uint8_t *image, EPD_stage stage,
                            uint16_t first_line_no, uint8_t line_count,
-                           boolean subsampled_by_2){
-    uint8_t subsample_factor = 1;
-    if(line_count == 0)
-    {
-        line_count = this->lines_per_display;
-    }
-    if( subsampled_by_2 )
-    {
-        subsample_factor = 2;
-    }
-
-    boolean line_in_progmem = true;
-    if(subsample_factor > 1)
-    {
-        //If using the subsampled version we need to create a line in SRAM (on the stack).
-        line_in_progmem = false;
-    }
-    
-    if(subsample_factor > 2)
-    {
-        //Give up and just have the subsample data drawn directly (will read garbage by the end of the frame......)
-        //TODO: Make this safer....
-        line_in_progmem = true;
-    }
-  
-	for (uint8_t line = first_line_no; line < line_count + first_line_no ; ++line)
-	{
-	    if(line_in_progmem)
-	    {
-	        const uint8_t *image_temp = &image[(line - first_line_no) * this->bytes_per_line];
-    		this->line(line, image_temp, 0, line_in_progmem, stage);
-		}
-		else
-		{
-            uint8_t image_sram_temp[this->bytes_per_line];
-            //The downsample-by-2 source is 16.5 bytes wide --> 17 bytes with padding
-            uint8_t source_bytes_per_line = 17; //Hardcoded to only work with subsample of 2
-
-            //TODO: Need to swap this logic around to do a read and expand per byte in the destination to support subsample by 4 (or add lots more conditions )
-            for (uint16_t b = 0; b < source_bytes_per_line; ++b)
-          	{
-				byte pixels = pgm_read_byte_near(  &image[(line - first_line_no)/subsample_factor * source_bytes_per_line + b] );
-				
-				byte pixels_left  = (pixels & 0b0001)<<0 | (pixels & 0b0001)<<1 ;
-				     pixels_left |= (pixels & 0b0010)<<1 | (pixels & 0b0010)<<2 ;
-				     pixels_left |= (pixels & 0b0100)<<2 | (pixels & 0b0100)<<3 ;
-				     pixels_left |= (pixels & 0b1000)<<3 | (pixels & 0b1000)<<4 ;
-				
-    			byte pixels_right  = (pixels & 0b00010000)>>4<<0 | (pixels & 0b00010000)>>4<<1 ;
-				     pixels_right |= (pixels & 0b00100000)>>4<<1 | (pixels & 0b00100000)>>4<<2 ;
-				     pixels_right |= (pixels & 0b01000000)>>4<<2 | (pixels & 0b01000000)>>4<<3 ;
-				     pixels_right |= (pixels & 0b10000000)>>4<<3 | (pixels & 0b10000000)>>4<<4 ;
-				
-				
-				image_sram_temp[subsample_factor*b] = pixels_left;
-				if((subsample_factor*b+1) < this->bytes_per_line)
-				{
-                    image_sram_temp[subsample_factor*b+1] = pixels_right;
-                }
-			}
-    		this->line(line, image_sram_temp, 0, line_in_progmem, stage);
-		}
+                           boolean subsampled_by_2) {
+	if (subsampled_by_2) {
+		EPD_scaled_source source(image, 2, 2);
+		this->frame(source, stage, first_line_no, line_count);
+	} else {
+		EPD_progmem_source source(image);
+		this->frame(source, stage, first_line_no, line_count);
 	}
 }
 
 
 #if defined(EPD_ENABLE_EXTRA_SRAM)
-void EPD_Class::frame_sram(const uint8_t *image, EPD_stage stage, uint16_t first_line_no, uint8_t line_count){
-    if(line_count == 0)
-    {
-        line_count = this->lines_per_display;
-    }
-	for (uint8_t line = first_line_no; line < line_count + first_line_no ; ++line) {
-		this->line(line, &image[(line - first_line_no) * this->bytes_per_line], 0, false, stage);
-	}
+void EPD_Class::frame_sram(const uint8_t *image, EPD_stage stage, uint16_t first_line_no, uint8_t line_count) {
+	EPD_sram_source source(image);
+	this->frame(source, stage, first_line_no, line_count);
 }
 #endif
 
 
 void EPD_Class::frame_cb(uint32_t address, EPD_reader *reader, EPD_stage stage, uint16_t first_line_no, uint8_t line_count) {
-	static uint8_t buffer[264 / 8];
-    if(line_count == 0)
-    {
-        line_count = this->lines_per_display;
-    }
-	for (uint8_t line = first_line_no; line < line_count + first_line_no ; ++line) {
-		reader(buffer, address + (line - first_line_no) * this->bytes_per_line, this->bytes_per_line);
-		this->line(line, buffer, 0, false, stage);
-	}
+	EPD_reader_source source(address, reader);
+	this->frame(source, stage, first_line_no, line_count);
 }
 
-//TODO: Refactor these functions into one piece of code....
+
 void EPD_Class::frame_fixed_repeat(uint8_t fixed_value, EPD_stage stage, uint16_t first_line_no, uint8_t line_count) {
-    //If we are only doing a sub-part of the screen then reduce staging time accordingly.
-    //BK: Check if this is actually correct to do...... (we will be executing the same number of SPI writes overall)
-    // So is it important for time? or number of times we write to the display......
-    long stage_time = ((((long)this->factored_stage_time) * line_count) / this->lines_per_display);
-	do {
-		unsigned long t_start = millis();
-		this->frame_fixed(fixed_value, stage, first_line_no, line_count);
-		unsigned long t_end = millis();
-		if (t_end > t_start) {
-			stage_time -= t_end - t_start;
-		} else {
-			stage_time -= t_start - t_end + 1 + ULONG_MAX;
-		}
-	} while (stage_time > 0);
+	EPD_fixed_source source(fixed_value);
+	this->frame_repeat(source, stage, first_line_no, line_count);
 }
 
 
-void EPD_Class::frame_data_repeat(PROGMEM const uint8_t *image, EPD_stage stage, uint16_t first_line_no, uint8_t line_count, uint8_t subsample_factor) {
-    //If we are only doing a sub-part of the screen then reduce staging time accordingly.
-    //BK: Check if this is actually correct to do...... (we will be executing the same number of SPI writes overall)
-    // So is it important for time? or number of times we write to the display......
-    long stage_time = ((((long)this->factored_stage_time) * line_count) / this->lines_per_display);
-	do {
-		unsigned long t_start = millis();
-		this->frame_data(image, stage, first_line_no, line_count, subsample_factor);
-		unsigned long t_end = millis();
-		if (t_end > t_start) {
-			stage_time -= t_end - t_start;
-		} else {
-			stage_time -= t_start - t_end + 1 + ULONG_MAX;
-		}
-	} while (stage_time > 0);
+void EPD_Class::frame_data_repeat(PROGMEM const uint8_t *image, EPD_stage stage, uint16_t first_line_no, uint8_t line_count, boolean subsampled_by_2) {
+	if (subsampled_by_2) {
+		EPD_scaled_source source(image, 2, 2);
+		this->frame_repeat(source, stage, first_line_no, line_count);
+	} else {
+		EPD_progmem_source source(image);
+		this->frame_repeat(source, stage, first_line_no, line_count);
+	}
 }
 
 
 #if defined(EPD_ENABLE_EXTRA_SRAM)
 void EPD_Class::frame_sram_repeat(const uint8_t *image, EPD_stage stage, uint16_t first_line_no, uint8_t line_count) {
-    //If we are only doing a sub-part of the screen then reduce staging time accordingly.
-    //BK: Check if this is actually correct to do...... (we will be executing the same number of SPI writes overall)
-    // So is it important for time? or number of times we write to the display......
-    long stage_time = ((((long)this->factored_stage_time) * line_count) / this->lines_per_display);
-
-	do {
-		unsigned long t_start = millis();
-		this->frame_sram(image, stage, first_line_no, line_count);
-		unsigned long t_end = millis();
-		if (t_end > t_start) {
-			stage_time -= t_end - t_start;
-		} else {
-			stage_time -= t_start - t_end + 1 + ULONG_MAX;
-		}
-	} while (stage_time > 0);
+	EPD_sram_source source(image);
+	this->frame_repeat(source, stage, first_line_no, line_count);
 }
 #endif
 
 
 void EPD_Class::frame_cb_repeat(uint32_t address, EPD_reader *reader, EPD_stage stage, uint16_t first_line_no, uint8_t line_count) {
-    //If we are only doing a sub-part of the screen then reduce staging time accordingly.
-    //BK: Check if this is actually correct to do...... (we will be executing the same number of SPI writes overall)
-    // So is it important for time? or number of times we write to the display......
-    long stage_time = ((((long)this->factored_stage_time) * line_count) / this->lines_per_display);
-	do {
-		unsigned long t_start = millis();
-		this->frame_cb(address, reader, stage, first_line_no, line_count);
-		unsigned long t_end = millis();
-		if (t_end > t_start) {
-			stage_time -= t_end - t_start;
+	EPD_reader_source source(address, reader);
+	this->frame_repeat(source, stage, first_line_no, line_count);
+}
+
+
+// pixels of one nibble (bit 0 is the leftmost) each repeated 2, 3 or 4 times
+static PROGMEM const uint16_t EPD_expand_nibble[3][16] = {
+	{ // x2
+		0x0000, 0x0003, 0x000c, 0x000f, 0x0030, 0x0033, 0x003c, 0x003f,
+		0x00c0, 0x00c3, 0x00cc, 0x00cf, 0x00f0, 0x00f3, 0x00fc, 0x00ff,
+	},
+	{ // x3
+		0x0000, 0x0007, 0x0038, 0x003f, 0x01c0, 0x01c7, 0x01f8, 0x01ff,
+		0x0e00, 0x0e07, 0x0e38, 0x0e3f, 0x0fc0, 0x0fc7, 0x0ff8, 0x0fff,
+	},
+	{ // x4
+		0x0000, 0x000f, 0x00f0, 0x00ff, 0x0f00, 0x0f0f, 0x0ff0, 0x0fff,
+		0xf000, 0xf00f, 0xf0f0, 0xf0ff, 0xff00, 0xff0f, 0xfff0, 0xffff,
+	},
+};
+
+
+// widen one source line into buffer, a nibble at a time through EPD_expand_nibble
+void EPD_scaled_source::expand(const uint8_t *source, bool read_progmem, uint16_t bytes_per_line) {
+	if (this->h_scale <= 1) {
+		for (uint16_t b = 0; b < bytes_per_line; ++b) {
+			this->buffer[b] = read_progmem ? pgm_read_byte_near(&source[b]) : source[b];
+		}
+		return;
+	}
+
+	const uint16_t *table = EPD_expand_nibble[this->h_scale - 2];
+	const uint8_t nibble_bits = 4 * this->h_scale;
+	uint32_t bits = 0;      // expanded pixels not yet stored, next pixel in bit 0
+	uint8_t bit_count = 0;
+	uint16_t b = 0;
+
+	for (const uint8_t *s = source; b < bytes_per_line; ++s) {
+		uint8_t pixels = read_progmem ? pgm_read_byte_near(s) : *s;
+		bits |= (uint32_t)pgm_read_word_near(&table[pixels & 0x0f]) << bit_count;
+		bits |= (uint32_t)pgm_read_word_near(&table[pixels >> 4]) << (bit_count + nibble_bits);
+		bit_count += 2 * nibble_bits;
+		for (; (bit_count >= 8) && (b < bytes_per_line); bit_count -= 8, bits >>= 8) {
+			this->buffer[b++] = bits;
+		}
+	}
+}
+
+
+// scale up one line
+const uint8_t *EPD_scaled_source::data(uint16_t index, uint16_t bytes_per_line) {
+	uint16_t line = index / this->v_scale;
+	if (line == this->line) {
+		return this->buffer;  // vertical repeat of the last line
+	}
+	this->line = line;
+
+	// source bytes that cover the panel width
+	uint16_t needed = (bytes_per_line * 8 / this->h_scale + 7) / 8;
+	uint16_t stride = this->source_bytes_per_line;
+	if (0 == stride) {
+		stride = needed;
+	}
+
+	if (0 != this->reader) {
+		// read into the end of buffer, expanding works forwards so never overwrites unread bytes
+		// (output byte b only needs source bytes up to b / h_scale)
+		uint8_t *input = &this->buffer[bytes_per_line - needed];
+		this->reader(input, this->address + (uint32_t)line * stride, needed);
+		this->expand(input, false, bytes_per_line);
+	} else {
+		this->expand(&this->image[(uint32_t)line * stride], this->read_progmem, bytes_per_line);
+	}
+	return this->buffer;
+}
+
+
+#if defined(EPD_PACKBITS_SUPPORT)
+void EPD_packbits_source::rewind() {
+	this->offset = 0;
+	this->line = 0;
+	this->count = 0;
+	this->repeat = false;
+	this->input_index = sizeof(this->input);
+}
+
+
+uint8_t EPD_packbits_source::next_byte() {
+	if (0 == this->reader) {
+		const uint8_t *p = &this->image[this->offset++];
+		return this->read_progmem ? pgm_read_byte_near(p) : *p;
+	}
+	// read the compressed data in small blocks rather than a byte per callback
+	if (this->input_index >= sizeof(this->input)) {
+		this->reader(this->input, this->address + this->offset, sizeof(this->input));
+		this->offset += sizeof(this->input);
+		this->input_index = 0;
+	}
+	return this->input[this->input_index++];
+}
+
+
+void EPD_packbits_source::decode_line(uint16_t bytes_per_line) {
+	for (uint16_t b = 0; b < bytes_per_line; ) {
+		if (0 == this->count) {
+			uint8_t n = this->next_byte();
+			if (n < 128) {
+				this->repeat = false;
+				this->count = n + 1;
+			} else if (n > 128) {
+				this->repeat = true;
+				this->count = 257 - n;
+				this->value = this->next_byte();
+			}
+			continue;
+		}
+		uint8_t k = this->count;
+		if (k > bytes_per_line - b) {
+			k = bytes_per_line - b;
+		}
+		if (this->repeat) {
+			memset(&this->buffer[b], this->value, k);
 		} else {
-			stage_time -= t_start - t_end + 1 + ULONG_MAX;
+			for (uint8_t i = 0; i < k; ++i) {
+				this->buffer[b + i] = this->next_byte();
+			}
+		}
+		this->count -= k;
+		b += k;
+	}
+	++this->line;
+}
+
+
+const uint8_t *EPD_packbits_source::data(uint16_t index, uint16_t bytes_per_line) {
+	uint16_t wanted = this->first_line + index;
+	if (wanted < this->line) {
+		this->rewind();
+	}
+	while (this->line <= wanted) {
+		this->decode_line(bytes_per_line);
+	}
+	return this->buffer;
+}
+#endif //defined(EPD_PACKBITS_SUPPORT)
+
+
+// assemble one complete line of COG data (0x72 header, border byte,
+// even pixels, scan bytes, odd pixels, filler) into buffer
+// returns the number of bytes to send
+uint16_t EPD_Class::encode_line(uint8_t *buffer, uint16_t line, const uint8_t *data, uint8_t fixed_value, bool read_progmem, EPD_stage stage) {
+	EPD_PROFILE_START(t_encode);
+	uint8_t *p = buffer;
+
+	*p++ = 0x72;
+
+	// border byte only necessary for 1.44" EPD
+	if (EPD_1_44 == this->size) {
+		*p++ = 0x00;
+	}
+
+	// even pixels
+	if (0 != data) {
+		for (uint16_t b = this->bytes_per_line; b > 0; --b) {
+			*p++ = encode_even_pixels(read_pixels(data + b - 1, read_progmem), stage);
 		}
-	} while (stage_time > 0);
+	} else {
+		memset(p, fixed_value, this->bytes_per_line);
+		p += this->bytes_per_line;
+	}
+
+	// scan line
+	EPD_PROFILE_START(t_scan);
+	memset(p, 0x00, this->bytes_per_scan);
+	if (line / 4 < this->bytes_per_scan) {
+		p[line / 4] = 0xc0 >> (2 * (line & 0x03));
+	}
+	p += this->bytes_per_scan;
+#if defined(EPD_PROFILE_SUPPORT)
+	unsigned long t_scan_end = micros();
+	this->profile_data.scan_us += t_scan_end - t_scan;
+#endif
+
+	// odd pixels
+	if (0 != data) {
+		for (uint16_t b = 0; b < this->bytes_per_line; ++b) {
+			*p++ = encode_odd_pixels(read_pixels(data + b, read_progmem), stage);
+		}
+	} else {
+		memset(p, fixed_value, this->bytes_per_line);
+		p += this->bytes_per_line;
+	}
+
+	if (this->filler) {
+		*p++ = 0x00;
+	}
+
+#if defined(EPD_PROFILE_SUPPORT)
+	// encode time is the whole line less the scan bytes
+	this->profile_data.encode_us += (micros() - t_encode) - (t_scan_end - t_scan);
+#endif
+	return p - buffer;
 }
 
 
 void EPD_Class::line(uint16_t line, const uint8_t *data, uint8_t fixed_value, bool read_progmem, EPD_stage stage) {
+	static uint8_t buffer[EPD_LINE_BUFFER_SIZE];
+
+	// encode before starting the transfer so the burst below is not
+	// slowed down by reading and converting the image
+	EPD_PROFILE_START(t_line);
+	uint16_t length = this->encode_line(buffer, line, data, fixed_value, read_progmem, stage);
+
+	EPD_PROFILE_START(t_start);
+	this->line_start();
+	EPD_PROFILE_ADD(preamble_us, t_start);
+
+	// the COG ignores input while BUSY is high so it is still checked
+	// after each byte, but via the port register not digitalRead()
+	EPD_PROFILE_START(t_transfer);
+#if defined(EPD_PROFILE_SUPPORT)
+	this->profile_data.busy_spins += SPI_send_wait(buffer, length, this->busy_port, this->busy_mask);
+#else
+	SPI_send_wait(buffer, length, this->busy_port, this->busy_mask);
+#endif
+	EPD_PROFILE_ADD(transfer_us, t_transfer);
+
+	EPD_PROFILE_START(t_finish);
+	this->line_finish();
+	EPD_PROFILE_ADD(preamble_us, t_finish);
+
+	EPD_PROFILE_ADD(line_us, t_line);
+#if defined(EPD_PROFILE_SUPPORT)
+	++this->profile_data.lines;
+#endif
+}
 
+
+// command preamble for line data, leaves CS low ready for the data bytes
+void EPD_Class::line_start() {
 	SPI_on();
 
 	// charge pump voltage levels
@@ -572,134 +795,348 @@ void EPD_Class::line(uint16_t line, const uint8_t *data, uint8_t fixed_value, bo
 
 	// CS low
 	digitalWrite(this->EPD_Pin_EPD_CS, LOW);
-	SPI_put_wait(0x72, this->EPD_Pin_BUSY);
+}
 
-	// border byte only necessary for 1.44" EPD
-	if (EPD_1_44 == this->size) {
-		SPI_put_wait(0x00, this->EPD_Pin_BUSY);
-		//SPI_send(this->EPD_Pin_EPD_CS, CU8(0x00), 1);
+
+// end the line data and latch it to the panel
+void EPD_Class::line_finish() {
+	// CS high
+	digitalWrite(this->EPD_Pin_EPD_CS, HIGH);
+
+	// output data to panel
+	Delay_us(10);
+	SPI_send(this->EPD_Pin_EPD_CS, CU8(0x70, 0x02), 2);
+	Delay_us(10);
+	SPI_send(this->EPD_Pin_EPD_CS, CU8(0x72, 0x2f), 2);
+
+	// the bus stays set up for the next line, end() releases it
+}
+
+
+#if defined(EPD_PROFILE_SUPPORT)
+static void profile_print(const char *name, uint32_t value) {
+	Serial.print(name);
+	Serial.println(value);
+}
+
+void EPD_Class::profile_dump() {
+	const EPD_profile &p = this->profile_data;
+
+	profile_print("EPD lines:       ", p.lines);
+	profile_print("  preamble us:   ", p.preamble_us);
+	profile_print("  encode us:     ", p.encode_us);
+	profile_print("  scan us:       ", p.scan_us);
+	profile_print("  transfer us:   ", p.transfer_us);
+	profile_print("  busy spins:    ", p.busy_spins);
+	profile_print("  line us:       ", p.line_us);
+	profile_print("  loop us:       ", p.loop_us);
+	profile_print("  compensate x:  ", p.passes[EPD_compensate]);
+	profile_print("  white x:       ", p.passes[EPD_white]);
+	profile_print("  inverse x:     ", p.passes[EPD_inverse]);
+	profile_print("  normal x:      ", p.passes[EPD_normal]);
+}
+#endif //defined(EPD_PROFILE_SUPPORT)
+
+
+#if defined(EPD_ASYNC_SUPPORT)
+
+#if defined(__AVR__)
+#define EPD_SPI_INTERRUPT 1
+#define SPI_interrupt_on() (SPCR |= _BV(SPIE))
+#define SPI_interrupt_off() (SPCR &= ~_BV(SPIE))
+#define SPI_write(c) (SPDR = (c))
+#elif defined(EPD_SPI_INTERRUPT_MOCK)
+// host test build: the interrupt is simulated by the SPI mock
+#define EPD_SPI_INTERRUPT 1
+static void async_tx_next();
+#define SPI_interrupt_on() SPI_mock_interrupt(async_tx_next)
+#define SPI_interrupt_off() SPI_mock_interrupt(0)
+#define SPI_write(c) SPI_mock_write(c)
+#endif
+
+static volatile bool async_tx_active;
+static volatile uint8_t *async_busy_port;
+static uint8_t async_busy_mask;
+
+#if defined(EPD_SPI_INTERRUPT)
+// line data being sent by the SPI interrupt
+static volatile const uint8_t *async_tx;
+static volatile uint16_t async_tx_remaining;
+static volatile bool async_tx_waiting;  // stopped with BUSY high, poll() resumes
+#endif
+
+// two line buffers: one being sent while the next is encoded
+static uint8_t async_buffer[2][EPD_LINE_BUFFER_SIZE];
+
+
+#if defined(EPD_SPI_INTERRUPT)
+// send the next byte of the line, after the previous one has gone
+// never waits: if the COG is still busy the interrupt is turned off
+// and poll() calls this again once BUSY has dropped
+static void async_tx_next() {
+	if (0 != (*async_busy_port & async_busy_mask)) {
+		SPI_interrupt_off();
+		async_tx_waiting = true;
+	} else if (0 != async_tx_remaining) {
+		--async_tx_remaining;
+		SPI_write(*async_tx++);
+	} else {
+		SPI_interrupt_off();
+		async_tx_active = false;
 	}
+}
 
-	// even pixels
-	for (uint16_t b = this->bytes_per_line; b > 0; --b) {
-		if (0 != data) {
-#if defined(__MSP430_CPU__)
-			uint8_t pixels = data[b - 1] & 0xaa;
+#if defined(__AVR__)
+// SPI transfer complete
+ISR(SPI_STC_vect) {
+	async_tx_next();
+}
+#endif
+
+// continue a line stopped by BUSY
+static void async_resume() {
+	if (async_tx_waiting && 0 == (*async_busy_port & async_busy_mask)) {
+		async_tx_waiting = false;
+		SPI_interrupt_on();
+		async_tx_next();
+	}
+}
+#endif //defined(EPD_SPI_INTERRUPT)
+
+
+// start sending an encoded line, returns immediately if there is an SPI interrupt
+static void async_send(const uint8_t *buffer, uint16_t length) {
+#if defined(EPD_SPI_INTERRUPT)
+	async_tx = buffer;
+	async_tx_remaining = length;
+	async_tx_waiting = false;
+	async_tx_active = true;
+	SPI_interrupt_on();
+	async_tx_next();
 #else
-			// AVR has multiple memory spaces
-			uint8_t pixels;
-			if (read_progmem) {
-				pixels = pgm_read_byte_near(data + b - 1) & 0xaa;
-			} else {
-				pixels = data[b - 1] & 0xaa;
-			}
+	// no SPI interrupt available: send the whole line now
+	SPI_send_wait(buffer, length, async_busy_port, async_busy_mask);
+	async_tx_active = false;
 #endif
-			switch(stage) {
-			case EPD_compensate:  // B -> W, W -> B (Current Image)
-				pixels = 0xaa | ((pixels ^ 0xaa) >> 1);
-				break;
-			case EPD_white:       // B -> N, W -> W (Current Image)
-				pixels = 0x55 + ((pixels ^ 0xaa) >> 1);
-				break;
-			case EPD_inverse:     // B -> N, W -> B (New Image)
-				pixels = 0x55 | (pixels ^ 0xaa);
-				break;
-			case EPD_normal:       // B -> B, W -> W (New Image)
-				pixels = 0xaa | (pixels >> 1);
-				break;
-			}
-			SPI_put_wait(pixels, this->EPD_Pin_BUSY);
-		} else {
-			SPI_put_wait(fixed_value, this->EPD_Pin_BUSY);
-		}
+}
+
+
+// begin an update of up to four stages that runs from poll()
+void EPD_Class::start_async(const EPD_async_stage *stages, uint8_t stage_count,
+                            uint16_t first_line_no, uint8_t line_count,
+                            EPD_async_callback *complete) {
+	if (0 == line_count) {
+		line_count = this->lines_per_display;
 	}
+	if (stage_count > 4) {
+		stage_count = 4;
+	}
+	memcpy(this->async_stages, stages, stage_count * sizeof(EPD_async_stage));
+	this->async_stage_count = stage_count;
+	this->async_stage_index = 0;
+	this->async_first_line_no = first_line_no;
+	this->async_line_count = line_count;
+	this->async_line = 0;
+	this->async_complete = complete;
+	this->async_encoded = false;
+	this->async_in_flight = false;
+#if defined(EPD_STAGE_PASSES)
+	this->async_passes = this->stage_passes();
+	this->async_pass = 0;
+#else
+	this->async_stage_time = this->partial_stage_time(line_count);
+	this->async_stage_start = millis();
+#endif
+	async_busy_port = this->busy_port;
+	async_busy_mask = this->busy_mask;
+	this->async_active = 0 != stage_count;
+}
 
-	// scan line
-	for (uint16_t b = 0; b < this->bytes_per_scan; ++b) {
-		if (line / 4 == b) {
-			SPI_put_wait(0xc0 >> (2 * (line & 0x03)), this->EPD_Pin_BUSY);
-		} else {
-			SPI_put_wait(0x00, this->EPD_Pin_BUSY);
-		}
+
+// encode the next line of the current stage into the spare buffer
+void EPD_Class::async_encode() {
+	const EPD_async_stage *s = &this->async_stages[this->async_stage_index];
+	uint8_t *buffer = async_buffer[this->async_buffer_index];
+	uint16_t line = this->async_first_line_no + this->async_line;
+	uint32_t offset = (uint32_t)this->async_line * this->bytes_per_line;
+
+	if (0 != s->reader) {
+		static uint8_t data[264 / 8];
+		s->reader(data, s->address + offset, this->bytes_per_line);
+		this->async_length = this->encode_line(buffer, line, data, 0, false, s->stage);
+	} else if (0 != s->image) {
+		this->async_length = this->encode_line(buffer, line, s->image + offset, 0, s->read_progmem, s->stage);
+	} else {
+		this->async_length = this->encode_line(buffer, line, 0, s->fixed_value, false, s->stage);
 	}
+	this->async_encoded = true;
+}
 
-	// odd pixels
-	for (uint16_t b = 0; b < this->bytes_per_line; ++b) {
-		if (0 != data) {
-#if defined(__MSP430_CPU__)
-			uint8_t pixels = data[b] & 0x55;
+
+// move on to the line after the one just started: next line, next frame or next stage
+void EPD_Class::async_next_line() {
+	if (++this->async_line < this->async_line_count) {
+		return;
+	}
+	this->async_line = 0;
+#if defined(EPD_STAGE_PASSES)
+	if (++this->async_pass < this->async_passes) {
+		return;
+	}
+	this->async_pass = 0;
 #else
-			// AVR has multiple memory spaces
-			uint8_t pixels;
-			if (read_progmem) {
-				pixels = pgm_read_byte_near(data + b) & 0x55;
-			} else {
-				pixels = data[b] & 0x55;
-			}
+	if (millis() - this->async_stage_start < (unsigned long)this->async_stage_time) {
+		return;
+	}
+	this->async_stage_start = millis();
+#endif
+	++this->async_stage_index;
+}
+
+
+// advance the asynchronous update, call this as often as possible
+// returns true while the update is still running
+bool EPD_Class::poll() {
+	if (!this->async_active) {
+		return false;
+	}
+
+	if (this->async_in_flight) {
+		if (async_tx_active) {
+#if defined(EPD_SPI_INTERRUPT)
+			async_resume();
 #endif
-			switch(stage) {
-			case EPD_compensate:  // B -> W, W -> B (Current Image)
-				pixels = 0xaa | (pixels ^ 0x55);
-				break;
-			case EPD_white:       // B -> N, W -> W (Current Image)
-				pixels = 0x55 + (pixels ^ 0x55);
-				break;
-			case EPD_inverse:     // B -> N, W -> B (New Image)
-				pixels = 0x55 | ((pixels ^ 0x55) << 1);
-				break;
-			case EPD_normal:       // B -> B, W -> W (New Image)
-				pixels = 0xaa | pixels;
-				break;
+			// use the time while the line is sent to prepare the next one,
+			// except from a reader: the line holds the bus and the EPD chip
+			// select, so reader lines are fetched after line_finish()
+			if (!this->async_encoded && this->async_stage_index < this->async_stage_count
+			    && 0 == this->async_stages[this->async_stage_index].reader) {
+				this->async_encode();
 			}
-			uint8_t p1 = (pixels >> 6) & 0x03;
-			uint8_t p2 = (pixels >> 4) & 0x03;
-			uint8_t p3 = (pixels >> 2) & 0x03;
-			uint8_t p4 = (pixels >> 0) & 0x03;
-			pixels = (p1 << 0) | (p2 << 2) | (p3 << 4) | (p4 << 6);
-			SPI_put_wait(pixels, this->EPD_Pin_BUSY);
-		} else {
-			SPI_put_wait(fixed_value, this->EPD_Pin_BUSY);
+			return true;
+		}
+		this->line_finish();
+		this->async_in_flight = false;
+
+		if (this->async_stage_index >= this->async_stage_count) {
+			this->async_active = false;
+			if (0 != this->async_complete) {
+				this->async_complete();
+			}
+			return false;
 		}
 	}
 
-	if (this->filler) {
-		SPI_put_wait(0x00, this->EPD_Pin_BUSY);
+	if (!this->async_encoded) {
+		this->async_encode();
 	}
+	this->async_encoded = false;
+	uint8_t *buffer = async_buffer[this->async_buffer_index];
+	this->async_buffer_index ^= 1;
+
+	this->line_start();
+	this->async_in_flight = true;
+	async_send(buffer, this->async_length);
+	this->async_next_line();
+	return true;
+}
 
-	// CS high
-	digitalWrite(this->EPD_Pin_EPD_CS, HIGH);
+#endif //defined(EPD_ASYNC_SUPPORT)
 
-	// output data to panel
-	Delay_us(10);
-	SPI_send(this->EPD_Pin_EPD_CS, CU8(0x70, 0x02), 2);
-	Delay_us(10);
-	SPI_send(this->EPD_Pin_EPD_CS, CU8(0x72, 0x2f), 2);
 
-	SPI_off();
+// fetch one byte of image data
+static inline uint8_t read_pixels(const uint8_t *data, bool read_progmem) {
+#if defined(__MSP430_CPU__)
+	return *data;
+#else
+	// AVR has multiple memory spaces
+	if (read_progmem) {
+		return pgm_read_byte_near(data);
+	}
+	return *data;
+#endif
+}
+
+
+#if defined(EPD_STAGE_LOOKUP_TABLES)
+
+static inline uint8_t encode_even_pixels(uint8_t pixels, EPD_stage stage) {
+	return pgm_read_byte_near(&EPD_even_pixels[stage][pixels]);
 }
 
 
+static inline uint8_t encode_odd_pixels(uint8_t pixels, EPD_stage stage) {
+	return pgm_read_byte_near(&EPD_odd_pixels[stage][pixels]);
+}
+
+#else
+
+static inline uint8_t encode_even_pixels(uint8_t pixels, EPD_stage stage) {
+	pixels &= 0xaa;
+	switch(stage) {
+	case EPD_compensate:  // B -> W, W -> B (Current Image)
+		pixels = 0xaa | ((pixels ^ 0xaa) >> 1);
+		break;
+	case EPD_white:       // B -> N, W -> W (Current Image)
+		pixels = 0x55 + ((pixels ^ 0xaa) >> 1);
+		break;
+	case EPD_inverse:     // B -> N, W -> B (New Image)
+		pixels = 0x55 | (pixels ^ 0xaa);
+		break;
+	case EPD_normal:       // B -> B, W -> W (New Image)
+		pixels = 0xaa | (pixels >> 1);
+		break;
+	}
+	return pixels;
+}
+
+
+static inline uint8_t encode_odd_pixels(uint8_t pixels, EPD_stage stage) {
+	pixels &= 0x55;
+	switch(stage) {
+	case EPD_compensate:  // B -> W, W -> B (Current Image)
+		pixels = 0xaa | (pixels ^ 0x55);
+		break;
+	case EPD_white:       // B -> N, W -> W (Current Image)
+		pixels = 0x55 + (pixels ^ 0x55);
+		break;
+	case EPD_inverse:     // B -> N, W -> B (New Image)
+		pixels = 0x55 | ((pixels ^ 0x55) << 1);
+		break;
+	case EPD_normal:       // B -> B, W -> W (New Image)
+		pixels = 0xaa | pixels;
+		break;
+	}
+	uint8_t p1 = (pixels >> 6) & 0x03;
+	uint8_t p2 = (pixels >> 4) & 0x03;
+	uint8_t p3 = (pixels >> 2) & 0x03;
+	uint8_t p4 = (pixels >> 0) & 0x03;
+	return (p1 << 0) | (p2 << 2) | (p3 << 4) | (p4 << 6);
+}
+
+#endif //defined(EPD_STAGE_LOOKUP_TABLES)
+
+
+// EPD settings on the shared bus
+static const SPI_BUS_device EPD_spi = {MSBFIRST, SPI_MODE2, SPI_CLOCK_DIV2, -1, LOW};
+
 static void SPI_on() {
-	SPI.end();
-	SPI.begin();
-	SPI.setBitOrder(MSBFIRST);
-	SPI.setDataMode(SPI_MODE2);
-	SPI.setClockDivider(SPI_CLOCK_DIV2);
-	SPI_put(0x00);
-	SPI_put(0x00);
-	Delay_us(10);
+	// only reprogrammed (and flushed) if another device used the bus since the last line
+	if (SPI_BUS.acquire(&EPD_spi)) {
+		SPI_put(0x00);
+		SPI_put(0x00);
+		Delay_us(10);
+	}
 }
 
 
+// leave MOSI and CLOCK low and give up the bus (power up/down sequences)
 static void SPI_off() {
-	// SPI.begin();
-	// SPI.setBitOrder(MSBFIRST);
 	SPI.setDataMode(SPI_MODE0);
-	// SPI.setClockDivider(SPI_CLOCK_DIV2);
 	SPI_put(0x00);
 	SPI_put(0x00);
 	Delay_us(10);
-	SPI.end();
+	SPI_BUS.release();
 }
 
 
@@ -708,13 +1145,20 @@ static void SPI_put(uint8_t c) {
 }
 
 
-static void SPI_put_wait(uint8_t c, int busy_pin) {
-
-	SPI_put(c);
+// send a block of data with the caller managing CS
+// waiting for COG ready after every byte
+// returns the number of BUSY polls that found the COG not ready
+static uint32_t SPI_send_wait(const uint8_t *buffer, uint16_t length, volatile uint8_t *busy_port, uint8_t busy_mask) {
+	uint32_t spins = 0;
+	while (0 != length--) {
+		SPI_put(*buffer++);
 
-	// wait for COG ready
-	while (HIGH == digitalRead(busy_pin)) {
+		// wait for COG ready
+		while (0 != (*busy_port & busy_mask)) {
+			++spins;
+		}
 	}
+	return spins;
 }
 
 
@@ -28,8 +28,22 @@
 
 #define EPD_PROGMEM_IMAGE_SUPPORT //!<Support reading image buffers from PROGMEM (flash).
 
+#define EPD_PACKBITS_SUPPORT //!< Support PackBits compressed images (see convert_xbm_to_packbits.py) decoded a line at a time.
+
 #define EPD_OLD_IMAGE_SUPPORT //!< Support old image buffer for compensating. This is the normal mode for this library (the partial screen option does not use it -- so you probably want to disable this to save progmem if you are using partial).
 
+//#define EPD_ASYNC_SUPPORT //!< Support updates that run from poll() instead of blocking for the whole stage time. On AVR the line data is sent from the SPI interrupt (this defines SPI_STC_vect and uses 2 extra line buffers of SRAM).
+
+#define EPD_FACTOR_INTERPOLATION //!< Interpolate the temperature compensation factor linearly between the points of a table (per panel size, see setFactorTable()) so the stage time changes gradually instead of jumping by up to 2x at a datasheet band edge. Comment out for the original step function.
+
+#define EPD_STAGE_PASSES //!< Drive each stage for a fixed number of passes per panel size scaled by the temperature factor, the same for full and partial updates and whatever the speed of the CPU or image source. Comment out to go back to repeating frames until the (line count scaled) stage time is used up.
+
+//#define EPD_PROFILE_SUPPORT //!< Accumulate micros() spent in each phase of an update (see EPD_profile). Adds a few micros() calls per line so leave off for normal use.
+
+#if !defined(__MSP430_CPU__)
+#define EPD_STAGE_LOOKUP_TABLES //!< Encode line pixels with precomputed per-stage tables (2048 bytes of PROGMEM). Disable to fall back to the smaller (slower) switch(stage) encoder.
+#endif
+
 // If more SRAM available (8 kBytes)
 #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega_2560__)
 #define EPD_ENABLE_EXTRA_SRAM 1
@@ -37,6 +51,14 @@
 #define EPD_ENABLE_EXTRA_SRAM 1
 #endif
 
+#if defined(EPD_FACTOR_INTERPOLATION)
+// one point of a temperature compensation table (in PROGMEM, rising temperatures)
+typedef struct {
+	int8_t temperature;  // Celsius
+	uint8_t factor_10x;  // stage time multiplier * 10
+} EPD_factor_point;
+#endif
+
 typedef enum {
 	EPD_1_44,        // 128 x 96
 	EPD_2_0,         // 200 x 96
@@ -52,6 +74,246 @@ typedef enum {           // Image pixel -> Display pixel
 
 typedef void EPD_reader(void *buffer, uint32_t address, uint16_t length);
 
+// Line sources for EPD_Class::frame() and EPD_Class::frame_repeat()
+// =================================================================
+// A source hands out one line of image data at a time:
+//   const uint8_t *data(uint16_t index, uint16_t bytes_per_line)
+//     index is relative to first_line_no, return 0 to send fixed_value
+//   uint8_t fixed_value()
+//   bool progmem()   true if data() points into PROGMEM
+// The frame templates are instantiated per source type, so there is no
+// virtual call per line.
+
+// every line is fixed_value
+class EPD_fixed_source {
+private:
+	uint8_t value;
+public:
+	EPD_fixed_source(uint8_t fixed_value) : value(fixed_value) {}
+	const uint8_t *data(uint16_t /*index*/, uint16_t /*bytes_per_line*/) {
+		return 0;
+	}
+	uint8_t fixed_value() {
+		return this->value;
+	}
+	bool progmem() {
+		return false;
+	}
+};
+
+// full size image in PROGMEM
+class EPD_progmem_source {
+private:
+	PROGMEM const uint8_t *image;
+public:
+	EPD_progmem_source(PROGMEM const uint8_t *image) : image(image) {}
+	const uint8_t *data(uint16_t index, uint16_t bytes_per_line) {
+		return &this->image[index * bytes_per_line];
+	}
+	uint8_t fixed_value() {
+		return 0;
+	}
+	bool progmem() {
+		return true;
+	}
+};
+
+// full size image (or segment) in SRAM
+class EPD_sram_source {
+private:
+	const uint8_t *image;
+public:
+	EPD_sram_source(const uint8_t *image) : image(image) {}
+	const uint8_t *data(uint16_t index, uint16_t bytes_per_line) {
+		return &this->image[index * bytes_per_line];
+	}
+	uint8_t fixed_value() {
+		return 0;
+	}
+	bool progmem() {
+		return false;
+	}
+};
+
+// image read a line at a time through a callback (e.g. SPI FLASH)
+class EPD_reader_source {
+private:
+	uint32_t address;
+	EPD_reader *reader;
+	uint8_t buffer[264 / 8];
+public:
+	EPD_reader_source(uint32_t address, EPD_reader *reader) : address(address), reader(reader) {}
+	const uint8_t *data(uint16_t index, uint16_t bytes_per_line) {
+		this->reader(this->buffer, this->address + (uint32_t)index * bytes_per_line, bytes_per_line);
+		return this->buffer;
+	}
+	uint8_t fixed_value() {
+		return 0;
+	}
+	bool progmem() {
+		return false;
+	}
+};
+
+// image read through a callback, keeping as many lines as fit in a
+// caller supplied cache (one line up to the whole segment)
+// cached lines are read once and then served from SRAM on every later
+// pass, and on later stages if the same source object is reused for
+// the same image (e.g. EPD_inverse then EPD_normal)
+// lines that do not fit are read through the callback every time
+class EPD_cached_reader_source {
+private:
+	uint32_t address;
+	EPD_reader *reader;
+	uint8_t *cache;
+	uint16_t cache_size;
+	uint16_t cached_lines;  // lines [0, cached_lines) are valid
+	uint8_t buffer[264 / 8];
+public:
+	EPD_cached_reader_source(uint32_t address, EPD_reader *reader, void *cache, uint16_t cache_size) :
+		address(address), reader(reader), cache((uint8_t *)cache), cache_size(cache_size), cached_lines(0) {}
+
+	// switch to a different image (discards the cached lines)
+	void set_address(uint32_t address) {
+		this->address = address;
+		this->cached_lines = 0;
+	}
+	const uint8_t *data(uint16_t index, uint16_t bytes_per_line) {
+		uint32_t offset = (uint32_t)index * bytes_per_line;
+		if (offset + bytes_per_line <= this->cache_size) {
+			if (index < this->cached_lines) {
+				return &this->cache[offset];
+			} else if (index == this->cached_lines) {
+				this->reader(&this->cache[offset], this->address + offset, bytes_per_line);
+				++this->cached_lines;
+				return &this->cache[offset];
+			}
+		}
+		this->reader(this->buffer, this->address + offset, bytes_per_line);
+		return this->buffer;
+	}
+	uint8_t fixed_value() {
+		return 0;
+	}
+	bool progmem() {
+		return false;
+	}
+};
+
+// low resolution image scaled up by h_scale (1..4) horizontally and v_scale vertically
+// source_bytes_per_line is the stride of the stored image, 0 means just wide enough for
+// the panel ((panel width / h_scale) rounded up to bytes, e.g. 17 for a half size 2.7" image).
+// Each source line is read (and expanded) once for its v_scale output lines.
+class EPD_scaled_source {
+private:
+	const uint8_t *image;   // PROGMEM or SRAM, used if reader is 0
+	bool read_progmem;
+	EPD_reader *reader;
+	uint32_t address;
+	uint8_t h_scale;
+	uint8_t v_scale;
+	uint16_t source_bytes_per_line;
+	uint16_t line;          // source line now in buffer
+	uint8_t buffer[264 / 8];
+
+	void expand(const uint8_t *source, bool read_progmem, uint16_t bytes_per_line);
+
+public:
+	EPD_scaled_source(PROGMEM const uint8_t *image, uint8_t h_scale, uint8_t v_scale,
+	                  bool read_progmem = true, uint16_t source_bytes_per_line = 0) :
+		image(image), read_progmem(read_progmem), reader(0), address(0),
+		h_scale(h_scale), v_scale(v_scale), source_bytes_per_line(source_bytes_per_line), line(0xffff) {}
+	EPD_scaled_source(uint32_t address, EPD_reader *reader, uint8_t h_scale, uint8_t v_scale,
+	                  uint16_t source_bytes_per_line = 0) :
+		image(0), read_progmem(false), reader(reader), address(address),
+		h_scale(h_scale), v_scale(v_scale), source_bytes_per_line(source_bytes_per_line), line(0xffff) {}
+	const uint8_t *data(uint16_t index, uint16_t bytes_per_line);
+	uint8_t fixed_value() {
+		return 0;
+	}
+	bool progmem() {
+		return false;
+	}
+};
+
+#if defined(EPD_PACKBITS_SUPPORT)
+// PackBits compressed image decoded a line at a time
+// (n = 0..127: n + 1 literal bytes follow, n = 129..255: the next byte is repeated 257 - n times, 128: ignored)
+// The stream is only read forwards so asking for an earlier line (e.g. the next frame) starts again from the beginning.
+// first_line is the line of the image returned for index 0 (for partial updates).
+class EPD_packbits_source {
+private:
+	const uint8_t *image;   // PROGMEM or SRAM, used if reader is 0
+	bool read_progmem;
+	EPD_reader *reader;
+	uint32_t address;
+	uint16_t first_line;
+
+	uint32_t offset;        // next compressed byte
+	uint16_t line;          // next line the decoder will produce
+	uint8_t count;          // bytes left in the current run
+	bool repeat;            // current run repeats value
+	uint8_t value;
+	uint8_t input[16];      // reader read ahead
+	uint8_t input_index;
+	uint8_t buffer[264 / 8];
+
+	uint8_t next_byte();
+	void rewind();
+	void decode_line(uint16_t bytes_per_line);
+
+public:
+	EPD_packbits_source(PROGMEM const uint8_t *image, bool read_progmem = true, uint16_t first_line = 0) :
+		image(image), read_progmem(read_progmem), reader(0), address(0), first_line(first_line) {
+		this->rewind();
+	}
+	EPD_packbits_source(uint32_t address, EPD_reader *reader, uint16_t first_line = 0) :
+		image(0), read_progmem(false), reader(reader), address(address), first_line(first_line) {
+		this->rewind();
+	}
+	const uint8_t *data(uint16_t index, uint16_t bytes_per_line);
+	uint8_t fixed_value() {
+		return 0;
+	}
+	bool progmem() {
+		return false;
+	}
+};
+#endif //defined(EPD_PACKBITS_SUPPORT)
+
+
+#if defined(EPD_ASYNC_SUPPORT)
+typedef void EPD_async_callback(void);
+
+// one stage of an asynchronous update
+// image data comes from reader (if set), else image (if set), else fixed_value
+// a reader is only called between lines, so it may use the SPI bus (e.g. FLASH.read)
+typedef struct {
+	EPD_stage stage;
+	uint8_t fixed_value;
+	const uint8_t *image;
+	bool read_progmem;
+	EPD_reader *reader;
+	uint32_t address;
+} EPD_async_stage;
+#endif //defined(EPD_ASYNC_SUPPORT)
+
+#if defined(EPD_PROFILE_SUPPORT)
+// time spent in each phase since the last profile_reset()
+// NOTE: micros() only has a 4us resolution on a 16MHz AVR, the totals over many lines are what count
+typedef struct {
+	uint32_t preamble_us;    // line_start()/line_finish(): command bytes and their delays
+	uint32_t encode_us;      // encoding the pixel bytes of each line
+	uint32_t scan_us;        // the scan bytes of each line
+	uint32_t transfer_us;    // sending the line data, including the BUSY waits
+	uint32_t busy_spins;     // times BUSY was still high after a data byte
+	uint32_t line_us;        // all of line()
+	uint32_t loop_us;        // frame_repeat() time outside line()
+	uint32_t lines;          // lines sent
+	uint16_t passes[4];      // frames sent for each EPD_stage
+} EPD_profile;
+#endif //defined(EPD_PROFILE_SUPPORT)
+
 class EPD_Class {
 private:
 	uint8_t EPD_Pin_EPD_CS;
@@ -65,6 +327,10 @@ private:
 	EPD_size size;
 	uint16_t stage_time;
 	uint16_t factored_stage_time;
+#if defined(EPD_FACTOR_INTERPOLATION)
+	PROGMEM const EPD_factor_point *factor_table;
+	uint8_t factor_table_length;
+#endif
 	uint16_t lines_per_display;
 	uint16_t dots_per_line;
 	uint16_t bytes_per_line;
@@ -76,16 +342,100 @@ private:
 
 	bool filler;
 
+	volatile uint8_t *busy_port;
+	uint8_t busy_mask;
+
 	EPD_Class(const EPD_Class &f);  // prevent copy
 
+	// assemble a complete line of COG data, returns its length
+	uint16_t encode_line(uint8_t *buffer, uint16_t line_no, const uint8_t *data, uint8_t fixed_value, bool read_progmem, EPD_stage stage);
+
+	// If we are only doing a sub-part of the screen then reduce staging time accordingly.
+	//BK: Check if this is actually correct to do...... (we will be executing the same number of SPI writes overall)
+	// So is it important for time? or number of times we write to the display......
+	long partial_stage_time(uint8_t line_count) {
+		return ((long)this->factored_stage_time * line_count) / this->lines_per_display;
+	}
+
+#if defined(EPD_STAGE_PASSES)
+	// passes of a full frame that fit in stage_time at the nominal line rate (factor 1.0)
+	uint16_t stage_passes_1x;
+	// the same scaled by the temperature factor (see setFactor)
+	uint16_t factored_stage_passes;
+
+	// Every line of a partial update gets the same number of passes, so each line receives the
+	// same drive whatever the segment size, and nothing depends on how fast lines are produced:
+	// a slow source stretches the stage rather than cutting it short.
+	uint16_t stage_passes() {
+		return this->factored_stage_passes;
+	}
+#endif //defined(EPD_STAGE_PASSES)
+
+	// the parts of line() either side of the data bytes
+	void line_start();
+	void line_finish();
+
+#if defined(EPD_PROFILE_SUPPORT)
+	EPD_profile profile_data;
+#endif //defined(EPD_PROFILE_SUPPORT)
+
+	// state of a stage scheduled by the caller (stage_start/stage_pass)
+	uint16_t stage_pass_count;
+#if defined(EPD_STAGE_PASSES)
+	uint16_t stage_pass_target;
+#else
+	unsigned long stage_line_us;  // time spent sending lines since stage_start()
+#endif
+
+#if defined(EPD_ASYNC_SUPPORT)
+	EPD_async_stage async_stages[4];
+	uint8_t async_stage_count;
+	uint8_t async_stage_index;
+	uint16_t async_first_line_no;
+	uint8_t async_line_count;
+	uint8_t async_line;
+#if defined(EPD_STAGE_PASSES)
+	uint16_t async_passes;
+	uint16_t async_pass;
+#else
+	long async_stage_time;
+	unsigned long async_stage_start;
+#endif
+	EPD_async_callback *async_complete;
+	uint16_t async_length;
+	uint8_t async_buffer_index;
+	bool async_encoded;
+	bool async_in_flight;
+	bool async_active;
+
+	void async_encode();
+	void async_next_line();
+#endif //defined(EPD_ASYNC_SUPPORT)
+
 public:
 	// power up and power down the EPD panel
 	void begin();
 	void end();
 
 	void setFactor(int temperature = 25) {
-		this->factored_stage_time = this->stage_time * this->temperature_to_factor_10x(temperature) / 10;
+		int factor_10x = this->temperature_to_factor_10x(temperature);
+		this->factored_stage_time = (uint32_t)this->stage_time * factor_10x / 10;
+#if defined(EPD_STAGE_PASSES)
+		this->factored_stage_passes = ((uint32_t)this->stage_passes_1x * factor_10x + 9) / 10;
+		if (0 == this->factored_stage_passes) {
+			this->factored_stage_passes = 1;
+		}
+#endif
+	}
+
+#if defined(EPD_FACTOR_INTERPOLATION)
+	// replace the temperature compensation table for this panel
+	// (e.g. from the COG document of a different film), takes effect on the next setFactor()
+	void setFactorTable(PROGMEM const EPD_factor_point *table, uint8_t length) {
+		this->factor_table = table;
+		this->factor_table_length = length;
 	}
+#endif
 
 	// clear display (anything -> white)
 	void clear(uint16_t first_line_no = 0, uint8_t line_count = 0) {
@@ -104,6 +454,17 @@ public:
 		this->frame_data_repeat(image, EPD_normal,  first_line_no, line_count, subsampled_by_2);
 	}
 
+#if defined(EPD_PACKBITS_SUPPORT)
+	// assuming a clear (white) screen output a PackBits compressed image (PROGMEM data)
+	void image_packbits(PROGMEM const uint8_t *image, uint16_t first_line_no = 0, uint8_t line_count = 0) {
+		EPD_packbits_source source(image, true, first_line_no);
+		this->frame_fixed_repeat(0xaa, EPD_compensate, first_line_no, line_count);
+		this->frame_fixed_repeat(0xaa, EPD_white, first_line_no, line_count);
+		this->frame_repeat(source, EPD_inverse, first_line_no, line_count);
+		this->frame_repeat(source, EPD_normal,  first_line_no, line_count);
+	}
+#endif //defined(EPD_PACKBITS_SUPPORT)
+
 #if defined(EPD_OLD_IMAGE_SUPPORT)
 	// change from old image to new image (PROGMEM data)
 	void image(PROGMEM const uint8_t *old_image, PROGMEM const uint8_t *new_image,
@@ -157,6 +518,60 @@ public:
 	void frame_cb(uint32_t address, EPD_reader *reader, EPD_stage stage, uint16_t first_line_no = 0, uint8_t line_count = 0);
 
 
+	// single frame refresh from any line source
+	template<class Source>
+	void frame(Source &source, EPD_stage stage, uint16_t first_line_no = 0, uint8_t line_count = 0) {
+		if (0 == line_count) {
+			line_count = this->lines_per_display;
+		}
+#if !defined(EPD_STAGE_PASSES)
+		unsigned long t_start = micros();
+#endif
+		for (uint8_t n = 0; n < line_count; ++n) {
+			this->line(first_line_no + n, source.data(n, this->bytes_per_line), source.fixed_value(), source.progmem(), stage);
+		}
+#if !defined(EPD_STAGE_PASSES)
+		this->stage_line_us += micros() - t_start;
+#endif
+	}
+
+	// stage_time frame refresh from any line source
+	template<class Source>
+	void frame_repeat(Source &source, EPD_stage stage, uint16_t first_line_no = 0, uint8_t line_count = 0) {
+		if (0 == line_count) {
+			line_count = this->lines_per_display;
+		}
+#if defined(EPD_STAGE_PASSES)
+		uint16_t passes = this->stage_passes();
+		for (uint16_t n = 0; n < passes; ++n) {
+#if defined(EPD_PROFILE_SUPPORT)
+			unsigned long t_frame = micros();
+			uint32_t line_us = this->profile_data.line_us;
+#endif
+			this->frame(source, stage, first_line_no, line_count);
+#if defined(EPD_PROFILE_SUPPORT)
+			this->profile_data.loop_us += (micros() - t_frame) - (this->profile_data.line_us - line_us);
+			++this->profile_data.passes[stage];
+#endif
+		}
+#else
+		long stage_time = this->partial_stage_time(line_count);
+		do {
+			unsigned long t_start = millis();
+#if defined(EPD_PROFILE_SUPPORT)
+			unsigned long t_frame = micros();
+			uint32_t line_us = this->profile_data.line_us;
+#endif
+			this->frame(source, stage, first_line_no, line_count);
+#if defined(EPD_PROFILE_SUPPORT)
+			this->profile_data.loop_us += (micros() - t_frame) - (this->profile_data.line_us - line_us);
+			++this->profile_data.passes[stage];
+#endif
+			stage_time -= millis() - t_start;  // unsigned difference is safe across millis() wrap
+		} while (stage_time > 0);
+#endif //defined(EPD_STAGE_PASSES)
+	}
+
 	// stage_time frame refresh
 	void frame_fixed_repeat(uint8_t fixed_value, EPD_stage stage, uint16_t first_line_no = 0, uint8_t line_count = 0);
 	void frame_data_repeat(PROGMEM const uint8_t *new_image, EPD_stage stage, uint16_t first_line_no = 0, uint8_t line_count = 0, boolean subsampled_by_2 = false);
@@ -165,6 +580,37 @@ public:
 #endif //defined(EPD_ENABLE_EXTRA_SRAM)
 	void frame_cb_repeat(uint32_t address, EPD_reader *reader, EPD_stage stage, uint16_t first_line_no = 0, uint8_t line_count = 0);
 
+	// stage driven by the caller, for images produced in bands (e.g. EPD_GFX segments)
+	// that are all sent in every pass so the stage runs once for the whole panel:
+	//   EPD.stage_start();
+	//   while (EPD.stage_pass()) {
+	//       for each band: EPD.frame_sram(band, stage, first_line_no, line_count);
+	//   }
+	void stage_start() {
+		this->stage_pass_count = 0;
+#if defined(EPD_STAGE_PASSES)
+		this->stage_pass_target = this->stage_passes();
+#else
+		this->stage_line_us = 0;
+#endif
+	}
+
+	// true if another pass of the whole panel is due
+	bool stage_pass() {
+#if defined(EPD_STAGE_PASSES)
+		if (this->stage_pass_count >= this->stage_pass_target) {
+			return false;
+		}
+#else
+		// only the time spent on lines counts, not the caller drawing the bands between them
+		if ((0 != this->stage_pass_count) && (this->stage_line_us >= (unsigned long)this->factored_stage_time * 1000)) {
+			return false;
+		}
+#endif
+		++this->stage_pass_count;
+		return true;
+	}
+
 	// convert temperature to compensation factor
 	int temperature_to_factor_10x(int temperature);
 
@@ -172,6 +618,71 @@ public:
 	// also has to handle AVR progmem
 	void line(uint16_t line_no, const uint8_t *data, uint8_t fixed_value, bool read_progmem, EPD_stage stage);
 
+#if defined(EPD_PROFILE_SUPPORT)
+	// phase timings (frame_repeat and line only, not the async engine)
+	const EPD_profile &profile() const {
+		return this->profile_data;
+	}
+	void profile_reset() {
+		memset(&this->profile_data, 0, sizeof(this->profile_data));
+	}
+	void profile_dump();
+#endif //defined(EPD_PROFILE_SUPPORT)
+
+#if defined(EPD_ASYNC_SUPPORT)
+	// Asynchronous API calls
+	// ======================
+	// start_*_async() return at once, then call poll() from loop() until
+	// it returns false (or until the complete callback is called).
+	// Do not call any other EPD function while an update is running.
+	// The panel is not powered by these, as with the blocking calls:
+	//   EPD.begin();
+	//   EPD.start_image_async(image);
+	//   while (EPD.poll()) { other work }
+	//   EPD.end();
+	// On AVR a line is sent byte by byte from the SPI interrupt; when the COG
+	// raises BUSY sending stops until poll() sees it drop, so poll() often.
+
+	void start_async(const EPD_async_stage *stages, uint8_t stage_count,
+	                 uint16_t first_line_no = 0, uint8_t line_count = 0,
+	                 EPD_async_callback *complete = 0);
+	bool poll();
+	bool busy() {
+		return this->async_active;
+	}
+
+	// clear display (anything -> white)
+	void start_clear_async(uint16_t first_line_no = 0, uint8_t line_count = 0, EPD_async_callback *complete = 0) {
+		const EPD_async_stage stages[] = {
+			{EPD_compensate, 0xff, 0, false, 0, 0},
+			{EPD_white, 0xff, 0, false, 0, 0},
+			{EPD_inverse, 0xaa, 0, false, 0, 0},
+			{EPD_normal, 0xaa, 0, false, 0, 0}
+		};
+		this->start_async(stages, 4, first_line_no, line_count, complete);
+	}
+
+	// assuming a clear (white) screen output an image (PROGMEM data)
+	void start_image_async(PROGMEM const uint8_t *image, uint16_t first_line_no = 0, uint8_t line_count = 0, EPD_async_callback *complete = 0) {
+		const EPD_async_stage stages[] = {
+			{EPD_compensate, 0xaa, 0, false, 0, 0},
+			{EPD_white, 0xaa, 0, false, 0, 0},
+			{EPD_inverse, 0, image, true, 0, 0},
+			{EPD_normal, 0, image, true, 0, 0}
+		};
+		this->start_async(stages, 4, first_line_no, line_count, complete);
+	}
+
+	// assuming a clear (white) screen output an image (SRAM version)
+	void start_image_sram_async(const uint8_t *image, uint16_t first_line_no = 0, uint8_t line_count = 0, EPD_async_callback *complete = 0) {
+		const EPD_async_stage stages[] = {
+			{EPD_inverse, 0, image, false, 0, 0},
+			{EPD_normal, 0, image, false, 0, 0}
+		};
+		this->start_async(stages, 2, first_line_no, line_count, complete);
+	}
+#endif //defined(EPD_ASYNC_SUPPORT)
+
 	// inline static void attachInterrupt();
 	// inline static void detachInterrupt();
 
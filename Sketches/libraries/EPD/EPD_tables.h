@@ -0,0 +1,178 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+// Precomputed stage transforms for EPD_Class::line()
+// (only included by EPD.cpp when EPD_STAGE_LOOKUP_TABLES is defined)
+//
+// Each table is indexed by [EPD_stage][image byte] and gives the byte
+// to send to the COG.  The values are exactly what the switch(stage)
+// encoder in EPD.cpp produces, so 2048 bytes of PROGMEM buys one
+// lookup per byte instead of the branches and shifts.
+
+#if !defined(EPD_TABLES_H)
+#define EPD_TABLES_H 1
+
+// even pixels: (data & 0xaa) transformed for each stage
+static PROGMEM const uint8_t EPD_even_pixels[4][256] = {
+	{ // EPD_compensate
+		0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xfe, 0xfb, 0xfb, 0xfa, 0xfa, 0xfb, 0xfb, 0xfa, 0xfa,
+		0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xfe, 0xfb, 0xfb, 0xfa, 0xfa, 0xfb, 0xfb, 0xfa, 0xfa,
+		0xef, 0xef, 0xee, 0xee, 0xef, 0xef, 0xee, 0xee, 0xeb, 0xeb, 0xea, 0xea, 0xeb, 0xeb, 0xea, 0xea,
+		0xef, 0xef, 0xee, 0xee, 0xef, 0xef, 0xee, 0xee, 0xeb, 0xeb, 0xea, 0xea, 0xeb, 0xeb, 0xea, 0xea,
+		0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xfe, 0xfb, 0xfb, 0xfa, 0xfa, 0xfb, 0xfb, 0xfa, 0xfa,
+		0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xfe, 0xfb, 0xfb, 0xfa, 0xfa, 0xfb, 0xfb, 0xfa, 0xfa,
+		0xef, 0xef, 0xee, 0xee, 0xef, 0xef, 0xee, 0xee, 0xeb, 0xeb, 0xea, 0xea, 0xeb, 0xeb, 0xea, 0xea,
+		0xef, 0xef, 0xee, 0xee, 0xef, 0xef, 0xee, 0xee, 0xeb, 0xeb, 0xea, 0xea, 0xeb, 0xeb, 0xea, 0xea,
+		0xbf, 0xbf, 0xbe, 0xbe, 0xbf, 0xbf, 0xbe, 0xbe, 0xbb, 0xbb, 0xba, 0xba, 0xbb, 0xbb, 0xba, 0xba,
+		0xbf, 0xbf, 0xbe, 0xbe, 0xbf, 0xbf, 0xbe, 0xbe, 0xbb, 0xbb, 0xba, 0xba, 0xbb, 0xbb, 0xba, 0xba,
+		0xaf, 0xaf, 0xae, 0xae, 0xaf, 0xaf, 0xae, 0xae, 0xab, 0xab, 0xaa, 0xaa, 0xab, 0xab, 0xaa, 0xaa,
+		0xaf, 0xaf, 0xae, 0xae, 0xaf, 0xaf, 0xae, 0xae, 0xab, 0xab, 0xaa, 0xaa, 0xab, 0xab, 0xaa, 0xaa,
+		0xbf, 0xbf, 0xbe, 0xbe, 0xbf, 0xbf, 0xbe, 0xbe, 0xbb, 0xbb, 0xba, 0xba, 0xbb, 0xbb, 0xba, 0xba,
+		0xbf, 0xbf, 0xbe, 0xbe, 0xbf, 0xbf, 0xbe, 0xbe, 0xbb, 0xbb, 0xba, 0xba, 0xbb, 0xbb, 0xba, 0xba,
+		0xaf, 0xaf, 0xae, 0xae, 0xaf, 0xaf, 0xae, 0xae, 0xab, 0xab, 0xaa, 0xaa, 0xab, 0xab, 0xaa, 0xaa,
+		0xaf, 0xaf, 0xae, 0xae, 0xaf, 0xaf, 0xae, 0xae, 0xab, 0xab, 0xaa, 0xaa, 0xab, 0xab, 0xaa, 0xaa,
+	},
+	{ // EPD_white
+		0xaa, 0xaa, 0xa9, 0xa9, 0xaa, 0xaa, 0xa9, 0xa9, 0xa6, 0xa6, 0xa5, 0xa5, 0xa6, 0xa6, 0xa5, 0xa5,
+		0xaa, 0xaa, 0xa9, 0xa9, 0xaa, 0xaa, 0xa9, 0xa9, 0xa6, 0xa6, 0xa5, 0xa5, 0xa6, 0xa6, 0xa5, 0xa5,
+		0x9a, 0x9a, 0x99, 0x99, 0x9a, 0x9a, 0x99, 0x99, 0x96, 0x96, 0x95, 0x95, 0x96, 0x96, 0x95, 0x95,
+		0x9a, 0x9a, 0x99, 0x99, 0x9a, 0x9a, 0x99, 0x99, 0x96, 0x96, 0x95, 0x95, 0x96, 0x96, 0x95, 0x95,
+		0xaa, 0xaa, 0xa9, 0xa9, 0xaa, 0xaa, 0xa9, 0xa9, 0xa6, 0xa6, 0xa5, 0xa5, 0xa6, 0xa6, 0xa5, 0xa5,
+		0xaa, 0xaa, 0xa9, 0xa9, 0xaa, 0xaa, 0xa9, 0xa9, 0xa6, 0xa6, 0xa5, 0xa5, 0xa6, 0xa6, 0xa5, 0xa5,
+		0x9a, 0x9a, 0x99, 0x99, 0x9a, 0x9a, 0x99, 0x99, 0x96, 0x96, 0x95, 0x95, 0x96, 0x96, 0x95, 0x95,
+		0x9a, 0x9a, 0x99, 0x99, 0x9a, 0x9a, 0x99, 0x99, 0x96, 0x96, 0x95, 0x95, 0x96, 0x96, 0x95, 0x95,
+		0x6a, 0x6a, 0x69, 0x69, 0x6a, 0x6a, 0x69, 0x69, 0x66, 0x66, 0x65, 0x65, 0x66, 0x66, 0x65, 0x65,
+		0x6a, 0x6a, 0x69, 0x69, 0x6a, 0x6a, 0x69, 0x69, 0x66, 0x66, 0x65, 0x65, 0x66, 0x66, 0x65, 0x65,
+		0x5a, 0x5a, 0x59, 0x59, 0x5a, 0x5a, 0x59, 0x59, 0x56, 0x56, 0x55, 0x55, 0x56, 0x56, 0x55, 0x55,
+		0x5a, 0x5a, 0x59, 0x59, 0x5a, 0x5a, 0x59, 0x59, 0x56, 0x56, 0x55, 0x55, 0x56, 0x56, 0x55, 0x55,
+		0x6a, 0x6a, 0x69, 0x69, 0x6a, 0x6a, 0x69, 0x69, 0x66, 0x66, 0x65, 0x65, 0x66, 0x66, 0x65, 0x65,
+		0x6a, 0x6a, 0x69, 0x69, 0x6a, 0x6a, 0x69, 0x69, 0x66, 0x66, 0x65, 0x65, 0x66, 0x66, 0x65, 0x65,
+		0x5a, 0x5a, 0x59, 0x59, 0x5a, 0x5a, 0x59, 0x59, 0x56, 0x56, 0x55, 0x55, 0x56, 0x56, 0x55, 0x55,
+		0x5a, 0x5a, 0x59, 0x59, 0x5a, 0x5a, 0x59, 0x59, 0x56, 0x56, 0x55, 0x55, 0x56, 0x56, 0x55, 0x55,
+	},
+	{ // EPD_inverse
+		0xff, 0xff, 0xfd, 0xfd, 0xff, 0xff, 0xfd, 0xfd, 0xf7, 0xf7, 0xf5, 0xf5, 0xf7, 0xf7, 0xf5, 0xf5,
+		0xff, 0xff, 0xfd, 0xfd, 0xff, 0xff, 0xfd, 0xfd, 0xf7, 0xf7, 0xf5, 0xf5, 0xf7, 0xf7, 0xf5, 0xf5,
+		0xdf, 0xdf, 0xdd, 0xdd, 0xdf, 0xdf, 0xdd, 0xdd, 0xd7, 0xd7, 0xd5, 0xd5, 0xd7, 0xd7, 0xd5, 0xd5,
+		0xdf, 0xdf, 0xdd, 0xdd, 0xdf, 0xdf, 0xdd, 0xdd, 0xd7, 0xd7, 0xd5, 0xd5, 0xd7, 0xd7, 0xd5, 0xd5,
+		0xff, 0xff, 0xfd, 0xfd, 0xff, 0xff, 0xfd, 0xfd, 0xf7, 0xf7, 0xf5, 0xf5, 0xf7, 0xf7, 0xf5, 0xf5,
+		0xff, 0xff, 0xfd, 0xfd, 0xff, 0xff, 0xfd, 0xfd, 0xf7, 0xf7, 0xf5, 0xf5, 0xf7, 0xf7, 0xf5, 0xf5,
+		0xdf, 0xdf, 0xdd, 0xdd, 0xdf, 0xdf, 0xdd, 0xdd, 0xd7, 0xd7, 0xd5, 0xd5, 0xd7, 0xd7, 0xd5, 0xd5,
+		0xdf, 0xdf, 0xdd, 0xdd, 0xdf, 0xdf, 0xdd, 0xdd, 0xd7, 0xd7, 0xd5, 0xd5, 0xd7, 0xd7, 0xd5, 0xd5,
+		0x7f, 0x7f, 0x7d, 0x7d, 0x7f, 0x7f, 0x7d, 0x7d, 0x77, 0x77, 0x75, 0x75, 0x77, 0x77, 0x75, 0x75,
+		0x7f, 0x7f, 0x7d, 0x7d, 0x7f, 0x7f, 0x7d, 0x7d, 0x77, 0x77, 0x75, 0x75, 0x77, 0x77, 0x75, 0x75,
+		0x5f, 0x5f, 0x5d, 0x5d, 0x5f, 0x5f, 0x5d, 0x5d, 0x57, 0x57, 0x55, 0x55, 0x57, 0x57, 0x55, 0x55,
+		0x5f, 0x5f, 0x5d, 0x5d, 0x5f, 0x5f, 0x5d, 0x5d, 0x57, 0x57, 0x55, 0x55, 0x57, 0x57, 0x55, 0x55,
+		0x7f, 0x7f, 0x7d, 0x7d, 0x7f, 0x7f, 0x7d, 0x7d, 0x77, 0x77, 0x75, 0x75, 0x77, 0x77, 0x75, 0x75,
+		0x7f, 0x7f, 0x7d, 0x7d, 0x7f, 0x7f, 0x7d, 0x7d, 0x77, 0x77, 0x75, 0x75, 0x77, 0x77, 0x75, 0x75,
+		0x5f, 0x5f, 0x5d, 0x5d, 0x5f, 0x5f, 0x5d, 0x5d, 0x57, 0x57, 0x55, 0x55, 0x57, 0x57, 0x55, 0x55,
+		0x5f, 0x5f, 0x5d, 0x5d, 0x5f, 0x5f, 0x5d, 0x5d, 0x57, 0x57, 0x55, 0x55, 0x57, 0x57, 0x55, 0x55,
+	},
+	{ // EPD_normal
+		0xaa, 0xaa, 0xab, 0xab, 0xaa, 0xaa, 0xab, 0xab, 0xae, 0xae, 0xaf, 0xaf, 0xae, 0xae, 0xaf, 0xaf,
+		0xaa, 0xaa, 0xab, 0xab, 0xaa, 0xaa, 0xab, 0xab, 0xae, 0xae, 0xaf, 0xaf, 0xae, 0xae, 0xaf, 0xaf,
+		0xba, 0xba, 0xbb, 0xbb, 0xba, 0xba, 0xbb, 0xbb, 0xbe, 0xbe, 0xbf, 0xbf, 0xbe, 0xbe, 0xbf, 0xbf,
+		0xba, 0xba, 0xbb, 0xbb, 0xba, 0xba, 0xbb, 0xbb, 0xbe, 0xbe, 0xbf, 0xbf, 0xbe, 0xbe, 0xbf, 0xbf,
+		0xaa, 0xaa, 0xab, 0xab, 0xaa, 0xaa, 0xab, 0xab, 0xae, 0xae, 0xaf, 0xaf, 0xae, 0xae, 0xaf, 0xaf,
+		0xaa, 0xaa, 0xab, 0xab, 0xaa, 0xaa, 0xab, 0xab, 0xae, 0xae, 0xaf, 0xaf, 0xae, 0xae, 0xaf, 0xaf,
+		0xba, 0xba, 0xbb, 0xbb, 0xba, 0xba, 0xbb, 0xbb, 0xbe, 0xbe, 0xbf, 0xbf, 0xbe, 0xbe, 0xbf, 0xbf,
+		0xba, 0xba, 0xbb, 0xbb, 0xba, 0xba, 0xbb, 0xbb, 0xbe, 0xbe, 0xbf, 0xbf, 0xbe, 0xbe, 0xbf, 0xbf,
+		0xea, 0xea, 0xeb, 0xeb, 0xea, 0xea, 0xeb, 0xeb, 0xee, 0xee, 0xef, 0xef, 0xee, 0xee, 0xef, 0xef,
+		0xea, 0xea, 0xeb, 0xeb, 0xea, 0xea, 0xeb, 0xeb, 0xee, 0xee, 0xef, 0xef, 0xee, 0xee, 0xef, 0xef,
+		0xfa, 0xfa, 0xfb, 0xfb, 0xfa, 0xfa, 0xfb, 0xfb, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff,
+		0xfa, 0xfa, 0xfb, 0xfb, 0xfa, 0xfa, 0xfb, 0xfb, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff,
+		0xea, 0xea, 0xeb, 0xeb, 0xea, 0xea, 0xeb, 0xeb, 0xee, 0xee, 0xef, 0xef, 0xee, 0xee, 0xef, 0xef,
+		0xea, 0xea, 0xeb, 0xeb, 0xea, 0xea, 0xeb, 0xeb, 0xee, 0xee, 0xef, 0xef, 0xee, 0xee, 0xef, 0xef,
+		0xfa, 0xfa, 0xfb, 0xfb, 0xfa, 0xfa, 0xfb, 0xfb, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff,
+		0xfa, 0xfa, 0xfb, 0xfb, 0xfa, 0xfa, 0xfb, 0xfb, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff,
+	},
+};
+
+// odd pixels: (data & 0x55) transformed for each stage, bit pairs reversed
+static PROGMEM const uint8_t EPD_odd_pixels[4][256] = {
+	{ // EPD_compensate
+		0xff, 0xbf, 0xff, 0xbf, 0xef, 0xaf, 0xef, 0xaf, 0xff, 0xbf, 0xff, 0xbf, 0xef, 0xaf, 0xef, 0xaf,
+		0xfb, 0xbb, 0xfb, 0xbb, 0xeb, 0xab, 0xeb, 0xab, 0xfb, 0xbb, 0xfb, 0xbb, 0xeb, 0xab, 0xeb, 0xab,
+		0xff, 0xbf, 0xff, 0xbf, 0xef, 0xaf, 0xef, 0xaf, 0xff, 0xbf, 0xff, 0xbf, 0xef, 0xaf, 0xef, 0xaf,
+		0xfb, 0xbb, 0xfb, 0xbb, 0xeb, 0xab, 0xeb, 0xab, 0xfb, 0xbb, 0xfb, 0xbb, 0xeb, 0xab, 0xeb, 0xab,
+		0xfe, 0xbe, 0xfe, 0xbe, 0xee, 0xae, 0xee, 0xae, 0xfe, 0xbe, 0xfe, 0xbe, 0xee, 0xae, 0xee, 0xae,
+		0xfa, 0xba, 0xfa, 0xba, 0xea, 0xaa, 0xea, 0xaa, 0xfa, 0xba, 0xfa, 0xba, 0xea, 0xaa, 0xea, 0xaa,
+		0xfe, 0xbe, 0xfe, 0xbe, 0xee, 0xae, 0xee, 0xae, 0xfe, 0xbe, 0xfe, 0xbe, 0xee, 0xae, 0xee, 0xae,
+		0xfa, 0xba, 0xfa, 0xba, 0xea, 0xaa, 0xea, 0xaa, 0xfa, 0xba, 0xfa, 0xba, 0xea, 0xaa, 0xea, 0xaa,
+		0xff, 0xbf, 0xff, 0xbf, 0xef, 0xaf, 0xef, 0xaf, 0xff, 0xbf, 0xff, 0xbf, 0xef, 0xaf, 0xef, 0xaf,
+		0xfb, 0xbb, 0xfb, 0xbb, 0xeb, 0xab, 0xeb, 0xab, 0xfb, 0xbb, 0xfb, 0xbb, 0xeb, 0xab, 0xeb, 0xab,
+		0xff, 0xbf, 0xff, 0xbf, 0xef, 0xaf, 0xef, 0xaf, 0xff, 0xbf, 0xff, 0xbf, 0xef, 0xaf, 0xef, 0xaf,
+		0xfb, 0xbb, 0xfb, 0xbb, 0xeb, 0xab, 0xeb, 0xab, 0xfb, 0xbb, 0xfb, 0xbb, 0xeb, 0xab, 0xeb, 0xab,
+		0xfe, 0xbe, 0xfe, 0xbe, 0xee, 0xae, 0xee, 0xae, 0xfe, 0xbe, 0xfe, 0xbe, 0xee, 0xae, 0xee, 0xae,
+		0xfa, 0xba, 0xfa, 0xba, 0xea, 0xaa, 0xea, 0xaa, 0xfa, 0xba, 0xfa, 0xba, 0xea, 0xaa, 0xea, 0xaa,
+		0xfe, 0xbe, 0xfe, 0xbe, 0xee, 0xae, 0xee, 0xae, 0xfe, 0xbe, 0xfe, 0xbe, 0xee, 0xae, 0xee, 0xae,
+		0xfa, 0xba, 0xfa, 0xba, 0xea, 0xaa, 0xea, 0xaa, 0xfa, 0xba, 0xfa, 0xba, 0xea, 0xaa, 0xea, 0xaa,
+	},
+	{ // EPD_white
+		0xaa, 0x6a, 0xaa, 0x6a, 0x9a, 0x5a, 0x9a, 0x5a, 0xaa, 0x6a, 0xaa, 0x6a, 0x9a, 0x5a, 0x9a, 0x5a,
+		0xa6, 0x66, 0xa6, 0x66, 0x96, 0x56, 0x96, 0x56, 0xa6, 0x66, 0xa6, 0x66, 0x96, 0x56, 0x96, 0x56,
+		0xaa, 0x6a, 0xaa, 0x6a, 0x9a, 0x5a, 0x9a, 0x5a, 0xaa, 0x6a, 0xaa, 0x6a, 0x9a, 0x5a, 0x9a, 0x5a,
+		0xa6, 0x66, 0xa6, 0x66, 0x96, 0x56, 0x96, 0x56, 0xa6, 0x66, 0xa6, 0x66, 0x96, 0x56, 0x96, 0x56,
+		0xa9, 0x69, 0xa9, 0x69, 0x99, 0x59, 0x99, 0x59, 0xa9, 0x69, 0xa9, 0x69, 0x99, 0x59, 0x99, 0x59,
+		0xa5, 0x65, 0xa5, 0x65, 0x95, 0x55, 0x95, 0x55, 0xa5, 0x65, 0xa5, 0x65, 0x95, 0x55, 0x95, 0x55,
+		0xa9, 0x69, 0xa9, 0x69, 0x99, 0x59, 0x99, 0x59, 0xa9, 0x69, 0xa9, 0x69, 0x99, 0x59, 0x99, 0x59,
+		0xa5, 0x65, 0xa5, 0x65, 0x95, 0x55, 0x95, 0x55, 0xa5, 0x65, 0xa5, 0x65, 0x95, 0x55, 0x95, 0x55,
+		0xaa, 0x6a, 0xaa, 0x6a, 0x9a, 0x5a, 0x9a, 0x5a, 0xaa, 0x6a, 0xaa, 0x6a, 0x9a, 0x5a, 0x9a, 0x5a,
+		0xa6, 0x66, 0xa6, 0x66, 0x96, 0x56, 0x96, 0x56, 0xa6, 0x66, 0xa6, 0x66, 0x96, 0x56, 0x96, 0x56,
+		0xaa, 0x6a, 0xaa, 0x6a, 0x9a, 0x5a, 0x9a, 0x5a, 0xaa, 0x6a, 0xaa, 0x6a, 0x9a, 0x5a, 0x9a, 0x5a,
+		0xa6, 0x66, 0xa6, 0x66, 0x96, 0x56, 0x96, 0x56, 0xa6, 0x66, 0xa6, 0x66, 0x96, 0x56, 0x96, 0x56,
+		0xa9, 0x69, 0xa9, 0x69, 0x99, 0x59, 0x99, 0x59, 0xa9, 0x69, 0xa9, 0x69, 0x99, 0x59, 0x99, 0x59,
+		0xa5, 0x65, 0xa5, 0x65, 0x95, 0x55, 0x95, 0x55, 0xa5, 0x65, 0xa5, 0x65, 0x95, 0x55, 0x95, 0x55,
+		0xa9, 0x69, 0xa9, 0x69, 0x99, 0x59, 0x99, 0x59, 0xa9, 0x69, 0xa9, 0x69, 0x99, 0x59, 0x99, 0x59,
+		0xa5, 0x65, 0xa5, 0x65, 0x95, 0x55, 0x95, 0x55, 0xa5, 0x65, 0xa5, 0x65, 0x95, 0x55, 0x95, 0x55,
+	},
+	{ // EPD_inverse
+		0xff, 0x7f, 0xff, 0x7f, 0xdf, 0x5f, 0xdf, 0x5f, 0xff, 0x7f, 0xff, 0x7f, 0xdf, 0x5f, 0xdf, 0x5f,
+		0xf7, 0x77, 0xf7, 0x77, 0xd7, 0x57, 0xd7, 0x57, 0xf7, 0x77, 0xf7, 0x77, 0xd7, 0x57, 0xd7, 0x57,
+		0xff, 0x7f, 0xff, 0x7f, 0xdf, 0x5f, 0xdf, 0x5f, 0xff, 0x7f, 0xff, 0x7f, 0xdf, 0x5f, 0xdf, 0x5f,
+		0xf7, 0x77, 0xf7, 0x77, 0xd7, 0x57, 0xd7, 0x57, 0xf7, 0x77, 0xf7, 0x77, 0xd7, 0x57, 0xd7, 0x57,
+		0xfd, 0x7d, 0xfd, 0x7d, 0xdd, 0x5d, 0xdd, 0x5d, 0xfd, 0x7d, 0xfd, 0x7d, 0xdd, 0x5d, 0xdd, 0x5d,
+		0xf5, 0x75, 0xf5, 0x75, 0xd5, 0x55, 0xd5, 0x55, 0xf5, 0x75, 0xf5, 0x75, 0xd5, 0x55, 0xd5, 0x55,
+		0xfd, 0x7d, 0xfd, 0x7d, 0xdd, 0x5d, 0xdd, 0x5d, 0xfd, 0x7d, 0xfd, 0x7d, 0xdd, 0x5d, 0xdd, 0x5d,
+		0xf5, 0x75, 0xf5, 0x75, 0xd5, 0x55, 0xd5, 0x55, 0xf5, 0x75, 0xf5, 0x75, 0xd5, 0x55, 0xd5, 0x55,
+		0xff, 0x7f, 0xff, 0x7f, 0xdf, 0x5f, 0xdf, 0x5f, 0xff, 0x7f, 0xff, 0x7f, 0xdf, 0x5f, 0xdf, 0x5f,
+		0xf7, 0x77, 0xf7, 0x77, 0xd7, 0x57, 0xd7, 0x57, 0xf7, 0x77, 0xf7, 0x77, 0xd7, 0x57, 0xd7, 0x57,
+		0xff, 0x7f, 0xff, 0x7f, 0xdf, 0x5f, 0xdf, 0x5f, 0xff, 0x7f, 0xff, 0x7f, 0xdf, 0x5f, 0xdf, 0x5f,
+		0xf7, 0x77, 0xf7, 0x77, 0xd7, 0x57, 0xd7, 0x57, 0xf7, 0x77, 0xf7, 0x77, 0xd7, 0x57, 0xd7, 0x57,
+		0xfd, 0x7d, 0xfd, 0x7d, 0xdd, 0x5d, 0xdd, 0x5d, 0xfd, 0x7d, 0xfd, 0x7d, 0xdd, 0x5d, 0xdd, 0x5d,
+		0xf5, 0x75, 0xf5, 0x75, 0xd5, 0x55, 0xd5, 0x55, 0xf5, 0x75, 0xf5, 0x75, 0xd5, 0x55, 0xd5, 0x55,
+		0xfd, 0x7d, 0xfd, 0x7d, 0xdd, 0x5d, 0xdd, 0x5d, 0xfd, 0x7d, 0xfd, 0x7d, 0xdd, 0x5d, 0xdd, 0x5d,
+		0xf5, 0x75, 0xf5, 0x75, 0xd5, 0x55, 0xd5, 0x55, 0xf5, 0x75, 0xf5, 0x75, 0xd5, 0x55, 0xd5, 0x55,
+	},
+	{ // EPD_normal
+		0xaa, 0xea, 0xaa, 0xea, 0xba, 0xfa, 0xba, 0xfa, 0xaa, 0xea, 0xaa, 0xea, 0xba, 0xfa, 0xba, 0xfa,
+		0xae, 0xee, 0xae, 0xee, 0xbe, 0xfe, 0xbe, 0xfe, 0xae, 0xee, 0xae, 0xee, 0xbe, 0xfe, 0xbe, 0xfe,
+		0xaa, 0xea, 0xaa, 0xea, 0xba, 0xfa, 0xba, 0xfa, 0xaa, 0xea, 0xaa, 0xea, 0xba, 0xfa, 0xba, 0xfa,
+		0xae, 0xee, 0xae, 0xee, 0xbe, 0xfe, 0xbe, 0xfe, 0xae, 0xee, 0xae, 0xee, 0xbe, 0xfe, 0xbe, 0xfe,
+		0xab, 0xeb, 0xab, 0xeb, 0xbb, 0xfb, 0xbb, 0xfb, 0xab, 0xeb, 0xab, 0xeb, 0xbb, 0xfb, 0xbb, 0xfb,
+		0xaf, 0xef, 0xaf, 0xef, 0xbf, 0xff, 0xbf, 0xff, 0xaf, 0xef, 0xaf, 0xef, 0xbf, 0xff, 0xbf, 0xff,
+		0xab, 0xeb, 0xab, 0xeb, 0xbb, 0xfb, 0xbb, 0xfb, 0xab, 0xeb, 0xab, 0xeb, 0xbb, 0xfb, 0xbb, 0xfb,
+		0xaf, 0xef, 0xaf, 0xef, 0xbf, 0xff, 0xbf, 0xff, 0xaf, 0xef, 0xaf, 0xef, 0xbf, 0xff, 0xbf, 0xff,
+		0xaa, 0xea, 0xaa, 0xea, 0xba, 0xfa, 0xba, 0xfa, 0xaa, 0xea, 0xaa, 0xea, 0xba, 0xfa, 0xba, 0xfa,
+		0xae, 0xee, 0xae, 0xee, 0xbe, 0xfe, 0xbe, 0xfe, 0xae, 0xee, 0xae, 0xee, 0xbe, 0xfe, 0xbe, 0xfe,
+		0xaa, 0xea, 0xaa, 0xea, 0xba, 0xfa, 0xba, 0xfa, 0xaa, 0xea, 0xaa, 0xea, 0xba, 0xfa, 0xba, 0xfa,
+		0xae, 0xee, 0xae, 0xee, 0xbe, 0xfe, 0xbe, 0xfe, 0xae, 0xee, 0xae, 0xee, 0xbe, 0xfe, 0xbe, 0xfe,
+		0xab, 0xeb, 0xab, 0xeb, 0xbb, 0xfb, 0xbb, 0xfb, 0xab, 0xeb, 0xab, 0xeb, 0xbb, 0xfb, 0xbb, 0xfb,
+		0xaf, 0xef, 0xaf, 0xef, 0xbf, 0xff, 0xbf, 0xff, 0xaf, 0xef, 0xaf, 0xef, 0xbf, 0xff, 0xbf, 0xff,
+		0xab, 0xeb, 0xab, 0xeb, 0xbb, 0xfb, 0xbb, 0xfb, 0xab, 0xeb, 0xab, 0xeb, 0xbb, 0xfb, 0xbb, 0xfb,
+		0xaf, 0xef, 0xaf, 0xef, 0xbf, 0xff, 0xbf, 0xff, 0xaf, 0xef, 0xaf, 0xef, 0xbf, 0xff, 0xbf, 0xff,
+	},
+};
+
+#endif
@@ -45,11 +45,13 @@
 
 // required libraries
 #include <SPI.h>
+#include <SPI_BUS.h>
 #ifndef EMBEDDED_ARTISTS
 #include <FLASH.h>
 #endif /* EMBEDDED_ARTISTS */
 #include <EPD.h>
 //Temperature sensor
+#include <TEMPERATURE.h>
 #ifndef EMBEDDED_ARTISTS
 #include <S5813A.h>
 #else /* EMBEDDED_ARTISTS */
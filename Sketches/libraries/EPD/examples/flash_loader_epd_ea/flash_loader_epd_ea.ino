@@ -16,8 +16,8 @@
 
 // Simple demo with two functions:
 //
-// 1. Copy an included iname to a specified FLSH sector and display it
-// 2. Display a list of already FLASHed images
+// 1. Copy an included image to the FLASH image store and display it
+// 2. Display a list of already FLASHed images (by name)
 //
 // Note: only one function is available at a time.
 
@@ -29,9 +29,12 @@
 
 // required libraries
 #include <SPI.h>
+#include <SPI_BUS.h>
 #include <FLASH.h>
+#include <FLASH_STORE.h>
 #include <EPD.h>
 //Temperature sensor
+#include <TEMPERATURE.h>
 #ifndef EMBEDDED_ARTISTS
 #include <S5813A.h>
 #else /* EMBEDDED_ARTISTS */
@@ -71,14 +74,13 @@
 #endif
 
 // select image from:  text_image text-hello cat aphrodite venus saturn
-// select a suitable sector, (size 270 will take two sectors)
+// the image is stored under this name (unless already there)
 #define IMAGE        cat
-#define FLASH_SECTOR (0*SECTORS_USED)
 
 // if the display list is defined it will take priority over the flashing
 // (and FLASH code is disbled)
-// define a list of {sector, milliseconds}
-//#define DISPLAY_LIST {0, 5000}, {1*SECTORS_USED, 5000}, {2*SECTORS_USED, 5000}
+// define a list of {"image name", milliseconds}
+//#define DISPLAY_LIST {"cat", 5000}, {"venus", 5000}
 
 // program version
 #define FLASH_LOADER_VERSION "1"
@@ -168,9 +170,15 @@ static void flash_info(void);
 static void flash_read(void *buffer, uint32_t address, uint16_t length);
 
 #if !defined(DISPLAY_LIST)
-static void flash_program(uint16_t sector, const void *buffer, uint16_t length, bool buffer_in_progmem);
+static void flash_program(const char *name, const void *buffer, uint16_t length);
 #endif
 
+// SRAM to keep image lines read from the FLASH between stage passes
+// (lines that do not fit are re-read from the FLASH on every pass)
+#define LINE_CACHE_SIZE 512
+static uint8_t line_cache[LINE_CACHE_SIZE];
+
+
 // define the E-Ink display
 EPD_Class EPD(EPD_SIZE, Pin_PANEL_ON, Pin_BORDER, Pin_DISCHARGE, Pin_PWM, Pin_RESET, Pin_BUSY, Pin_EPD_CS);
 #ifdef EMBEDDED_ARTISTS
@@ -238,12 +246,14 @@ void setup() {
         //   L                 H                 H               H
         //   H                 L                 H               L
         //   H                 H                 H               H
-        digitalWrite(Pin_PANEL_ON, LOW);
-	FLASH.begin(Pin_EPD_CS);
+        // SPI_BUS drives Pin_PANEL_ON low while the flash is selected
+	FLASH.begin(Pin_EPD_CS, Pin_PANEL_ON, LOW);
 #endif /* ! EMBEDDED_ARTISTS */
 
     flash_info();
 
+	FLASH_STORE.begin();
+
 #ifndef EMBEDDED_ARTISTS
 	// configure temperature sensor
 	S5813A.begin(Pin_TEMPERATURE);
@@ -253,24 +263,24 @@ void setup() {
 #if !defined(DISPLAY_LIST)
 
         //First image
-        flash_program(FLASH_SECTOR, IMAGE_BITS, sizeof(IMAGE_BITS), true);
+        flash_program(MAKE_STRING(IMAGE), IMAGE_BITS, sizeof(IMAGE_BITS));
 
 #endif
 }
 
 
 typedef struct {
-	int sector;
+	const char *name;
 	int delay_ms;
 } display_list_type[];
 
-// list of {FLASH sector, milliseconds} to display
-// if not defined then just display the current flash sector
+// list of {image name, milliseconds} to display
+// if not defined then just display the image just stored
 static const display_list_type display_list = {
 #if defined(DISPLAY_LIST)
 	DISPLAY_LIST
 #else
-	{FLASH_SECTOR, 5000}
+	{MAKE_STRING(IMAGE), 5000}
 #endif
 };
 
@@ -307,7 +317,17 @@ void loop() {
 		break;
 
 	case 1:         // next image
-		uint32_t address = display_list[display_index].sector << 12;
+	{
+		FLASH_STORE_entry entry;
+		if (FLASH_STORE.find(display_list[display_index].name, &entry) < 0) {
+			Serial.print("Missing image: ");
+			Serial.println(display_list[display_index].name);
+			if (++display_index >= DISPLAY_ITEM_COUNT) {
+				display_index = 0;
+			}
+			break;
+		}
+		uint32_t address = FLASH_STORE.address(&entry);
 		Serial.print("Address = 0x");
 		Serial.println(address, HEX);
 		delay_counts = display_list[display_index].delay_ms;
@@ -319,13 +339,15 @@ void loop() {
 #endif /* EMBEDDED_ARTISTS */
 		EPD.setFactor(t);
 
+		EPD_cached_reader_source image(old_address, flash_read, line_cache, sizeof(line_cache));
 		if (INVALID_ADDRESS != old_address)
                 {
-			EPD.frame_cb_repeat(old_address, flash_read, EPD_compensate);
-			EPD.frame_cb_repeat(old_address, flash_read, EPD_white);
+			EPD.frame_repeat(image, EPD_compensate);
+			EPD.frame_repeat(image, EPD_white);
 		}
-		EPD.frame_cb_repeat(address, flash_read, EPD_inverse);
-		EPD.frame_cb_repeat(address, flash_read, EPD_normal);
+		image.set_address(address);
+		EPD.frame_repeat(image, EPD_inverse);
+		EPD.frame_repeat(image, EPD_normal);
 
 		EPD.end();
 		// preserve address for next cycle
@@ -335,6 +357,7 @@ void loop() {
 			display_index = 0;
 		}
 		break;
+	}
 
 	}
 
@@ -365,22 +388,35 @@ static void flash_info(void) {
 // EPD display callback for reading the FLASH
 static void flash_read(void *buffer, uint32_t address, uint16_t length)
 {
-#ifdef EMBEDDED_ARTISTS
-  digitalWrite(Pin_PANEL_ON, LOW); //Change back to using SSEL for Flash
-#endif /* EMBEDDED_ARTISTS */  
-
-  FLASH.read(buffer, address, length);
-
-#ifdef EMBEDDED_ARTISTS
-  digitalWrite(Pin_PANEL_ON, HIGH); //Change back to using SSEL for EPD
-#endif /* EMBEDDED_ARTISTS */  
+	FLASH.read(buffer, address, length);
 
 }
 
 
 #if !defined(DISPLAY_LIST)
-// program image into FLASH
-static void flash_program(uint16_t sector, const void *buffer, uint16_t length, bool buffer_in_progmem = false) {
+// store the image in the FLASH image store (unless it is already there)
+static void flash_program(const char *name, const void *buffer, uint16_t length) {
+	uint32_t crc = FLASH_STORE.crc32(0, buffer, length, true);
+
+	if (!FLASH_STORE.mounted()) {
+		Serial.println("FLASH: creating image store");
+		FLASH_STORE.format();
+	}
+	FLASH_STORE_entry entry;
+	int16_t old_id = FLASH_STORE.find(name, &entry);
+	if (old_id >= 0 && length == entry.length && crc == entry.crc && FLASH_STORE.verify(&entry)) {
+		Serial.print("FLASH: ");
+		Serial.print(name);
+		Serial.print(" already stored as image ");
+		Serial.println(old_id, DEC);
+		return;
+	}
+
+	int16_t sector = FLASH_STORE.allocate(length, false);
+	if (sector < 0) {
+		Serial.println("FLASH: no free sectors");
+		return;
+	}
 	Serial.print("FLASH: program sector = ");
 	Serial.println(sector, DEC);
 	Serial.print("       from memory @ 0x");
@@ -388,44 +424,28 @@ static void flash_program(uint16_t sector, const void *buffer, uint16_t length,
 	Serial.print("  total bytes: ");
 	Serial.println(length, DEC);
 
-	uint32_t address = sector << FLASH_SECTOR_SHIFT;
+	// erases each sector and programs whole pages
+	FLASH_page_writer writer(FLASH, (uint32_t)sector << FLASH_SECTOR_SHIFT);
+	writer.write(buffer, length, true);
+	writer.finish();
 
-	// erase required sectors
-	for (int i = 0; i < length; i += FLASH_SECTOR_SIZE, address += FLASH_SECTOR_SIZE) {
-		Serial.print("FLASH: erase = 0x");
-		Serial.println(address, HEX);
-		FLASH.write_enable();
-		FLASH.sector_erase(address);
+	if (FLASH_STORE.crc32_flash((uint32_t)sector << FLASH_SECTOR_SHIFT, length) != crc) {
+		Serial.println("FLASH: verify failed");
+		return;
 	}
 
-	// writable pages are FLASH_PAGE_SIZE bytes
-	const uint8_t *p = (const uint8_t *)buffer;
-	for (address = sector << FLASH_SECTOR_SHIFT; length >= FLASH_PAGE_SIZE;
-	     length -= FLASH_PAGE_SIZE, address += FLASH_PAGE_SIZE, p += FLASH_PAGE_SIZE) {
-		Serial.print("FLASH: write @ 0x");
-		Serial.print(address, HEX);
-		Serial.print("  from: 0x");
-		Serial.print((uint32_t)p, HEX);
-		Serial.print("  bytes: 0x");
-		Serial.println(FLASH_PAGE_SIZE, HEX);
-
-		FLASH.write_enable();
-		FLASH.write(address, p, FLASH_PAGE_SIZE, buffer_in_progmem);
+	// the new copy is complete, so the old one can go
+	if (old_id >= 0) {
+		FLASH_STORE.remove(old_id);
 	}
-	// write any remaining partial page
-	if (length > 0) {
-		Serial.print("FLASH: write @ 0x");
-		Serial.print(address, HEX);
-		Serial.print("  from: 0x");
-		Serial.print((uint32_t)p, HEX);
-		Serial.print("  bytes: 0x");
-		Serial.println(length, HEX);
-		FLASH.write_enable();
-		FLASH.write(address, p, length);
+	int16_t id = FLASH_STORE.add(name, sector, length, EPD_SIZE, FLASH_STORE_XBM, crc);
+	Serial.print("FLASH: ");
+	Serial.print(name);
+	if (id < 0) {
+		Serial.println(" not stored, directory full");
+	} else {
+		Serial.print(" stored as image ");
+		Serial.println(id, DEC);
 	}
-
-	// turn off write - just to be safe
-	FLASH.write_disable();
-       
 }
 #endif
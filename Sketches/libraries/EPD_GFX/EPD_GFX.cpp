@@ -38,7 +38,31 @@ void EPD_GFX::clear() {
 
 	// clear buffers to white
 	clear_new_image();
+
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	// every segment is now white
+	uint16_t white_crc = new_image_crc();
+	for (uint8_t s = 0; s < total_segments; s++) {
+		set_segment_crc(s, white_crc);
+	}
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+}
+
+
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+// CRC-16/CCITT of the current segment buffer
+uint16_t EPD_GFX::new_image_crc() {
+	uint16_t crc = 0xffff;
+	const uint8_t *p = this->new_image;
+	for (uint16_t n = get_segment_buffer_size_bytes(); n != 0; --n) {
+		crc ^= (uint16_t)(*p++) << 8;
+		for (uint8_t bit = 0; bit < 8; ++bit) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+	return crc;
 }
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
 
 
 void EPD_GFX::display(boolean clear_first, boolean begin, boolean end) {
@@ -46,6 +70,42 @@ void EPD_GFX::display(boolean clear_first, boolean begin, boolean end) {
 	// Optionally begins and ends the EPD/SPI.
 	// There are delays in thos functions that only need to be pre/post use of the display
 
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	if(begin)
+	{
+	    begin_pending = true;
+	}
+
+	uint16_t crc = new_image_crc();
+	if(!segment_valid(current_segment) || (crc != segment_crc[current_segment]))
+	{
+	    if(begin_pending)
+	    {
+	        this->EPD.begin();
+	        this->EPD.setFactor( get_temperature() );
+	        begin_pending = false;
+	    }
+	    if(clear_first)
+	    {
+	        this->EPD.clear(current_segment * this->pixel_height_segment, this->pixel_height_segment);
+	    }
+	    //NOTE: Although the expectation is that pixel_height_segment is going to be in an uint8_t keep an eye on this...
+	    assert( this->pixel_height_segment <= 255);
+	    this->EPD.image_sram(this->new_image, current_segment * this->pixel_height_segment,
+	                        (uint8_t)this->pixel_height_segment);
+	    set_segment_crc(current_segment, crc);
+	}
+
+	if(end)
+	{
+	    //Only power down if we powered up (nothing to do if every segment was unchanged)
+	    if(!begin_pending)
+	    {
+	        this->EPD.end();
+	    }
+	    begin_pending = false;
+	}
+#else
 	if(begin)
 	{
     	this->EPD.begin();
@@ -65,79 +125,624 @@ void EPD_GFX::display(boolean clear_first, boolean begin, boolean end) {
 	{
     	this->EPD.end();
 	}
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+}
+
+#if defined(EPD_GFX_TRANSITION_SUPPORT)
+void EPD_GFX::display_transition(EPD_GFX_draw *draw, const void *old_state, const void *new_state) {
+	if(0 == old_image)
+	{
+	    old_image = new uint8_t[ get_segment_buffer_size_bytes() ];
+	    assert( old_image );
+	}
+
+	boolean begun = false;
+	//NOTE: Although the expectation is that pixel_height_segment is going to be in an uint8_t keep an eye on this...
+	assert( this->pixel_height_segment <= 255);
+
+	for(uint8_t s = 0; s < total_segments; s++)
+	{
+	    //Render the old scene then swap it into old_image (drawPixel always writes to new_image)
+	    set_current_segment(s);
+	    if(0 != old_state)
+	    {
+	        draw(*this, old_state);
+	    }
+	    uint8_t *t = old_image;
+	    old_image = new_image;
+	    new_image = t;
+
+	    set_current_segment(s);
+	    draw(*this, new_state);
+
+	    if(0 == memcmp(old_image, new_image, get_segment_buffer_size_bytes()))
+	    {
+	        continue;
+	    }
+
+	    if(!begun)
+	    {
+	        this->EPD.begin();
+	        this->EPD.setFactor( get_temperature() );
+	        begun = true;
+	    }
+	    this->EPD.image_sram(this->old_image, this->new_image, s * this->pixel_height_segment,
+	                        (uint8_t)this->pixel_height_segment);
+
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	    set_segment_crc(s, new_image_crc());
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	}
+
+	if(begun)
+	{
+	    this->EPD.end();
+	}
+}
+#endif //defined(EPD_GFX_TRANSITION_SUPPORT)
+
+void EPD_GFX::display_interleaved(EPD_GFX_draw *draw, const void *old_state, const void *new_state) {
+	static const EPD_stage stages[] = {EPD_compensate, EPD_white, EPD_inverse, EPD_normal};
+
+	//NOTE: Although the expectation is that pixel_height_segment is going to be in an uint8_t keep an eye on this...
+	assert( this->pixel_height_segment <= 255);
+
+	this->EPD.begin();
+	this->EPD.setFactor( get_temperature() );
+
+	uint8_t first_stage = 0;
+	if(0 == old_state)
+	{
+	    //Full panel clear is already a single pass per stage
+	    this->EPD.clear();
+	    first_stage = 2;
+	}
+
+	for(uint8_t i = first_stage; i < 4; i++)
+	{
+	    const void *state = (i < 2) ? old_state : new_state;
+	    boolean first_pass = true;
+
+	    this->EPD.stage_start();
+	    while(this->EPD.stage_pass())
+	    {
+	        for(uint8_t s = 0; s < total_segments; s++)
+	        {
+	            set_current_segment(s);  // also clears new_image
+	            draw(*this, state);
+	            this->EPD.frame_sram(this->new_image, stages[i], s * this->pixel_height_segment,
+	                                 (uint8_t)this->pixel_height_segment);
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	            if(first_pass && (2 == i))
+	            {
+	                set_segment_crc(s, new_image_crc());
+	            }
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	        }
+	        first_pass = false;
+	    }
+	}
+
+	this->EPD.end();
+}
+
+#if defined(EPD_GFX_DISPLAY_LIST_SUPPORT)
+EPD_GFX_primitive *EPD_GFX_display_list::add(uint8_t type, uint16_t colour, int16_t top, int16_t bottom) {
+	if (count >= capacity) {
+		return 0;
+	}
+	EPD_GFX_primitive *p = &items[count++];
+	p->type = type;
+	p->colour = colour;
+	p->top = top;
+	p->bottom = bottom;
+	return p;
+}
+
+bool EPD_GFX_display_list::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) {
+	EPD_GFX_primitive *p = add(FILL_RECT, colour, y, y + h - 1);
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x; p->y0 = y; p->x1 = w; p->y1 = h;
+	return true;
+}
+
+bool EPD_GFX_display_list::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) {
+	EPD_GFX_primitive *p = add(DRAW_RECT, colour, y, y + h - 1);
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x; p->y0 = y; p->x1 = w; p->y1 = h;
+	return true;
+}
+
+bool EPD_GFX_display_list::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t colour) {
+	EPD_GFX_primitive *p = add(LINE, colour, min(y0, y1), max(y0, y1));
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x0; p->y0 = y0; p->x1 = x1; p->y1 = y1;
+	return true;
+}
+
+bool EPD_GFX_display_list::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colour) {
+	EPD_GFX_primitive *p = add(DRAW_CIRCLE, colour, y0 - r, y0 + r);
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x0; p->y0 = y0; p->x1 = r;
+	return true;
+}
+
+bool EPD_GFX_display_list::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colour) {
+	EPD_GFX_primitive *p = add(FILL_CIRCLE, colour, y0 - r, y0 + r);
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x0; p->y0 = y0; p->x1 = r;
+	return true;
+}
+
+bool EPD_GFX_display_list::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t colour) {
+	EPD_GFX_primitive *p = add(DRAW_TRIANGLE, colour, min(y0, min(y1, y2)), max(y0, max(y1, y2)));
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x0; p->y0 = y0; p->x1 = x1; p->y1 = y1; p->x2 = x2; p->y2 = y2;
+	return true;
+}
+
+bool EPD_GFX_display_list::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t colour) {
+	EPD_GFX_primitive *p = add(FILL_TRIANGLE, colour, min(y0, min(y1, y2)), max(y0, max(y1, y2)));
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x0; p->y0 = y0; p->x1 = x1; p->y1 = y1; p->x2 = x2; p->y2 = y2;
+	return true;
+}
+
+bool EPD_GFX_display_list::drawText(int16_t x, int16_t y, const char *text, uint16_t colour, uint16_t bg, uint8_t size) {
+	EPD_GFX_primitive *p = add(TEXT, colour, y, y + EPD_GFX_CHAR_PADDED_HEIGHT * size - 1);
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x; p->y0 = y; p->bg = bg; p->size = size; p->data = text;
+	return true;
+}
+
+bool EPD_GFX_display_list::drawBitmap(int16_t x, int16_t y, const uint8_t PROGMEM *bitmap, int16_t w, int16_t h, uint16_t colour) {
+	EPD_GFX_primitive *p = add(BITMAP, colour, y, y + h - 1);
+	if (0 == p) {
+		return false;
+	}
+	p->x0 = x; p->y0 = y; p->x1 = w; p->y1 = h; p->data = bitmap;
+	return true;
+}
+
+
+void EPD_GFX::draw_list(const EPD_GFX_display_list &list) {
+	const int16_t segment_top    = current_segment * pixel_height_segment;
+	const int16_t segment_bottom = segment_top + pixel_height_segment - 1;
+
+	for (uint8_t i = 0; i < list.size(); i++) {
+		const EPD_GFX_primitive &p = list[i];
+
+		//Skip anything that does not touch this segment
+		if ((p.bottom < segment_top) || (p.top > segment_bottom)) {
+			continue;
+		}
+
+		switch (p.type) {
+		case EPD_GFX_display_list::FILL_RECT:
+			fillRect(p.x0, p.y0, p.x1, p.y1, p.colour);
+			break;
+		case EPD_GFX_display_list::DRAW_RECT:
+			drawRect(p.x0, p.y0, p.x1, p.y1, p.colour);
+			break;
+		case EPD_GFX_display_list::LINE:
+			draw_line_clipped(p.x0, p.y0, p.x1, p.y1, p.colour);
+			break;
+		case EPD_GFX_display_list::DRAW_CIRCLE:
+			draw_circle_clipped(p.x0, p.y0, p.x1, p.colour);
+			break;
+		case EPD_GFX_display_list::FILL_CIRCLE:
+			fillCircle(p.x0, p.y0, p.x1, p.colour);
+			break;
+		case EPD_GFX_display_list::DRAW_TRIANGLE:
+			draw_line_clipped(p.x0, p.y0, p.x1, p.y1, p.colour);
+			draw_line_clipped(p.x1, p.y1, p.x2, p.y2, p.colour);
+			draw_line_clipped(p.x2, p.y2, p.x0, p.y0, p.colour);
+			break;
+		case EPD_GFX_display_list::FILL_TRIANGLE:
+			fillTriangle(p.x0, p.y0, p.x1, p.y1, p.x2, p.y2, p.colour);
+			break;
+		case EPD_GFX_display_list::TEXT:
+			drawText(p.x0, p.y0, (const char *)p.data, p.colour, p.bg, p.size);
+			break;
+		case EPD_GFX_display_list::BITMAP:
+			draw_bitmap_clipped(p.x0, p.y0, (const uint8_t *)p.data, p.x1, p.y1, p.colour);
+			break;
+		}
+	}
+}
+
+
+void EPD_GFX::display_list(const EPD_GFX_display_list &list, boolean clear_first) {
+	for (uint8_t s = 0; s < total_segments; s++) {
+		set_current_segment(s);  // also clears new_image
+		draw_list(list);
+		display(clear_first, s == 0, s == (total_segments - 1));
+	}
+}
+
+// Set a pixel already known to be in the current segment (x is still clipped to the panel)
+void EPD_GFX::set_pixel(int16_t x, int16_t y, uint16_t colour) {
+	if ((x < 0) || (x >= (int16_t)pixel_width)) {
+		return;
+	}
+	uint8_t *p = &this->new_image[(y - current_segment * pixel_height_segment) * (pixel_width / 8) + x / 8];
+	if (BLACK == colour) {
+		*p |= 1 << (x & 0x07);
+	} else {
+		*p &= ~(1 << (x & 0x07));
+	}
+}
+
+// Adafruit_GFX's Bresenham line, started and stopped where it enters and leaves the segment
+// After k steps along the major axis the minor axis has moved m = (k*dy - dx/2 + dx - 1) / dx
+// so the first step on a given row (and the error term there) can be worked out directly.
+void EPD_GFX::draw_line_clipped(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t colour) {
+	const int16_t segment_top    = current_segment * pixel_height_segment;
+	const int16_t segment_bottom = segment_top + pixel_height_segment - 1;
+
+	const boolean steep = abs(y1 - y0) > abs(x1 - x0);
+	int16_t t;
+	if (steep) {
+		t = x0; x0 = y0; y0 = t;
+		t = x1; x1 = y1; y1 = t;
+	}
+	if (x0 > x1) {
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+	const int32_t dx = x1 - x0;
+	const int32_t dy = abs(y1 - y0);
+	const int16_t ystep = (y0 < y1) ? 1 : -1;
+
+	int32_t k_start;
+	int32_t k_end;
+	if (steep) {
+		//Rows are the major axis
+		k_start = max((int32_t)segment_top - x0, (int32_t)0);
+		k_end = min((int32_t)segment_bottom - x0, dx);
+	} else {
+		//Rows are the minor axis: the range of minor steps that are in this segment
+		int32_t m_first = (ystep > 0) ? segment_top - y0 : y0 - segment_bottom;
+		int32_t m_last  = (ystep > 0) ? segment_bottom - y0 : y0 - segment_top;
+		if (m_first < 0) {
+			m_first = 0;
+		}
+		if (m_last < m_first) {
+			return;
+		}
+		if (0 == dy) {
+			if (0 != m_first) {
+				return;  // horizontal, on another row
+			}
+			k_start = 0;
+			k_end = dx;
+		} else {
+			//first k with m >= M is ceil(((M - 1) * dx + dx/2 + 1) / dy), 0 for M = 0
+			k_start = (0 == m_first) ? 0 : ((m_first - 1) * dx + dx / 2 + 1 + dy - 1) / dy;
+			k_end = ((m_last * dx + dx / 2 + 1 + dy - 1) / dy) - 1;
+			if (k_end > dx) {
+				k_end = dx;
+			}
+		}
+	}
+	if (k_start > k_end) {
+		return;
+	}
+
+	const int32_t m = (0 == dx) ? 0 : (k_start * dy - dx / 2 + dx - 1) / dx;
+	int32_t err = dx / 2 - k_start * dy + m * dx;
+	int16_t x = x0 + k_start;
+	int16_t y = y0 + ystep * m;
+	for (int32_t k = k_start; k <= k_end; k++, x++) {
+		if (steep) {
+			set_pixel(y, x, colour);
+		} else {
+			set_pixel(x, y, colour);
+		}
+		err -= dy;
+		if (err < 0) {
+			y += ystep;
+			err += dx;
+		}
+	}
+}
+
+// Adafruit_GFX's midpoint circle, each step writing only the octant points on rows of this segment
+void EPD_GFX::draw_circle_clipped(int16_t x0, int16_t y0, int16_t r, uint16_t colour) {
+	const int16_t segment_top    = current_segment * pixel_height_segment;
+	const int16_t segment_bottom = segment_top + pixel_height_segment - 1;
+	int16_t f = 1 - r;
+	int16_t ddF_x = 1;
+	int16_t ddF_y = -2 * r;
+	int16_t x = 0;
+	int16_t y = r;
+
+	//Rows y0 +/- r carry one point, y0 two
+	if ((y0 + r >= segment_top) && (y0 + r <= segment_bottom)) {
+		set_pixel(x0, y0 + r, colour);
+	}
+	if ((y0 - r >= segment_top) && (y0 - r <= segment_bottom)) {
+		set_pixel(x0, y0 - r, colour);
+	}
+	if ((y0 >= segment_top) && (y0 <= segment_bottom)) {
+		set_pixel(x0 + r, y0, colour);
+		set_pixel(x0 - r, y0, colour);
+	}
+
+	while (x < y) {
+		if (f >= 0) {
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+
+		//Each step touches rows y0 +/- y (at x0 +/- x) and y0 +/- x (at x0 +/- y)
+		if ((y0 + y >= segment_top) && (y0 + y <= segment_bottom)) {
+			set_pixel(x0 + x, y0 + y, colour);
+			set_pixel(x0 - x, y0 + y, colour);
+		}
+		if ((y0 - y >= segment_top) && (y0 - y <= segment_bottom)) {
+			set_pixel(x0 + x, y0 - y, colour);
+			set_pixel(x0 - x, y0 - y, colour);
+		}
+		if ((y0 + x >= segment_top) && (y0 + x <= segment_bottom)) {
+			set_pixel(x0 + y, y0 + x, colour);
+			set_pixel(x0 - y, y0 + x, colour);
+		}
+		if ((y0 - x >= segment_top) && (y0 - x <= segment_bottom)) {
+			set_pixel(x0 + y, y0 - x, colour);
+			set_pixel(x0 - y, y0 - x, colour);
+		}
+	}
+}
+
+// Adafruit_GFX's drawBitmap (MSB first rows, set bits drawn in colour, clear bits left alone)
+// for just the bitmap rows in this segment, a byte of the bitmap at a time
+void EPD_GFX::draw_bitmap_clipped(int16_t x, int16_t y, const uint8_t PROGMEM *bitmap, int16_t w, int16_t h, uint16_t colour) {
+	const int16_t segment_top = current_segment * pixel_height_segment;
+	const int16_t row_start = max(y, segment_top);
+	const int16_t row_end   = min((int16_t)(y + h), (int16_t)(segment_top + pixel_height_segment));
+	const int16_t byte_width = (w + 7) / 8;
+	const uint16_t bytes_per_row = pixel_width / 8;
+
+	for (int16_t row = row_start; row < row_end; row++) {
+		const uint8_t PROGMEM *src = bitmap + (row - y) * byte_width;
+		uint8_t *dst = &this->new_image[(row - segment_top) * bytes_per_row];
+		for (int16_t i = 0; i < w; i += 8) {
+			if ((x + i + 8 <= 0) || (x + i >= (int16_t)pixel_width)) {
+				continue;
+			}
+			//bitmap bit 7 is the leftmost pixel, new_image bit 0
+			uint8_t b = pgm_read_byte(src + i / 8);
+			uint8_t bits = 0;
+			for (uint8_t k = 0; k < 8; k++) {
+				if (b & (0x80 >> k)) {
+					bits |= 1 << k;
+				}
+			}
+			if (w - i < 8) {
+				bits &= (1 << (w - i)) - 1;
+			}
+			if (0 != bits) {
+				write_row_bits(dst, x + i, bits, (BLACK == colour) ? bits : 0);
+			}
+		}
+	}
+}
+#endif //defined(EPD_GFX_DISPLAY_LIST_SUPPORT)
+
+// Fill a rectangle clipped to the panel width and the current segment
+// The partial bytes at either end of each row are masked, the bytes between are memset
+void EPD_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) {
+	if ((w <= 0) || (h <= 0)) {
+		return;
+	}
+
+	int16_t x_end = x + w; //exclusive
+	int16_t y_end = y + h; //exclusive
+	const int16_t segment_start_row = current_segment * pixel_height_segment;
+	const int16_t segment_end_row   = segment_start_row + pixel_height_segment;
+
+	if (x < 0) {
+		x = 0;
+	}
+	if (x_end > (int16_t)pixel_width) {
+		x_end = pixel_width;
+	}
+	if (y < segment_start_row) {
+		y = segment_start_row;
+	}
+	if (y_end > segment_end_row) {
+		y_end = segment_end_row;
+	}
+	if ((x >= x_end) || (y >= y_end)) {
+		return; //nothing in this segment
+	}
+
+	const uint16_t bytes_per_row = pixel_width / 8;
+	uint16_t first_byte = x / 8;
+	uint16_t last_byte = (x_end - 1) / 8;
+	uint8_t first_mask = 0xff << (x & 0x07);           //bit 0 is the leftmost pixel
+	uint8_t last_mask = 0xff >> (7 - ((x_end - 1) & 0x07));
+	if (first_byte == last_byte) {
+		first_mask &= last_mask;
+	}
+	const uint8_t fill = (BLACK == colour) ? 0xff : 0x00;
+
+	uint8_t *row = &this->new_image[(y - segment_start_row) * bytes_per_row];
+	for (; y < y_end; ++y, row += bytes_per_row) {
+		row[first_byte] = (row[first_byte] & ~first_mask) | (fill & first_mask);
+		if (first_byte != last_byte) {
+			memset(&row[first_byte + 1], fill, last_byte - first_byte - 1);
+			row[last_byte] = (row[last_byte] & ~last_mask) | (fill & last_mask);
+		}
+	}
 }
 
 //Font from Adafruit_GFX libary
 #include "glcdfont.c"
 
+//Largest text size blitted a row at a time: 6*size pixels plus the bit offset must fit in a uint32_t
+#define EPD_GFX_BLIT_MAX_SIZE (4)
+
+// Write the pixels selected by mask (bit 0 is at x) into one row of new_image, clipped to the panel width
+void EPD_GFX::write_row_bits(uint8_t *row, int16_t x, uint32_t mask, uint32_t value) {
+	if (x < 0) {
+		if (x <= -32) {
+			return;
+		}
+		mask >>= -x;
+		value >>= -x;
+		x = 0;
+	}
+	if (x >= (int16_t)pixel_width) {
+		return;
+	}
+	if ((pixel_width - x) < 32) {
+		mask &= (1UL << (pixel_width - x)) - 1;
+	}
+
+	uint8_t *p = &row[x / 8];
+	mask <<= (x & 0x07);
+	value <<= (x & 0x07);
+	for (; 0 != mask; mask >>= 8, value >>= 8, ++p) {
+		*p = (*p & ~(uint8_t)mask) | ((uint8_t)value & (uint8_t)mask);
+	}
+}
+
+// Draw rows [row_start, row_end) of a glyph whose top left is at (x, y)
+// The rows must already be clipped to the current segment.
+// Each glyph row is turned into a horizontal bit pattern (scaled by size) and written
+// a byte at a time; big sizes are drawn as runs of span fills.
+void EPD_GFX::blit_char(int16_t x, int16_t y, unsigned char c, uint16_t colour, uint16_t bg, uint8_t size,
+                        int16_t row_start, int16_t row_end) {
+	uint8_t columns[EPD_GFX_CHAR_PADDED_WIDTH];
+	for (uint8_t i = 0; i < EPD_GFX_CHAR_BASE_WIDTH; i++) {
+		columns[i] = pgm_read_byte(font + (c * EPD_GFX_CHAR_BASE_WIDTH) + i);
+	}
+	columns[EPD_GFX_CHAR_BASE_WIDTH] = 0x00;
+
+	const boolean opaque = (bg != colour);
+	const uint16_t bytes_per_row = pixel_width / 8;
+	const int16_t segment_start_row = current_segment * pixel_height_segment;
+	const uint32_t all = (size <= EPD_GFX_BLIT_MAX_SIZE) ? (1UL << (EPD_GFX_CHAR_PADDED_WIDTH * size)) - 1 : 0;
+	const uint32_t dot = (1UL << size) - 1;
+
+	for (int16_t row = row_start; row < row_end; ) {
+		const uint8_t j = (row - y) / size;
+		int16_t next = y + (j + 1) * size;
+		if (next > row_end) {
+			next = row_end;
+		}
+
+		uint8_t pattern = 0;
+		for (uint8_t i = 0; i < EPD_GFX_CHAR_PADDED_WIDTH; i++) {
+			if (columns[i] & (1 << j)) {
+				pattern |= (1 << i);
+			}
+		}
+
+		if (size <= EPD_GFX_BLIT_MAX_SIZE) {
+			uint32_t foreground = 0;
+			for (uint8_t i = 0; i < EPD_GFX_CHAR_PADDED_WIDTH; i++) {
+				if (pattern & (1 << i)) {
+					foreground |= dot << (i * size);
+				}
+			}
+			const uint32_t mask = opaque ? all : foreground;
+			uint32_t value = (BLACK == colour) ? foreground : 0;
+			if (opaque && (BLACK == bg)) {
+				value |= all & ~foreground;
+			}
+			uint8_t *p = &this->new_image[(row - segment_start_row) * bytes_per_row];
+			for (; row < next; ++row, p += bytes_per_row) {
+				write_row_bits(p, x, mask, value);
+			}
+		} else {
+			for (uint8_t i = 0; i < EPD_GFX_CHAR_PADDED_WIDTH; ) {
+				const boolean on = (pattern >> i) & 0x01;
+				uint8_t k = i + 1;
+				while ((k < EPD_GFX_CHAR_PADDED_WIDTH) && (on == ((pattern >> k) & 0x01))) {
+					k++;
+				}
+				if (on || opaque) {
+					fillRect(x + i * size, row, (k - i) * size, next - row, on ? colour : bg);
+				}
+				i = k;
+			}
+			row = next;
+		}
+	}
+}
+
+// Clip a text line of the given size at y against the current segment
+// Returns false if none of it is in this segment
+boolean EPD_GFX::text_rows(int16_t y, uint8_t size, int16_t &row_start, int16_t &row_end) {
+	const int16_t segment_start_row = current_segment * pixel_height_segment;
+	const int16_t segment_end_row   = segment_start_row + pixel_height_segment;
+
+	row_start = max(y, segment_start_row);
+	row_end   = min((int16_t)(y + EPD_GFX_CHAR_PADDED_HEIGHT * size), segment_end_row);
+	return row_start < row_end;
+}
+
 // Draw a character
 //Override this function (so we don't need to modify the Adafruit library).
-//The changes are to:
-// * modify the check on being inside the vertical (y) segment
-//  to allow for chars that overlap segments (and also to optimise a
-//  quick return if the char won't be in a segment at all)
+//Only the rows of the char that are in the current segment are drawn, straight into new_image.
 void EPD_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
 			    uint16_t color, uint16_t bg, uint8_t size) {
-#if 0 //Original code
-//  if((x >= _width)            || // Clip right
-//     (y >= _height)           || // Clip bottom
-//     ((x + 6 * size - 1) < 0) || // Clip left
-//     ((y + 8 * size - 1) < 0))   // Clip top
-//    return;
-#else
-  if((x >= _width)            || // Clip right
-     ((x + EPD_GFX_CHAR_PADDED_WIDTH * size - 1) < 0)    // Clip left
-    )
-    return;
-#endif
-
-#if 1
-  //Check if we are doing any drawing in this segment
-  //NOTE: This is an optimisation (only for parialt segments) to save wasted cyclces getting all the way to drawPixel for many non-existent pixels for this segment.
-  const unsigned int y_end_char = y + size * (EPD_GFX_CHAR_PADDED_HEIGHT);
-  const unsigned int segment_start_row = (current_segment  )* pixel_height_segment;
-  const unsigned int segment_end_row   = (current_segment+1)* pixel_height_segment;
-  boolean draw_char = true;
-  if(y > segment_end_row)
-  {
-	  //Char starts on a later segment
-	  draw_char = false;
-  }
-  if(y_end_char < segment_start_row)
-  {
-	  //Char finished on an earlier segment
-	  draw_char = false;
-  }
-  if(!draw_char)
-  {
-    return;
-  }
-#endif
-
-  //Unchanged below (except magic numbers replaced)
-  for (int8_t i=0; i<EPD_GFX_CHAR_PADDED_WIDTH; i++ ) {
-    uint8_t line;
-    if (i == EPD_GFX_CHAR_BASE_WIDTH) 
-      line = 0x0;
-    else 
-      line = pgm_read_byte(font+(c*EPD_GFX_CHAR_BASE_WIDTH)+i);
-    for (int8_t j = 0; j<EPD_GFX_CHAR_PADDED_HEIGHT; j++) {
-      if (line & 0x1) {
-        if (size == 1) // default size
-          drawPixel(x+i, y+j, color);
-        else {  // big size
-          fillRect(x+(i*size), y+(j*size), size, size, color);
-        } 
-      } else if (bg != color) {
-        if (size == 1) // default size
-          drawPixel(x+i, y+j, bg);
-        else {  // big size
-          fillRect(x+i*size, y+j*size, size, size, bg);
-        }
-      }
-      line >>= 1;
-    }
-  }
+	int16_t row_start;
+	int16_t row_end;
+
+	if ((0 == size) ||
+	    (x >= _width) ||                                     // Clip right
+	    ((x + EPD_GFX_CHAR_PADDED_WIDTH * size - 1) < 0) ||  // Clip left
+	    !text_rows(y, size, row_start, row_end)) {           // Not in this segment
+		return;
+	}
+	blit_char(x, y, c, color, bg, size, row_start, row_end);
+}
+
+// Draw a run of text (no wrapping or control characters), clipped against the segment once
+// Returns the x just after the last char
+int16_t EPD_GFX::drawText(int16_t x, int16_t y, const char *text, uint16_t colour, uint16_t bg, uint8_t size) {
+	const int16_t advance = EPD_GFX_CHAR_PADDED_WIDTH * size;
+	int16_t row_start;
+	int16_t row_end;
+
+	if ((0 == size) || !text_rows(y, size, row_start, row_end)) {
+		//Nothing to draw here, just work out where the text ends
+		return x + strlen(text) * advance;
+	}
+	for (; '\0' != *text; ++text, x += advance) {
+		if ((x + advance) <= 0) {
+			continue;  // Still left of the panel
+		}
+		if (x >= _width) {
+			return x + strlen(text) * advance;
+		}
+		blit_char(x, y, *text, colour, bg, size, row_start, row_end);
+	}
+	return x;
 }
 
 #if defined(EPD_DRAWBITMAP_FAST_SUPPORT)
@@ -146,8 +751,15 @@ void EPD_GFX::drawBitmapFast(const uint8_t PROGMEM *bitmap, boolean subsampled_b
     this->EPD.begin();
 	this->EPD.setFactor( get_temperature() );
 	this->EPD.clear();
-	this->EPD.image( bitmap, 0, this->pixel_height, subsampled_by_2 );
+	//NOTE: Not a constant 0, that would pick the old/new image overload (as a null new image)
+	uint16_t first_line_no = 0;
+	this->EPD.image( bitmap, first_line_no, this->pixel_height, subsampled_by_2 );
 	this->EPD.end();
+
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	//The panel no longer matches the segment CRCs
+	invalidate_segments();
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
 }
 
 #endif //defined(EPD_DRAWBITMAP_FAST_SUPPORT)
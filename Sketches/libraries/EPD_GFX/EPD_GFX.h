@@ -42,7 +42,7 @@
 
 #include <Adafruit_GFX.h>
 
-//NOTE: We always do a full clear (and not a transition from the old buffer) -- slower but less SRAM used.
+//NOTE: display() clears each segment before drawing it (no old buffer, less SRAM); display_transition() and display_interleaved() go from the old scene instead, by drawing it again.
 #define EPD_GFX_HEIGHT_SEGMENT_DEFAULT (8) //<! 8 is a factor of 176(2.7") and 96(other screens). TODO: Later make this some calculation in the constructor (based on passed in memory usage requests....)
 
 #define EPD_GFX_CHAR_BASE_WIDTH  (5) //TODO: Bring out from "glcdfont.c" somehow??
@@ -53,6 +53,87 @@
 
 #define EPD_DRAWBITMAP_FAST_SUPPORT //!< Support a faster (more direct use of EPD hardware for) writing a bitmap. GFX has a drawBitmap that is just painfully slow.
 
+#if defined(EPD_OLD_IMAGE_SUPPORT)
+#define EPD_GFX_TRANSITION_SUPPORT //!< Support display_transition(): old -> new per segment by redrawing the old scene on demand (allocates a second segment buffer on first use).
+#endif
+
+#define EPD_GFX_DISPLAY_LIST_SUPPORT //!< Support recording a scene once in an EPD_GFX_display_list and replaying only the primitives that touch each segment.
+
+#define EPD_GFX_DIFFERENTIAL_UPDATE //!< Keep a CRC of what was last pushed to each segment and skip display() of unchanged segments (2 bytes and a bit of SRAM per segment).
+
+class EPD_GFX;
+
+//Draws a whole scene (for the current segment) from the application's state
+//Called once per segment, drawing outside the current segment is discarded
+typedef void EPD_GFX_draw(EPD_GFX &gfx, const void *state);
+
+#if defined(EPD_GFX_DISPLAY_LIST_SUPPORT)
+
+//One recorded drawing primitive
+typedef struct {
+	uint8_t type;
+	uint8_t colour;
+	uint8_t bg;           //text background
+	uint8_t size;         //text size
+	int16_t top;          //first row touched
+	int16_t bottom;       //last row touched
+	int16_t x0, y0, x1, y1, x2, y2;
+	const void *data;     //text (SRAM) or bitmap (PROGMEM) -- must stay valid while the list is used
+} EPD_GFX_primitive;
+
+//Retained scene: record the primitives once, then EPD_GFX replays for each
+//segment only those whose rows intersect it, clipped to its rows (instead of
+//rasterising everything once per segment). The caller supplies the storage.
+class EPD_GFX_display_list {
+private:
+	EPD_GFX_primitive *items;
+	uint8_t capacity;
+	uint8_t count;
+
+	EPD_GFX_primitive *add(uint8_t type, uint16_t colour, int16_t top, int16_t bottom);
+
+	EPD_GFX_display_list(const EPD_GFX_display_list &f);  // prevent copy
+
+public:
+	enum {
+		FILL_RECT,
+		DRAW_RECT,
+		LINE,
+		DRAW_CIRCLE,
+		FILL_CIRCLE,
+		DRAW_TRIANGLE,
+		FILL_TRIANGLE,
+		TEXT,
+		BITMAP
+	};
+
+	EPD_GFX_display_list(EPD_GFX_primitive *storage, uint8_t capacity) :
+		items(storage), capacity(capacity), count(0) {}
+
+	void clear() {
+		count = 0;
+	}
+	uint8_t size() const {
+		return count;
+	}
+	const EPD_GFX_primitive &operator[](uint8_t i) const {
+		return items[i];
+	}
+
+	//All of these return false if the list is full
+	bool fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour);
+	bool drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour);
+	bool drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t colour);
+	bool drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colour);
+	bool fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colour);
+	bool drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t colour);
+	bool fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t colour);
+	bool drawText(int16_t x, int16_t y, const char *text, uint16_t colour, uint16_t bg, uint8_t size = 1);
+	bool drawBitmap(int16_t x, int16_t y, const uint8_t PROGMEM *bitmap, int16_t w, int16_t h, uint16_t colour);
+};
+
+#endif //defined(EPD_GFX_DISPLAY_LIST_SUPPORT)
+
 class EPD_GFX : public Adafruit_GFX {
 
 private:
@@ -76,11 +157,49 @@ private:
 	uint8_t         total_segments;
 	uint8_t         current_segment;
 
+	void write_row_bits(uint8_t *row, int16_t x, uint32_t mask, uint32_t value);
+	void blit_char(int16_t x, int16_t y, unsigned char c, uint16_t colour, uint16_t bg, uint8_t size,
+	               int16_t row_start, int16_t row_end);
+	boolean text_rows(int16_t y, uint8_t size, int16_t &row_start, int16_t &row_end);
+
+#if defined(EPD_GFX_DISPLAY_LIST_SUPPORT)
+	//Display list primitives clipped to the rows of the current segment before they are drawn,
+	//giving the same pixels as Adafruit_GFX but without visiting the rows of other segments
+	void set_pixel(int16_t x, int16_t y, uint16_t colour);
+	void draw_line_clipped(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t colour);
+	void draw_circle_clipped(int16_t x0, int16_t y0, int16_t r, uint16_t colour);
+	void draw_bitmap_clipped(int16_t x, int16_t y, const uint8_t PROGMEM *bitmap, int16_t w, int16_t h, uint16_t colour);
+#endif //defined(EPD_GFX_DISPLAY_LIST_SUPPORT)
+
     //Buffer for updating display
-    //Note: This has removed the support of using a toggling buffer OLD/NEW as there is not enough SRAM for that.
+    //Note: One segment only, there is not enough SRAM for a whole OLD/NEW pair (display_transition() adds old_image below).
 	uint8_t * new_image;
+
+#if defined(EPD_GFX_TRANSITION_SUPPORT)
+	//Second segment buffer for the previous scene (only allocated if display_transition() is used)
+	uint8_t * old_image;
+#endif //defined(EPD_GFX_TRANSITION_SUPPORT)
+
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	//CRC of the segment contents currently on the panel
+	uint16_t * segment_crc;
+	uint8_t  * segment_crc_valid; //bit per segment, set once its CRC matches the panel (cleared or displayed)
+	boolean   begin_pending;     //EPD.begin() deferred until a segment actually changes
+
+	uint16_t new_image_crc();
+
+	boolean segment_valid(uint8_t s)
+	{
+	    return 0 != (segment_crc_valid[s / 8] & (1 << (s & 0x07)));
+	}
+	void set_segment_crc(uint8_t s, uint16_t crc)
+	{
+	    segment_crc[s] = crc;
+	    segment_crc_valid[s / 8] |= 1 << (s & 0x07);
+	}
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
 	
-	uint8_t get_temperature()
+	int get_temperature()
 	{
 #if defined(EPD_GFX_HARDCODED_TEMP)
 	    return temp_celsius;
@@ -130,6 +249,19 @@ public:
         //Buffer is only a subset of the total frame. We call this a segment.
     	new_image = new uint8_t[  get_segment_buffer_size_bytes() ];
     	assert( new_image );
+
+#if defined(EPD_GFX_TRANSITION_SUPPORT)
+    	old_image = 0;
+#endif //defined(EPD_GFX_TRANSITION_SUPPORT)
+
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+    	segment_crc = new uint16_t[ total_segments ];
+    	assert( segment_crc );
+    	segment_crc_valid = new uint8_t[ (total_segments + 7) / 8 ];
+    	assert( segment_crc_valid );
+    	invalidate_segments();
+    	begin_pending = false;
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
 	}
 	
 	uint16_t get_segment_buffer_size_bytes() 
@@ -137,6 +269,12 @@ public:
         return (pixel_width/8 * pixel_height_segment);
     }
 
+	//The current segment's rows as drawn so far (bit 0 of each byte is the leftmost pixel)
+	const uint8_t * get_segment_buffer()
+    {
+        return new_image;
+    }
+
 	void begin();
 	void end();
 
@@ -163,7 +301,7 @@ public:
 	//This function does not write to the buffer if the pixel is not on the current segment
 	//However it gets called MANY times that are wasteful....
 	//VERY inefficient!
-	//The calling functions can be optimised though (drawChar has been -- others not yet)
+	//The calling functions can be optimised though (drawChar and the span fills below have been)
 	void drawPixel(int16_t x, int16_t y, unsigned int colour)
 	{
 	    assert(y>=0); //BK: Not sure why it is allowed to be negative......
@@ -194,11 +332,72 @@ public:
 	}
 
 	// Change old image to new image
+	//With EPD_GFX_DIFFERENTIAL_UPDATE a segment that is unchanged since it was last displayed (or cleared) is skipped
+	//and begin is deferred until the first segment that does change (end is skipped if nothing changed).
 	void display(boolean clear_first = true, boolean begin = false, boolean end = true);
+
+#if defined(EPD_GFX_TRANSITION_SUPPORT)
+	//Change the whole panel from one scene to another without clearing it first.
+	//For every segment the old scene is redrawn from old_state (0 means the panel is white)
+	//and the new one from new_state, then EPD_compensate/EPD_white use the real old image.
+	//Segments where both scenes are identical are skipped.
+	void display_transition(EPD_GFX_draw *draw, const void *old_state, const void *new_state);
+#endif //defined(EPD_GFX_TRANSITION_SUPPORT)
+
+	//Update the whole panel inside one EPD begin/end with each stage run once for all segments:
+	//every pass of a stage redraws each segment (with draw) and sends it, round robin.
+	//old_state is the scene on the panel (used for the compensate/white stages), 0 means clear the panel first.
+	//Uses no extra SRAM but calls draw (stage passes * segments) times per stage, so keep draw cheap
+	//(e.g. a display list, see draw_list_cb).
+	void display_interleaved(EPD_GFX_draw *draw, const void *old_state, const void *new_state);
+
+#if defined(EPD_GFX_DISPLAY_LIST_SUPPORT)
+	//Draw the primitives of list that touch the current segment
+	void draw_list(const EPD_GFX_display_list &list);
+
+	//Draw and display list on every segment
+	void display_list(const EPD_GFX_display_list &list, boolean clear_first = true);
+
+	//EPD_GFX_draw adaptor: state is a const EPD_GFX_display_list *
+	//e.g. display_transition(EPD_GFX::draw_list_cb, &old_list, &new_list)
+	static void draw_list_cb(EPD_GFX &gfx, const void *list)
+	{
+	    gfx.draw_list(*(const EPD_GFX_display_list *)list);
+	}
+#endif //defined(EPD_GFX_DISPLAY_LIST_SUPPORT)
+
+#if defined(EPD_GFX_DIFFERENTIAL_UPDATE)
+	//Forget what is on the panel so the next display() of every segment is pushed
+	void invalidate_segments()
+	{
+	    memset(segment_crc_valid, 0, (total_segments + 7) / 8);
+	}
+#endif //defined(EPD_GFX_DIFFERENTIAL_UPDATE)
 	void clear();
     void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
       uint16_t bg, uint8_t size);
 
+	//Text run: clipped to the current segment once, then each glyph is blitted into new_image
+	//Returns the x after the text (6*size per char)
+	int16_t drawText(int16_t x, int16_t y, const char *text, uint16_t colour, uint16_t bg, uint8_t size = 1);
+
+	//Span fills: clip once against the current segment and write whole bytes of new_image
+	//(instead of a drawPixel per pixel). fillTriangle/fillCircle/drawRect go through these too.
+	void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour);
+	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t colour)
+	{
+	    fillRect(x, y, w, 1, colour);
+	}
+	void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t colour)
+	{
+	    fillRect(x, y, 1, h, colour);
+	}
+	//NOTE: Adafruit_GFX only knows the segment height so its fillScreen would only cover the first segment
+	void fillScreen(uint16_t colour)
+	{
+	    memset(this->new_image, (BLACK == colour) ? 0xff : 0x00, pixel_width/8 * pixel_height_segment);
+	}
+
 
 #if defined(EPD_DRAWBITMAP_FAST_SUPPORT)
     void drawBitmapFast(const uint8_t PROGMEM *bitmap, boolean subsampled_by_2);
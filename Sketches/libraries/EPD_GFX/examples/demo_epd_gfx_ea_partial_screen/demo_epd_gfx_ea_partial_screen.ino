@@ -33,11 +33,13 @@
 
 // required libraries
 #include <SPI.h>
+#include <SPI_BUS.h>
 #ifndef EMBEDDED_ARTISTS
 #include <FLASH.h>
 #endif /* EMBEDDED_ARTISTS */
 #include <EPD.h>
 //Temperature sensor
+#include <TEMPERATURE.h>
 #ifndef EMBEDDED_ARTISTS
 #include <S5813A.h>
 #else /* EMBEDDED_ARTISTS */
@@ -256,6 +258,11 @@ CStopwatch stopwatch_loop_draw_only("LoopDrawOnly");
 #endif //defined(PROFILE)
 
 static int counter = 0;
+
+// the scene: 2 rectangles, a line and up to 6 runs of text
+static EPD_GFX_primitive scene_items[9];
+static EPD_GFX_display_list scene(scene_items, sizeof(scene_items) / sizeof(scene_items[0]));
+
 // main loop
 void loop() {
 #if defined(PROFILE)
@@ -284,107 +291,63 @@ void loop() {
         Serial.println( "-----------------------------------------------" );
 #endif //defined(VERBOSE)
 
-        for(unsigned int s=0; s < segments; s++)
-        {
 #if defined(PROFILE)
-          stopwatch_loop_draw_only.Start();
+        stopwatch_loop_draw_only.Start();
 #endif //defined(PROFILE)
-          int starting_row_this_segment = s * seg_h;
 #if defined(VERBOSE)
-          Serial.print( "Segment " );Serial.print( s );
-          Serial.print(" | ");
+        Serial.print("Recording:");
+        Serial.print(" Rect.");
 #endif //defined(VERBOSE)
+        //Record the scene once, display_list() then draws on each segment
+        //only the primitives that reach it, clipped to its rows
+        scene.clear();
 
-          G_EPD.set_current_segment(s);
-#if defined(VERBOSE)
-          Serial.print("Drawing:");
-          Serial.print(" Rect.");
-#endif //defined(VERBOSE)
-          //Rectangle only on segment 0. Make it slide across the screen on each loop
-          //Optimise a little by only executing on the first segment
-          if (s == 0)
-          {
-            G_EPD.drawRect(counter%(w/2), 0, w/2, seg_h, EPD_GFX::BLACK);
-          }
-          
-          //Rectangle in middle of screen across segments
-          //We could limit to just the segments it is on -- but we can also just call for each segment (at the cost of wasted drawPixels that do nothing useful)
-          G_EPD.drawRect((counter + w/5)%(w/2), seg_h/2, w/3, h/2, EPD_GFX::BLACK);
+        //Rectangle on the rows of segment 0. Make it slide across the screen on each loop
+        scene.drawRect(counter%(w/2), 0, w/2, seg_h, EPD_GFX::BLACK);
+
+        //Rectangle in middle of screen across segments
+        scene.drawRect((counter + w/5)%(w/2), seg_h/2, w/3, h/2, EPD_GFX::BLACK);
 #if defined(VERBOSE)
-          Serial.print(" Line.");
+        Serial.print(" Line.");
 #endif //defined(VERBOSE)
-          //Vertical line down entire screen
-          G_EPD.drawLine( w*3/4, 0, w*3/4, h-1, EPD_GFX::BLACK);   //This is inclusive so has dest pixels inside the border
+        //Vertical line down entire screen
+        scene.drawLine( w*3/4, 0, w*3/4, h-1, EPD_GFX::BLACK);   //This is inclusive so has dest pixels inside the border
 
 #if defined(VERBOSE)
-          Serial.print(" Text=");
+        Serial.print(" Text=Some.");
 #endif //defined(VERBOSE)
-          //Write text on a some segments (if big enough....)
-          if(( s == 0 ) ||
-            ((segments>=3) && (( s == (segments-2) ) || ( s == (segments-1) ))) ||
-            ((segments>=5) && (( s == (segments-3) ) || ( s == (segments-4) )))
-          )
+        //Write text on a some segments (if big enough....)
+        if(seg_h >= EPD_GFX_CHAR_BASE_HEIGHT)
+        {
+          for(unsigned int s=0; s < segments; s++)
           {
-            if(seg_h >= EPD_GFX_CHAR_BASE_HEIGHT)
+            if(( s == 0 ) ||
+              ((segments>=3) && (( s == (segments-2) ) || ( s == (segments-1) ))) ||
+              ((segments>=5) && (( s == (segments-3) ) || ( s == (segments-4) )))
+            )
             {
-              char temp[] = "Some";
-#if defined(VERBOSE)
-              Serial.print(temp);
-              Serial.print(".");
-#endif //defined(VERBOSE)
-              unsigned int x = 2;
-              unsigned int y = 1 + starting_row_this_segment; //Put on each segment
               unsigned int char_size_multiplier = (seg_h/EPD_GFX_CHAR_BASE_HEIGHT); //Make as big as we can
-              for (unsigned int j = 0; j < sizeof(temp) - 1; ++j, x += (char_size_multiplier * (EPD_GFX_CHAR_BASE_WIDTH + 1)))
-              {
-                  //Serial.print("Letter=");Serial.println( temp[j] );
-                  G_EPD.drawChar(x, y, temp[j], EPD_GFX::BLACK, EPD_GFX::WHITE, char_size_multiplier );
-              }
+              scene.drawText(2, 1 + s * seg_h, "Some", EPD_GFX::BLACK, EPD_GFX::WHITE, char_size_multiplier);
             }
           }
+        }
 
 #if defined(VERBOSE)
-          Serial.print(" Text=");
-#endif //defined(VERBOSE)
-
-          //Write text across segments
-          {
-            char temp[] = "Across";
-#if defined(VERBOSE)
-            Serial.print(temp);
-            Serial.print(".");
-#endif //defined(VERBOSE)
-            unsigned int x = w/16;
-            unsigned int y = h/6;
-            unsigned int char_size_multiplier = 6;
-            for (unsigned int j = 0; j < sizeof(temp) - 1; ++j, x += (char_size_multiplier * (EPD_GFX_CHAR_BASE_WIDTH + 1)))
-            {
-                //Serial.print("Letter=");Serial.println( temp[j] );
-                G_EPD.drawChar(x, y, temp[j], EPD_GFX::BLACK, EPD_GFX::WHITE, char_size_multiplier );
-    	    }
-          }
-#if defined(VERBOSE)
-          Serial.println();
+        Serial.println(" Text=Across.");
 #endif //defined(VERBOSE)
+        //Write text across segments
+        scene.drawText(w/16, h/6, "Across", EPD_GFX::BLACK, EPD_GFX::WHITE, 6);
 
 #if defined(PROFILE)
-          stopwatch_loop_draw_only.Stop();
+        stopwatch_loop_draw_only.Stop();
+        stopwatch_loop_display_only.Start();
 #endif //defined(PROFILE)
 
+        // Update the display, all segments inside one begin/end
+        G_EPD.display_list(scene, false);
 #if defined(PROFILE)
-          stopwatch_loop_display_only.Start();
+        stopwatch_loop_display_only.Stop();
 #endif //defined(PROFILE)
-
-#if defined(VERBOSE)
-          Serial.print( "Display segment " );Serial.println( s );
-#endif //defined(VERBOSE)
-          // Update the display -- first and last segments of a loop are indicated
-          G_EPD.display( false, s==0, s==(segments-1) );
-#if defined(PROFILE)
-          stopwatch_loop_display_only.Stop();
-#endif //defined(PROFILE)
-          
-        }
         counter+=5;
 
 #if defined(PROFILE)
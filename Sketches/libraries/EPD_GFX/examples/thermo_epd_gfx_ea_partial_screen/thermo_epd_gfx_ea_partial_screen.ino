@@ -35,11 +35,13 @@
 
 // required libraries
 #include <SPI.h>
+#include <SPI_BUS.h>
 #ifndef EMBEDDED_ARTISTS
 #include <FLASH.h>
 #endif /* EMBEDDED_ARTISTS */
 #include <EPD.h>
 //Temperature sensor
+#include <TEMPERATURE.h>
 #ifndef EMBEDDED_ARTISTS
 #include <S5813A.h>
 #else /* EMBEDDED_ARTISTS */
@@ -240,6 +242,75 @@ void setup() {
 }
 
 
+// temperature shown by the previous loop (the panel is white after setup)
+static int old_temperature;
+static bool have_old_temperature = false;
+
+// Draw the whole thermo scene for the current segment
+// state points to the temperature to show
+static void draw_thermo(EPD_GFX &g, const void *state) {
+	int temperature = *(const int *)state;
+	int h = g.real_height();
+	int w = g.width();
+
+	//Below is the original thermo code
+	g.drawRect(1, 1, w - 2, h - 2, EPD_GFX::BLACK);
+	g.drawRect(3, 3, w - 6, h - 6, EPD_GFX::BLACK);
+
+	//Note -these are not proportionally to the screen size.
+	g.fillTriangle(135,20, 186,40, 152,84, EPD_GFX::BLACK);
+	g.fillTriangle(139,26, 180,44, 155,68, EPD_GFX::WHITE);
+
+	char temp[sizeof("-999 C")];
+	snprintf(temp, sizeof(temp), "%4d C", temperature);
+
+	int x = 20;
+	int y = 30;
+	for (unsigned int i = 0; i < sizeof(temp) - 1; ++i, x += 14) {
+		g.drawChar(x, y, temp[i], EPD_GFX::BLACK, EPD_GFX::WHITE, 2);
+	}
+
+	// small circle for degrees symbol
+	g.drawCircle(20 + 4 * 14 + 6, 30, 4, EPD_GFX::BLACK);
+
+// 100 difference just to simplify things
+// so 1 pixel = 1 degree
+#define T_MIN (-10)
+#define T_MAX 80
+
+	// clip
+	if (temperature < T_MIN) {
+		temperature= T_MIN;
+	} else if (temperature > T_MAX) {
+		temperature = T_MAX;
+	}
+
+	// temperature bar
+	int bar_w = temperature - T_MIN;  // zero based
+	int bar_h = 4;
+	int bar_x0 = 24;
+	int bar_y0 = 60;
+
+	g.fillRect(bar_x0, bar_y0, T_MAX - T_MIN, bar_h, EPD_GFX::WHITE);
+	g.fillRect(bar_x0, bar_y0, bar_w, bar_h, EPD_GFX::BLACK);
+
+	// scale
+	for (int t0 = T_MIN; t0 < T_MAX; t0 += 5) {
+		int t = t0 - T_MIN;
+		int tick = 8;
+		if (0 == t0) {
+			tick = 12;
+			g.drawCircle(bar_x0 + t, bar_y0 + 16, 3, EPD_GFX::BLACK);
+		} else if (0 == t0 % 10) {
+			tick = 10;
+		}
+		g.drawLine(bar_x0 + t, bar_y0 + tick, bar_x0 + t, bar_y0 + 6, EPD_GFX::BLACK);
+		g.drawLine(bar_x0 + t, bar_y0 + 6, bar_x0 + t + 5, bar_y0 + 6, EPD_GFX::BLACK);
+		g.drawLine(bar_x0 + t + 5, bar_y0 + 6, bar_x0 + t + 5, bar_y0 + 8, EPD_GFX::BLACK);
+	}
+}
+
+
 // main loop
 void loop() {
         long start_loop_ms = millis();
@@ -267,75 +338,13 @@ void loop() {
 	Serial.print(") : Width=");
 	Serial.println(w);
         
-        //Always cleared before we get here.
         Serial.println( "-----------------------------------------------" );
 
-        for(unsigned int s=0; s < segments; s++)
-        {
-          Serial.print( "Segment " );Serial.print( s );
-          Serial.print(" | ");
-          G_EPD.set_current_segment(s);
-
-          //Below is the original thermo code
-          G_EPD.drawRect(1, 1, w - 2, h - 2, EPD_GFX::BLACK);
-          G_EPD.drawRect(3, 3, w - 6, h - 6, EPD_GFX::BLACK);
-
-          //Note -these are not proportionally to the screen size.
-  	  G_EPD.fillTriangle(135,20, 186,40, 152,84, EPD_GFX::BLACK);
-  	  G_EPD.fillTriangle(139,26, 180,44, 155,68, EPD_GFX::WHITE);
-
-  	  char temp[sizeof("-999 C")];
-  	  snprintf(temp, sizeof(temp), "%4d C", temperature);
-  
-          int x = 20;
-          int y = 30;
-          for (unsigned int i = 0; i < sizeof(temp) - 1; ++i, x += 14) {
-              G_EPD.drawChar(x, y, temp[i], EPD_GFX::BLACK, EPD_GFX::WHITE, 2);
-          }
-  
-          // small circle for degrees symbol
-          G_EPD.drawCircle(20 + 4 * 14 + 6, 30, 4, EPD_GFX::BLACK);
-
-  // 100 difference just to simplify things
-  // so 1 pixel = 1 degree
-  #define T_MIN (-10)
-  #define T_MAX 80
-  
-          // clip
-          if (temperature < T_MIN) {
-  		temperature= T_MIN;
-          } else if (temperature > T_MAX) {
-  		temperature = T_MAX;
-          }
-  
-          // temperature bar
-          int bar_w = temperature - T_MIN;  // zero based
-          int bar_h = 4;
-          int bar_x0 = 24;
-          int bar_y0 = 60;
-  
-          G_EPD.fillRect(bar_x0, bar_y0, T_MAX - T_MIN, bar_h, EPD_GFX::WHITE);
-          G_EPD.fillRect(bar_x0, bar_y0, bar_w, bar_h, EPD_GFX::BLACK);
-  
-          // scale
-          for (int t0 = T_MIN; t0 < T_MAX; t0 += 5) {
-          	int t = t0 - T_MIN;
-          	int tick = 8;
-          	if (0 == t0) {
-          		tick = 12;
-          		G_EPD.drawCircle(bar_x0 + t, bar_y0 + 16, 3, EPD_GFX::BLACK);
-          	} else if (0 == t0 % 10) {
-          		tick = 10;
-          	}
-          	G_EPD.drawLine(bar_x0 + t, bar_y0 + tick, bar_x0 + t, bar_y0 + 6, EPD_GFX::BLACK);
-          	G_EPD.drawLine(bar_x0 + t, bar_y0 + 6, bar_x0 + t + 5, bar_y0 + 6, EPD_GFX::BLACK);
-          	G_EPD.drawLine(bar_x0 + t + 5, bar_y0 + 6, bar_x0 + t + 5, bar_y0 + 8, EPD_GFX::BLACK);
-          }
-
-          Serial.print( "Display segment " );Serial.println( s );
-          // Update the display -- first and last segments of a loop are indicated
-          G_EPD.display( false, s==0, s==(segments-1) );
-        }
+        // Change from the previous reading to the new one, segment by segment
+        // (the old scene is redrawn for each segment so there is no full clear)
+        G_EPD.display_transition(draw_thermo, have_old_temperature ? &old_temperature : 0, &temperature);
+        old_temperature = temperature;
+        have_old_temperature = true;
 
         Serial.println( "++++++++++++++++++++++++++++++++++++++++++++++++++" );
 
@@ -352,8 +361,5 @@ void loop() {
 		  digitalWrite(Pin_RED_LED, LED_OFF);
 		  delay(50);
 	}
-
-	Serial.println("Clearing.");
-        G_EPD.clear( );
 }
 
@@ -16,6 +16,7 @@
 #include <Arduino.h>
 
 #include <SPI.h>
+#include <SPI_BUS.h>
 
 #include "FLASH.h"
 
@@ -65,13 +66,20 @@ FLASH_Class FLASH(12);
 
 
 FLASH_Class::FLASH_Class(int chip_select_pin) : CS(chip_select_pin) {
+	this->spi.bit_order = MSBFIRST;
+	this->spi.data_mode = SPI_MODE3;
+	this->spi.clock_divider = SPI_CLOCK_DIV4;
+	this->spi.select_pin = -1;
+	this->spi.select_level = LOW;
 }
 
 
-void FLASH_Class::begin(int chip_select_pin) {
+void FLASH_Class::begin(int chip_select_pin, int8_t select_pin, uint8_t select_level) {
 	digitalWrite(chip_select_pin, HIGH);
 	pinMode(chip_select_pin, OUTPUT);
 	this->CS = chip_select_pin;
+	this->spi.select_pin = select_pin;
+	this->spi.select_level = select_level;
 }
 
 
@@ -79,25 +87,20 @@ void FLASH_Class::end() {
 }
 
 // configure the SPI for FLASH access
+// the settle time and flush are only needed if another device had the bus
 void FLASH_Class::spi_setup() {
-	SPI.begin();
-	SPI.setBitOrder(MSBFIRST);
-	SPI.setDataMode(SPI_MODE3);
-	SPI.setClockDivider(SPI_CLOCK_DIV4);
-	Delay_us(10);
-
 	digitalWrite(this->CS, HIGH);
-	SPI.transfer(FLASH_NOP); // flush the SPI buffer
-	// SPI.transfer(FLASH_NOP); // ..
-	// SPI.transfer(FLASH_NOP); // ..
-	Delay_us(50);
+	if (SPI_BUS.acquire(&this->spi)) {
+		Delay_us(10);
+		SPI.transfer(FLASH_NOP); // flush the SPI buffer
+		Delay_us(50);
+	}
 }
 
-// shutdown SPI after FLASH access
+// end of a FLASH access, the SPI settings are kept for the next one
 void FLASH_Class::spi_teardown() {
-	Delay_us(50);
 	digitalWrite(this->CS, HIGH);
-	SPI.end();
+	SPI_BUS.deselect();
 }
 
 // return true if the chip is supported
@@ -129,6 +132,16 @@ void FLASH_Class::info(uint8_t *maufacturer, uint16_t *device) {
 
 
 void FLASH_Class::read(void *buffer, uint32_t address, uint16_t length) {
+	this->begin_stream(address);
+	this->read_next(buffer, length);
+	this->end_stream();
+}
+
+
+// start a read that continues across any number of read_next() calls
+// the SPI setup and the command are only done once, so sequential reads
+// only cost the data bytes; nothing else may use the SPI bus until end_stream()
+void FLASH_Class::begin_stream(uint32_t address) {
 	this->spi_setup();
 	digitalWrite(this->CS, LOW);
 	Delay_us(10);
@@ -137,29 +150,37 @@ void FLASH_Class::read(void *buffer, uint32_t address, uint16_t length) {
 	SPI.transfer(address >> 8);
 	SPI.transfer(address);
 	SPI.transfer(FLASH_NOP); // read dummy byte
+}
+
+
+void FLASH_Class::read_next(void *buffer, uint16_t length) {
 	for (uint8_t *p = (uint8_t *)buffer; length != 0; --length) {
 		*p++ = SPI.transfer(FLASH_NOP);
 	}
+}
+
+
+void FLASH_Class::end_stream() {
 	this->spi_teardown();
 }
 
 
-bool FLASH_Class::is_busy(void) {
+// wait for a program or erase to finish
+// the status register is sent continuously so only one command is needed
+void FLASH_Class::wait_ready(void) {
 	this->spi_setup();
 	digitalWrite(this->CS, LOW);
 	Delay_us(10);
 	SPI.transfer(FLASH_RDSR);
-	bool busy = 0 != (FLASH_WIP & SPI.transfer(0xff));
-	digitalWrite(this->CS, HIGH);
-	SPI.transfer(FLASH_NOP);
-	Delay_us(50);
-	return busy;
+	while (0 != (FLASH_WIP & SPI.transfer(FLASH_NOP))) {
+	}
+	this->spi_teardown();
 }
 
 
 void FLASH_Class::write_enable(void) {
-	while (this->is_busy()) {
-	}
+	this->wait_ready();
+	this->spi_setup();
 	digitalWrite(this->CS, LOW);
 	Delay_us(10);
 	SPI.transfer(FLASH_WREN);
@@ -169,9 +190,8 @@ void FLASH_Class::write_enable(void) {
 
 
 void FLASH_Class::write_disable(void) {
-	while (this->is_busy()) {
-	}
-
+	this->wait_ready();
+	this->spi_setup();
 	digitalWrite(this->CS, LOW);
 	Delay_us(10);
 	SPI.transfer(FLASH_WRDI);
@@ -180,8 +200,8 @@ void FLASH_Class::write_disable(void) {
 
 
 void FLASH_Class::write(uint32_t address, const void *buffer, uint16_t length, bool buffer_in_progmem) {
-	while (this->is_busy()) {
-	}
+	this->wait_ready();
+	this->spi_setup();
 
 	digitalWrite(this->CS, LOW);
 	Delay_us(10);
@@ -210,8 +230,8 @@ void FLASH_Class::write(uint32_t address, const void *buffer, uint16_t length, b
 
 
 void FLASH_Class::sector_erase(uint32_t address) {
-	while (this->is_busy()) {
-	}
+	this->wait_ready();
+	this->spi_setup();
 
 	digitalWrite(this->CS, LOW);
 	Delay_us(10);
@@ -221,3 +241,63 @@ void FLASH_Class::sector_erase(uint32_t address) {
 	SPI.transfer(address);
 	this->spi_teardown();
 }
+
+
+FLASH_page_writer::FLASH_page_writer(FLASH_Class &flash, uint32_t address, bool erase) :
+	flash(flash), erase(erase) {
+	this->page_address = address & ~(uint32_t)(FLASH_PAGE_SIZE - 1);
+	this->start = address & (FLASH_PAGE_SIZE - 1);
+	this->fill = this->start;
+	this->erased = address & ~(uint32_t)(FLASH_SECTOR_SIZE - 1);
+}
+
+
+void FLASH_page_writer::flush(void) {
+	if (this->fill == this->start) {
+		return;
+	}
+	if (this->erase && this->page_address + this->fill > this->erased) {
+		this->flash.write_enable();
+		this->flash.sector_erase(this->erased);
+		this->erased += FLASH_SECTOR_SIZE;
+	}
+	// the page does not cross a sector or a FLASH page, the chip will
+	// still be busy with the last one when the next flush() starts
+	this->flash.write_enable();
+	this->flash.write(this->page_address + this->start, &this->page[this->start], this->fill - this->start);
+	this->page_address += FLASH_PAGE_SIZE;
+	this->start = 0;
+	this->fill = 0;
+}
+
+
+void FLASH_page_writer::write(const void *buffer, uint16_t length, bool buffer_in_progmem) {
+	const uint8_t *p = (const uint8_t *)buffer;
+	while (0 != length) {
+		uint16_t n = FLASH_PAGE_SIZE - this->fill;
+		if (n > length) {
+			n = length;
+		}
+		length -= n;
+		for (uint8_t *q = &this->page[this->fill]; n != 0; --n, ++p) {
+			// AVR has multiple memory spaces
+			if (buffer_in_progmem) {
+				*q++ = pgm_read_byte_near(p);
+			} else {
+				*q++ = *p;
+			}
+			++this->fill;
+		}
+		if (FLASH_PAGE_SIZE == this->fill) {
+			this->flush();
+		}
+	}
+}
+
+
+uint32_t FLASH_page_writer::finish(void) {
+	uint32_t end = this->position();
+	this->flush();
+	this->flash.write_disable();
+	return end;
+}
@@ -16,6 +16,7 @@
 #define EPD_FLASH_H 1
 
 #include <Arduino.h>
+#include <SPI_BUS.h>
 
 
 // maximum bytes that can be written by one write command
@@ -34,16 +35,23 @@
 class FLASH_Class {
 private:
 	int CS;
+	SPI_BUS_device spi;
 
 	void spi_setup(void);
 	void spi_teardown(void);
-	bool is_busy(void);
+	void wait_ready(void);
 	FLASH_Class(const FLASH_Class &f);  // prevent copy
 
 public:
 	bool available(void);
 	void info(uint8_t *maufacturer, uint16_t *device);
 	void read(void *buffer, uint32_t address, uint16_t length);
+
+	// sequential read session (one FAST_READ for all the read_next() calls)
+	void begin_stream(uint32_t address);
+	void read_next(void *buffer, uint16_t length);
+	void end_stream();
+
 	void write_enable(void);
 	void write_disable(void);
 	void write(uint32_t address, const void *buffer, uint16_t length, bool buffer_in_progmem = false);
@@ -52,7 +60,9 @@ public:
 	// inline static void attachInterrupt();
 	// inline static void detachInterrupt();
 
-	void begin(int chip_select_pin);
+	// select_pin/select_level: extra pin to hold while the FLASH is in use
+	// e.g. begin(Pin_EPD_CS, Pin_PANEL_ON, LOW) for the EA board's shared chip select
+	void begin(int chip_select_pin, int8_t select_pin = -1, uint8_t select_level = LOW);
 	void end();
 
 	FLASH_Class(int chip_select_pin);
@@ -61,6 +71,39 @@ public:
 
 extern FLASH_Class FLASH;
 
+
+// sequential writer that collects data into FLASH_PAGE_SIZE page programs
+// each program is started without waiting for it to finish, so the chip
+// programs while the caller fetches the next page of data (e.g. from Serial)
+// with erase set each sector is erased when the writer first reaches it
+// (including the sector of address, so start on a sector boundary)
+class FLASH_page_writer {
+private:
+	FLASH_Class &flash;
+	uint32_t page_address;  // address of page[0]
+	uint16_t start;         // first valid byte in page
+	uint16_t fill;          // end of the valid bytes in page
+	bool erase;
+	uint32_t erased;        // end of the sectors erased so far
+	uint8_t page[FLASH_PAGE_SIZE];
+
+	void flush(void);
+	FLASH_page_writer(const FLASH_page_writer &w);  // prevent copy
+
+public:
+	FLASH_page_writer(FLASH_Class &flash, uint32_t address, bool erase = true);
+
+	void write(const void *buffer, uint16_t length, bool buffer_in_progmem = false);
+
+	// program the remaining partial page and wait for the chip
+	// returns the address after the last byte written
+	uint32_t finish(void);
+
+	uint32_t position(void) {
+		return this->page_address + this->fill;
+	}
+};
+
 #endif
 
 
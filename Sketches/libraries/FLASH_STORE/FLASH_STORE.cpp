@@ -0,0 +1,384 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <Arduino.h>
+#include <string.h>
+
+#include <FLASH.h>
+
+#include "FLASH_STORE.h"
+
+
+// directory header (first FLASH_STORE_ENTRY_SIZE bytes of a directory sector,
+// the unused part stays erased)
+typedef struct {
+	char magic[4];          // FLASH_STORE_MAGIC
+	uint8_t version;        // FLASH_STORE_VERSION
+	uint8_t entry_size;     // FLASH_STORE_ENTRY_SIZE
+	uint8_t entries;        // FLASH_STORE_ENTRIES
+	uint8_t reserved;
+	uint16_t sequence;      // incremented each time the directory is moved
+} FLASH_STORE_header;
+
+
+// the default image store
+FLASH_STORE_Class FLASH_STORE;
+
+
+FLASH_STORE_Class::FLASH_STORE_Class() : directory(0xff), sequence(0), free_slots(0), deleted_slots(0),
+	next_sector(FLASH_STORE_FIRST_DATA_SECTOR) {
+	memset(this->used, 0, sizeof(this->used));
+}
+
+
+uint32_t FLASH_STORE_Class::entry_address(uint8_t directory, uint8_t id) {
+	return ((uint32_t)directory << FLASH_SECTOR_SHIFT) + (uint16_t)(id + 1) * FLASH_STORE_ENTRY_SIZE;
+}
+
+
+bool FLASH_STORE_Class::read_header(uint8_t sector, uint16_t *sequence) {
+	FLASH_STORE_header header;
+	FLASH.read(&header, (uint32_t)sector << FLASH_SECTOR_SHIFT, sizeof(header));
+	if (0 != memcmp(header.magic, FLASH_STORE_MAGIC, sizeof(header.magic))
+	    || FLASH_STORE_VERSION != header.version
+	    || FLASH_STORE_ENTRY_SIZE != header.entry_size
+	    || FLASH_STORE_ENTRIES != header.entries) {
+		return false;
+	}
+	*sequence = header.sequence;
+	return true;
+}
+
+
+void FLASH_STORE_Class::write_header(uint8_t sector, uint16_t sequence) {
+	FLASH_STORE_header header;
+	memcpy(header.magic, FLASH_STORE_MAGIC, sizeof(header.magic));
+	header.version = FLASH_STORE_VERSION;
+	header.entry_size = FLASH_STORE_ENTRY_SIZE;
+	header.entries = FLASH_STORE_ENTRIES;
+	header.reserved = 0xff;
+	header.sequence = sequence;
+	FLASH.write_enable();
+	FLASH.write((uint32_t)sector << FLASH_SECTOR_SHIFT, &header, sizeof(header));
+	FLASH.write_disable();
+}
+
+
+void FLASH_STORE_Class::mark(const FLASH_STORE_entry *entry, bool in_use) {
+	for (uint16_t s = entry->first_sector; s < entry->first_sector + entry->sector_count && s < FLASH_SECTOR_COUNT; ++s) {
+		if (in_use) {
+			this->used[s >> 3] |= 1 << (s & 0x07);
+		} else {
+			this->used[s >> 3] &= ~(1 << (s & 0x07));
+		}
+	}
+}
+
+
+bool FLASH_STORE_Class::begin(void) {
+	uint16_t sequence0;
+	uint16_t sequence1;
+	bool valid0 = this->read_header(FLASH_STORE_DIRECTORY_SECTOR, &sequence0);
+	bool valid1 = this->read_header(FLASH_STORE_DIRECTORY_SECTOR + 1, &sequence1);
+
+	// both can be valid if power failed while compacting, the newer one is complete
+	if (valid0 && (!valid1 || (int16_t)(sequence0 - sequence1) > 0)) {
+		this->directory = FLASH_STORE_DIRECTORY_SECTOR;
+		this->sequence = sequence0;
+	} else if (valid1) {
+		this->directory = FLASH_STORE_DIRECTORY_SECTOR + 1;
+		this->sequence = sequence1;
+	} else {
+		this->directory = 0xff;
+		return false;
+	}
+
+	memset(this->used, 0, sizeof(this->used));
+	this->free_slots = 0;
+	this->deleted_slots = 0;
+
+	FLASH_STORE_entry entry;
+	FLASH.begin_stream(entry_address(this->directory, 0));
+	for (uint8_t id = 0; id < FLASH_STORE_ENTRIES; ++id) {
+		FLASH.read_next(&entry, sizeof(entry));
+		if (FLASH_STORE_VALID == entry.state) {
+			this->mark(&entry, true);
+		} else if (FLASH_STORE_EMPTY == entry.state) {
+			++this->free_slots;
+		} else {
+			++this->deleted_slots;
+		}
+	}
+	FLASH.end_stream();
+
+	// allocate after the last image
+	this->next_sector = FLASH_STORE_FIRST_DATA_SECTOR;
+	for (uint16_t s = FLASH_STORE_FIRST_DATA_SECTOR; s < FLASH_SECTOR_COUNT; ++s) {
+		if (0 != (this->used[s >> 3] & (1 << (s & 0x07)))) {
+			this->next_sector = s + 1;
+		}
+	}
+	return true;
+}
+
+
+void FLASH_STORE_Class::format(void) {
+	for (uint8_t i = 0; i < 2; ++i) {
+		FLASH.write_enable();
+		FLASH.sector_erase((uint32_t)(FLASH_STORE_DIRECTORY_SECTOR + i) << FLASH_SECTOR_SHIFT);
+	}
+	this->write_header(FLASH_STORE_DIRECTORY_SECTOR, 0);
+	this->begin();
+}
+
+
+bool FLASH_STORE_Class::get(uint8_t id, FLASH_STORE_entry *entry) {
+	if (!this->mounted() || id >= FLASH_STORE_ENTRIES) {
+		return false;
+	}
+	FLASH.read(entry, entry_address(this->directory, id), sizeof(*entry));
+	return FLASH_STORE_VALID == entry->state;
+}
+
+
+int16_t FLASH_STORE_Class::find(const char *name, FLASH_STORE_entry *entry) {
+	if (!this->mounted()) {
+		return -1;
+	}
+	int16_t found = -1;
+	FLASH.begin_stream(entry_address(this->directory, 0));
+	for (uint8_t id = 0; id < FLASH_STORE_ENTRIES; ++id) {
+		FLASH.read_next(entry, sizeof(*entry));
+		if (FLASH_STORE_VALID == entry->state
+		    && 0 == strncmp(entry->name, name, sizeof(entry->name))) {
+			found = id;
+			break;
+		}
+	}
+	FLASH.end_stream();
+	return found;
+}
+
+
+int16_t FLASH_STORE_Class::next(uint8_t id, FLASH_STORE_entry *entry) {
+	if (!this->mounted() || id >= FLASH_STORE_ENTRIES) {
+		return -1;
+	}
+	int16_t found = -1;
+	FLASH.begin_stream(entry_address(this->directory, id));
+	for (; id < FLASH_STORE_ENTRIES; ++id) {
+		FLASH.read_next(entry, sizeof(*entry));
+		if (FLASH_STORE_VALID == entry->state) {
+			found = id;
+			break;
+		}
+	}
+	FLASH.end_stream();
+	return found;
+}
+
+
+// first sector of the first run of count free sectors in from..FLASH_SECTOR_COUNT-1
+int16_t FLASH_STORE_Class::free_run(uint16_t from, uint16_t count) {
+	uint16_t run = 0;
+	for (uint16_t s = from; s < FLASH_SECTOR_COUNT; ++s) {
+		if (0 != (this->used[s >> 3] & (1 << (s & 0x07)))) {
+			run = 0;
+		} else if (++run == count) {
+			return s + 1 - count;
+		}
+	}
+	return -1;
+}
+
+
+int16_t FLASH_STORE_Class::allocate(uint32_t length, bool erase) {
+	if (!this->mounted()) {
+		return -1;
+	}
+	uint16_t count = (length + FLASH_SECTOR_SIZE - 1) >> FLASH_SECTOR_SHIFT;
+	if (0 == count) {
+		count = 1;
+	}
+
+	// next fit, wrapping round to the first data sector
+	int16_t first = this->free_run(this->next_sector, count);
+	if (first < 0) {
+		first = this->free_run(FLASH_STORE_FIRST_DATA_SECTOR, count);
+		if (first < 0) {
+			return -1;
+		}
+	}
+	if (erase) {
+		for (uint16_t i = first; i < first + count; ++i) {
+			FLASH.write_enable();
+			FLASH.sector_erase((uint32_t)i << FLASH_SECTOR_SHIFT);
+		}
+		FLASH.write_disable();
+	}
+	this->next_sector = first + count;
+	return first;
+}
+
+
+// copy the valid entries into the other directory sector (keeping their ids)
+// then switch to it, turning deleted slots back into empty ones
+bool FLASH_STORE_Class::compact(void) {
+	if (0 == this->deleted_slots) {
+		return false;
+	}
+	uint8_t from = this->directory;
+	uint8_t to = (FLASH_STORE_DIRECTORY_SECTOR == from) ? FLASH_STORE_DIRECTORY_SECTOR + 1 : FLASH_STORE_DIRECTORY_SECTOR;
+
+	FLASH.write_enable();
+	FLASH.sector_erase((uint32_t)to << FLASH_SECTOR_SHIFT);
+
+	FLASH_STORE_entry entry;
+	for (uint8_t id = 0; id < FLASH_STORE_ENTRIES; ++id) {
+		FLASH.read(&entry, entry_address(from, id), sizeof(entry));
+		if (FLASH_STORE_VALID == entry.state) {
+			FLASH.write_enable();
+			FLASH.write(entry_address(to, id), &entry, sizeof(entry));
+		}
+	}
+	FLASH.write_disable();
+
+	// header last, so an interrupted copy is never taken as the directory
+	this->write_header(to, this->sequence + 1);
+	FLASH.write_enable();
+	FLASH.sector_erase((uint32_t)from << FLASH_SECTOR_SHIFT);
+	FLASH.write_disable();
+
+	// the images have not moved, carry on allocating where we were
+	uint16_t next_sector = this->next_sector;
+	bool mounted = this->begin();
+	this->next_sector = next_sector;
+	return mounted;
+}
+
+
+int16_t FLASH_STORE_Class::add(const char *name, uint8_t first_sector, uint32_t length,
+			       uint8_t panel, uint8_t format, uint32_t crc) {
+	if (!this->mounted()) {
+		return -1;
+	}
+	if (0 == this->free_slots && !this->compact()) {
+		return -1;
+	}
+
+	FLASH_STORE_entry entry;
+	int16_t id = -1;
+	FLASH.begin_stream(entry_address(this->directory, 0));
+	for (uint8_t i = 0; i < FLASH_STORE_ENTRIES; ++i) {
+		FLASH.read_next(&entry.state, sizeof(entry.state));
+		if (FLASH_STORE_EMPTY == entry.state) {
+			id = i;
+			break;
+		}
+		// skip the rest of the entry
+		uint8_t skip[FLASH_STORE_ENTRY_SIZE - 1];
+		FLASH.read_next(skip, sizeof(skip));
+	}
+	FLASH.end_stream();
+	if (id < 0) {
+		return -1;
+	}
+
+	memset(&entry, 0, sizeof(entry));
+	entry.state = FLASH_STORE_VALID;
+	entry.first_sector = first_sector;
+	entry.sector_count = (length + FLASH_SECTOR_SIZE - 1) >> FLASH_SECTOR_SHIFT;
+	if (0 == entry.sector_count) {
+		entry.sector_count = 1;
+	}
+	entry.panel = panel;
+	entry.format = format;
+	memset(entry.reserved, 0xff, sizeof(entry.reserved));
+	entry.length = length;
+	entry.crc = crc;
+	strncpy(entry.name, name, sizeof(entry.name) - 1);
+
+	FLASH.write_enable();
+	FLASH.write(entry_address(this->directory, id), &entry, sizeof(entry));
+	FLASH.write_disable();
+
+	this->mark(&entry, true);
+	--this->free_slots;
+	return id;
+}
+
+
+bool FLASH_STORE_Class::remove(uint8_t id) {
+	FLASH_STORE_entry entry;
+	if (!this->get(id, &entry)) {
+		return false;
+	}
+	uint8_t state = FLASH_STORE_DELETED;
+	FLASH.write_enable();
+	FLASH.write(entry_address(this->directory, id), &state, sizeof(state));
+	FLASH.write_disable();
+
+	this->mark(&entry, false);
+	++this->deleted_slots;
+	return true;
+}
+
+
+uint16_t FLASH_STORE_Class::free_sectors(void) {
+	if (!this->mounted()) {
+		return 0;
+	}
+	uint16_t count = 0;
+	for (uint16_t s = FLASH_STORE_FIRST_DATA_SECTOR; s < FLASH_SECTOR_COUNT; ++s) {
+		if (0 == (this->used[s >> 3] & (1 << (s & 0x07)))) {
+			++count;
+		}
+	}
+	return count;
+}
+
+
+uint32_t FLASH_STORE_Class::crc32(uint32_t crc, const void *buffer, uint16_t length, bool buffer_in_progmem) {
+	crc = ~crc;
+	for (const uint8_t *p = (const uint8_t *)buffer; length != 0; --length, ++p) {
+		// AVR has multiple memory spaces
+		uint8_t data;
+		if (buffer_in_progmem) {
+			data = pgm_read_byte_near(p);
+		} else {
+			data = *p;
+		}
+		crc ^= data;
+		for (uint8_t bit = 0; bit < 8; ++bit) {
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+
+uint32_t FLASH_STORE_Class::crc32_flash(uint32_t address, uint32_t length) {
+	uint32_t crc = 0;
+	uint8_t buffer[32];
+	FLASH.begin_stream(address);
+	while (0 != length) {
+		uint16_t n = length < sizeof(buffer) ? length : sizeof(buffer);
+		FLASH.read_next(buffer, n);
+		crc = crc32(crc, buffer, n);
+		length -= n;
+	}
+	FLASH.end_stream();
+	return crc;
+}
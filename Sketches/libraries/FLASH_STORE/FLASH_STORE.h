@@ -0,0 +1,162 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+#if !defined(FLASH_STORE_H)
+#define FLASH_STORE_H 1
+
+#include <Arduino.h>
+#include <FLASH.h>
+
+
+// Image store on the FLASH chip
+//
+// sectors 0 and 1 hold the directory, only one of them is active (the one
+// with a valid header and the newer sequence number); each directory sector
+// is a 32 byte header followed by FLASH_STORE_ENTRIES 32 byte entries, the
+// entry index is the image id.  Images occupy contiguous runs of the
+// remaining sectors.
+//
+// entries are only ever programmed (never erased in place):
+//   0xff  empty slot
+//   0x7f  valid image
+//   0x00  deleted image
+// when there are no empty slots left the valid entries are copied (to the
+// same slots) into the other directory sector which then becomes active.
+//
+// the layout is little endian and matches flash_store.py
+
+#define FLASH_STORE_MAGIC "EPDS"
+#define FLASH_STORE_VERSION 1
+
+// sector of the first and second directory copy
+#define FLASH_STORE_DIRECTORY_SECTOR 0
+
+// first sector available for image data
+#define FLASH_STORE_FIRST_DATA_SECTOR 2
+
+// size of header and entries
+#define FLASH_STORE_ENTRY_SIZE 32
+
+// number of images that can be stored (slot 0 is the header)
+#define FLASH_STORE_ENTRIES (FLASH_SECTOR_SIZE / FLASH_STORE_ENTRY_SIZE - 1)
+
+// image name including the terminating NUL
+#define FLASH_STORE_NAME_SIZE 16
+
+// entry states
+#define FLASH_STORE_EMPTY 0xff
+#define FLASH_STORE_VALID 0x7f
+#define FLASH_STORE_DELETED 0x00
+
+
+typedef enum {
+	FLASH_STORE_XBM,       // one bit per pixel, XBM byte order (EPD_reader_source)
+	FLASH_STORE_PACKBITS   // PackBits compressed XBM (EPD_packbits_source)
+} FLASH_STORE_format;
+
+
+// one directory entry (FLASH_STORE_ENTRY_SIZE bytes)
+typedef struct {
+	uint8_t state;          // FLASH_STORE_EMPTY/VALID/DELETED
+	uint8_t first_sector;   // start of the image data
+	uint8_t sector_count;   // sectors reserved for the image
+	uint8_t panel;          // EPD_size the image was made for
+	uint8_t format;         // FLASH_STORE_format
+	uint8_t reserved[3];
+	uint32_t length;        // bytes of image data
+	uint32_t crc;           // CRC-32 (zlib) of the image data
+	char name[FLASH_STORE_NAME_SIZE];
+} FLASH_STORE_entry;
+
+
+class FLASH_STORE_Class {
+private:
+	uint8_t directory;   // sector of the active directory, 0xff if not mounted
+	uint16_t sequence;   // of the active directory
+	uint8_t used[FLASH_SECTOR_COUNT / 8];  // one bit per sector held by a valid entry
+	uint8_t free_slots;
+	uint8_t deleted_slots;
+	uint16_t next_sector;  // where allocate() starts looking
+
+	static uint32_t entry_address(uint8_t directory, uint8_t id);
+	bool read_header(uint8_t sector, uint16_t *sequence);
+	void write_header(uint8_t sector, uint16_t sequence);
+	void mark(const FLASH_STORE_entry *entry, bool in_use);
+	int16_t free_run(uint16_t from, uint16_t count);
+	bool compact(void);
+	FLASH_STORE_Class(const FLASH_STORE_Class &f);  // prevent copy
+
+public:
+	// find the active directory and build the free sector map
+	// false if the FLASH has no image store (see format())
+	bool begin(void);
+
+	// erase the directory and start an empty store (images are forgotten)
+	void format(void);
+
+	bool mounted(void) {
+		return 0xff != this->directory;
+	}
+
+	// entry by id (one entry read), false if the slot does not hold an image
+	bool get(uint8_t id, FLASH_STORE_entry *entry);
+
+	// id of the first image called name (one directory read), -1 if none
+	int16_t find(const char *name, FLASH_STORE_entry *entry);
+
+	// first image with id >= id, -1 at the end; for listing:
+	//   for (int16_t id = FLASH_STORE.next(0, &e); id >= 0; id = FLASH_STORE.next(id + 1, &e))
+	int16_t next(uint8_t id, FLASH_STORE_entry *entry);
+
+	// find a free run of sectors big enough for length bytes and return its first sector,
+	// -1 if there is no such run; the run is only reserved once add() records it
+	// erase = false leaves erasing to the caller (e.g. a FLASH_page_writer)
+	// the search starts after the previous run returned (next fit), so images
+	// that keep being replaced move through the whole FLASH instead of wearing
+	// out the first free sectors
+	int16_t allocate(uint32_t length, bool erase = true);
+
+	// record an image written at first_sector, returns its id or -1 if the directory is full
+	int16_t add(const char *name, uint8_t first_sector, uint32_t length,
+		    uint8_t panel, uint8_t format, uint32_t crc);
+
+	// delete an image, its sectors become free
+	bool remove(uint8_t id);
+
+	uint16_t free_sectors(void);
+	uint8_t free_entries(void) {
+		return this->free_slots + this->deleted_slots;
+	}
+
+	static uint32_t address(const FLASH_STORE_entry *entry) {
+		return (uint32_t)entry->first_sector << FLASH_SECTOR_SHIFT;
+	}
+
+	// read the image back and check it against the CRC in its entry
+	static bool verify(const FLASH_STORE_entry *entry) {
+		return crc32_flash(address(entry), entry->length) == entry->crc;
+	}
+
+	// zlib compatible CRC-32, start with crc = 0 and pass the result back for each block
+	static uint32_t crc32(uint32_t crc, const void *buffer, uint16_t length, bool buffer_in_progmem = false);
+
+	// CRC-32 of length bytes of the FLASH (one streaming read)
+	static uint32_t crc32_flash(uint32_t address, uint32_t length);
+
+	FLASH_STORE_Class();
+};
+
+extern FLASH_STORE_Class FLASH_STORE;
+
+#endif
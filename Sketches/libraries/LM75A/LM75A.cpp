@@ -38,21 +38,37 @@ LM75A_Class::LM75A_Class()
   Wire.begin();
 }
 
-int LM75A_Class::read()
+bool LM75A_Class::sample(int16_t *value)
 {
-  int t = 0;
+  int16_t t = 0;
   
   Wire.beginTransmission(LM75A_I2C_ADDR);
   Wire.write(LM75A_CMD_TEMP);
   Wire.endTransmission();
   
   Wire.requestFrom(LM75A_I2C_ADDR, 2);
-  if (Wire.available() == 2) {
-    t = (Wire.read() << 8);
-    t += Wire.read();
+  if (Wire.available() != 2) {
+    return false;
   }
-  
-  return (t >> 8);
+  t = (Wire.read() << 8);
+  t |= Wire.read();
+
+  // 11 bit two's complement in the top bits, 1/8 degree resolution
+  *value = t / (256 / TEMPERATURE_SCALE);
+  return true;
+}
+
+int LM75A_Class::read()
+{
+  if (filter.expired()) {
+    int16_t t;
+    if (sample(&t)) {
+      filter.sample(t);
+    } else {
+      filter.retry();  // keep the last reading (0 if there never was one)
+    }
+  }
+  return filter.read();
 }
 
 
@@ -20,14 +20,29 @@
 #define LM75A_H
 
 #include <Arduino.h>
+#include <TEMPERATURE.h>
 
 class LM75A_Class {
 public:
 
   LM75A_Class();
+
+  // degrees Celsius: averaged and only read from the sensor again
+  // once the last reading is older than the maximum age
   int read();
 
+  // one sensor read in 1/TEMPERATURE_SCALE degrees, false if the sensor did not answer
+  bool sample(int16_t *value);
+
+  void setMaxAge(uint32_t max_age_ms) {  // 0 reads the sensor on every read()
+    filter.set_max_age(max_age_ms);
+  }
+  void setFilter(uint8_t shift) {  // new samples are weighted 1/2^shift, 0 for no averaging
+    filter.set_shift(shift);
+  }
+
 private:
+  TEMPERATURE_filter filter;
 
 };
 
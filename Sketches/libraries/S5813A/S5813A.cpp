@@ -15,6 +15,7 @@
 
 #include <Arduino.h>
 
+#include <TEMPERATURE.h>
 #include "S5813A.h"
 
 
@@ -82,6 +83,7 @@ void S5813A_Class::begin(int input_pin) {
 	pinMode(input_pin, INPUT);
 	analogReference(ANALOG_REFERENCE);
 	this->temperature_pin = input_pin;
+	this->filter.invalidate();
 }
 
 
@@ -99,6 +101,14 @@ long S5813A_Class::readVoltage() {
 
 
 // return temperature as integer in Celcius
+int16_t S5813A_Class::sample() {
+	return Tstart_C * TEMPERATURE_SCALE + ((this->readVoltage() - Vstart_uV) * TEMPERATURE_SCALE) / Vslope_uV;
+}
+
+
 int S5813A_Class::read() {
-	return Tstart_C + ((this->readVoltage() - Vstart_uV) / Vslope_uV);
+	if (this->filter.expired()) {
+		this->filter.sample(this->sample());
+	}
+	return this->filter.read();
 }
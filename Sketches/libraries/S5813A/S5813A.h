@@ -16,17 +16,29 @@
 #define EPD_S5813A_H 1
 
 #include <Arduino.h>
+#include <TEMPERATURE.h>
 
 class S5813A_Class {
 private:
 	int temperature_pin;
+	TEMPERATURE_filter filter;
 
 	S5813A_Class(const S5813A_Class &f);  // prevent copy
 
 public:
+	// degrees Celsius: averaged and only converted again once
+	// the last reading is older than the maximum age
 	int read();
+	int16_t sample();    // one conversion in 1/TEMPERATURE_SCALE degrees
 	long readVoltage();  // returns micro volts
 
+	void setMaxAge(uint32_t max_age_ms) {  // 0 converts on every read()
+		this->filter.set_max_age(max_age_ms);
+	}
+	void setFilter(uint8_t shift) {  // new samples are weighted 1/2^shift, 0 for no averaging
+		this->filter.set_shift(shift);
+	}
+
 	// inline static void attachInterrupt();
 	// inline static void detachInterrupt();
 
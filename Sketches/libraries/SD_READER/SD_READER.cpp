@@ -0,0 +1,94 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <Arduino.h>
+
+#include <SPI.h>
+#include <SD.h>
+
+#include "SD_READER.h"
+
+#define SD_READER_UNKNOWN 0xffffffff
+
+
+const SPI_BUS_device SD_READER_spi = {MSBFIRST, SPI_MODE0, SPI_CLOCK_DIV4, -1, LOW};
+
+
+SD_reader::SD_reader(void *cache, uint16_t cache_size) :
+	file(0), cache((uint8_t *)cache), cache_size(cache_size),
+	cache_length(0), cache_address(0), position(SD_READER_UNKNOWN) {
+}
+
+
+void SD_reader::begin(File &file) {
+	this->file = &file;
+	this->cache_length = 0;
+	this->position = SD_READER_UNKNOWN;
+}
+
+
+void SD_reader::read(void *buffer, uint32_t address, uint16_t length) {
+	uint8_t *p = (uint8_t *)buffer;
+
+	if (0 == this->file || 0 == this->cache_size) {
+		memset(p, 0, length);
+		return;
+	}
+	while (length > 0) {
+		if (address < this->cache_address || address - this->cache_address >= this->cache_length) {
+			// blocks are aligned to the cache size, i.e. to SD sectors
+			// for a 512 byte cache; if the block is cached but short it is
+			// the end of the file and need not be read again
+			uint32_t block = address - address % this->cache_size;
+			bool cached = 0 != this->cache_length && block == this->cache_address;
+			if ((!cached && !this->fill(block))
+			    || address - this->cache_address >= this->cache_length) {
+				memset(p, 0, length);
+				return;
+			}
+		}
+		uint16_t offset = address - this->cache_address;
+		uint16_t n = this->cache_length - offset;
+		if (n > length) {
+			n = length;
+		}
+		memcpy(p, &this->cache[offset], n);
+		p += n;
+		address += n;
+		length -= n;
+	}
+}
+
+
+// read the block at address into the cache, false at the end of the file
+bool SD_reader::fill(uint32_t address) {
+	this->cache_length = 0;
+	SPI_BUS.acquire(&SD_READER_spi);
+	bool ok = true;
+	if (address != this->position) {
+		ok = this->file->seek(address);
+	}
+	int n = ok ? this->file->read(this->cache, this->cache_size) : -1;
+	SPI_BUS.invalidate();  // the next EPD or FLASH access sets the bus up again
+
+	if (n <= 0) {
+		this->position = SD_READER_UNKNOWN;
+		return false;
+	}
+	this->cache_address = address;
+	this->cache_length = n;
+	this->position = address + n;
+	return true;
+}
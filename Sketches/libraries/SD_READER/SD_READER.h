@@ -0,0 +1,69 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#if !defined(SD_READER_H)
+#define SD_READER_H 1
+
+#include <Arduino.h>
+#include <SD.h>
+#include <SPI_BUS.h>
+
+
+// SPI settings for SD card accesses
+// the SD library drives its own chip select and (in older versions) only
+// sets up the SPI mode in SD.begin(), so it is restored before each access
+extern const SPI_BUS_device SD_READER_spi;
+
+
+// File backed EPD_reader
+//
+// keeps a block of the file in a caller supplied cache (ideally one 512 byte
+// SD sector) and remembers the file position, so the sequential line reads
+// of a stage pass are copied from SRAM and only each new block costs an SD
+// read (and a seek when the pass starts again at the top of the image).
+// EPD_reader is a plain function, so wrap each reader in a callback:
+//
+//   SD_reader image_reader(cache, sizeof(cache));
+//   void image_read(void *buffer, uint32_t address, uint16_t length) {
+//           image_reader.read(buffer, address, length);
+//   }
+//   ...
+//   image_reader.begin(image_file);
+//   EPD.frame_cb_repeat(0, image_read, EPD_normal);
+class SD_reader {
+private:
+	File *file;
+	uint8_t *cache;
+	uint16_t cache_size;
+	uint16_t cache_length;   // valid bytes in cache
+	uint32_t cache_address;  // file offset of cache[0]
+	uint32_t position;       // file position after the last read, SD_READER_UNKNOWN if not known
+
+	bool fill(uint32_t address);
+	SD_reader(const SD_reader &r);  // prevent copy
+
+public:
+	SD_reader(void *cache, uint16_t cache_size);
+
+	// read from file, discarding anything cached
+	// (call again if the file was read or changed by anything else)
+	void begin(File &file);
+
+	// EPD_reader: copy length bytes from address
+	// bytes beyond the end of the file read as zero (all of them without a file or cache)
+	void read(void *buffer, uint32_t address, uint16_t length);
+};
+
+#endif
@@ -0,0 +1,67 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <Arduino.h>
+
+#include <SPI.h>
+
+#include "SPI_BUS.h"
+
+
+// the one shared bus
+SPI_BUS_Class SPI_BUS;
+
+
+bool SPI_BUS_Class::acquire(const SPI_BUS_device *device) {
+	bool changed = device != this->current;
+
+	if (changed) {
+		this->deselect();
+		if (0 == this->current) {
+			SPI.begin();
+		}
+		SPI.setBitOrder(device->bit_order);
+		SPI.setDataMode(device->data_mode);
+		SPI.setClockDivider(device->clock_divider);
+		this->current = device;
+	}
+
+	if (!this->selected && (device->select_pin >= 0)) {
+		this->select_restore = digitalRead(device->select_pin);
+		digitalWrite(device->select_pin, device->select_level);
+		this->selected = true;
+	}
+	return changed;
+}
+
+
+void SPI_BUS_Class::deselect() {
+	if (this->selected) {
+		digitalWrite(this->current->select_pin, this->select_restore);
+		this->selected = false;
+	}
+}
+
+
+void SPI_BUS_Class::invalidate() {
+	this->deselect();
+	this->current = 0;
+}
+
+
+void SPI_BUS_Class::release() {
+	this->invalidate();
+	SPI.end();
+}
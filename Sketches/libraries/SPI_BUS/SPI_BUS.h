@@ -0,0 +1,69 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+#if !defined(SPI_BUS_H)
+#define SPI_BUS_H 1
+
+#include <Arduino.h>
+#include <SPI.h>
+
+
+// SPI settings of one device on the shared bus
+// select_pin (if not -1) is set to select_level for each transaction with the
+// device and put back afterwards, e.g. on the EA board the FLASH is selected
+// by the EPD chip select with PANEL_ON low (SN74LVC1G139 decoder).
+typedef struct {
+	uint8_t bit_order;      // MSBFIRST or LSBFIRST
+	uint8_t data_mode;      // SPI_MODE0..SPI_MODE3
+	uint8_t clock_divider;  // SPI_CLOCK_DIVn
+	int8_t select_pin;
+	uint8_t select_level;
+} SPI_BUS_device;
+
+
+// Tracks which device the SPI hardware is set up for, so devices that take
+// turns on the bus (EPD, FLASH, SD) only reprogram it when it changes hands
+// instead of on every line or read.
+class SPI_BUS_Class {
+private:
+	const SPI_BUS_device *current;  // 0 if the bus is not set up
+	bool selected;                  // select_pin of current is at select_level
+	uint8_t select_restore;         // level to put select_pin back to
+
+	SPI_BUS_Class(const SPI_BUS_Class &f);  // prevent copy
+
+public:
+	SPI_BUS_Class() : current(0), selected(false), select_restore(LOW) {}
+
+	// set up the bus for device and apply its select_pin
+	// returns true if the SPI hardware had to be reprogrammed (e.g. to flush after a mode change)
+	bool acquire(const SPI_BUS_device *device);
+
+	// end of a transaction: put select_pin back, the SPI settings stay
+	void deselect();
+
+	// something else (e.g. the SD library) changed the SPI settings
+	void invalidate();
+
+	// finished with the bus: deselect and SPI.end()
+	void release();
+
+	bool is_current(const SPI_BUS_device *device) const {
+		return device == this->current;
+	}
+};
+
+extern SPI_BUS_Class SPI_BUS;
+
+#endif
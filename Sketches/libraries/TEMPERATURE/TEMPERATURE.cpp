@@ -0,0 +1,37 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <Arduino.h>
+
+#include "TEMPERATURE.h"
+
+
+void TEMPERATURE_filter::sample(int16_t value) {
+	if (this->valid) {
+		this->sum += value - (this->sum >> this->shift);
+	} else {
+		this->sum = (int32_t)value << this->shift;
+		this->valid = true;
+	}
+	this->sample_time = millis();
+}
+
+
+void TEMPERATURE_filter::set_shift(uint8_t shift) {
+	// keep the current average
+	int16_t a = this->average();
+	this->shift = shift;
+	this->sum = (int32_t)a << shift;
+}
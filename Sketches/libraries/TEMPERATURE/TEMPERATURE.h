@@ -0,0 +1,97 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#if !defined(TEMPERATURE_H)
+#define TEMPERATURE_H 1
+
+#include <Arduino.h>
+
+
+// readings are kept in 1/TEMPERATURE_SCALE degrees Celsius
+#define TEMPERATURE_SCALE 16
+
+// a new sample is only taken when the last one is older than this
+#define TEMPERATURE_MAX_AGE_MS 5000
+
+// exponential moving average: each new sample has a weight of 1/2^shift
+#define TEMPERATURE_FILTER_SHIFT 2
+
+
+// Cached and filtered sensor reading shared by the temperature sensor
+// libraries.  The sensor is only read when the cached value has expired,
+// so repeated read() calls (every loop, every EPD_GFX segment pass) do not
+// put an ADC conversion or I2C transaction on the refresh path, and single
+// noisy ADC samples are averaged out.
+//
+//   int S5813A_Class::read() {
+//           if (this->filter.expired()) {
+//                   this->filter.sample(...);  // 1/TEMPERATURE_SCALE degrees
+//           }
+//           return this->filter.read();
+//   }
+class TEMPERATURE_filter {
+private:
+	int32_t sum;          // average << shift
+	uint32_t sample_time; // millis() of the last sample
+	uint32_t max_age;
+	uint8_t shift;
+	bool valid;
+
+	TEMPERATURE_filter(const TEMPERATURE_filter &f);  // prevent copy
+
+public:
+	TEMPERATURE_filter(uint32_t max_age_ms = TEMPERATURE_MAX_AGE_MS,
+			   uint8_t shift = TEMPERATURE_FILTER_SHIFT) :
+		sum(0), sample_time(0), max_age(max_age_ms), shift(shift), valid(false) {}
+
+	// a new sample is due
+	bool expired() const {
+		return !this->valid || millis() - this->sample_time >= this->max_age;
+	}
+
+	// add a sample in 1/TEMPERATURE_SCALE degrees, the first one sets the average
+	void sample(int16_t value);
+
+	// failed sensor read: keep the average, retry on the next expired() check
+	void retry() {
+		this->sample_time = millis() - this->max_age;
+	}
+
+	// force a new sample on the next read (e.g. after sleeping)
+	void invalidate() {
+		this->valid = false;
+	}
+
+	// 0 reads the sensor every time
+	void set_max_age(uint32_t max_age_ms) {
+		this->max_age = max_age_ms;
+	}
+
+	// 0 turns the averaging off
+	void set_shift(uint8_t shift);
+
+	// average in 1/TEMPERATURE_SCALE degrees
+	int16_t average() const {
+		return this->sum >> this->shift;
+	}
+
+	// average rounded to degrees
+	int read() const {
+		int16_t a = this->average();
+		return (a + (a < 0 ? -TEMPERATURE_SCALE / 2 : TEMPERATURE_SCALE / 2)) / TEMPERATURE_SCALE;
+	}
+};
+
+#endif
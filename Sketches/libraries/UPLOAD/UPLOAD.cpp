@@ -0,0 +1,252 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <Arduino.h>
+#include <string.h>
+
+#include <FLASH.h>
+#include <FLASH_STORE.h>
+
+#include "UPLOAD.h"
+
+
+// the default receiver
+UPLOAD_Class UPLOAD;
+
+
+UPLOAD_Class::UPLOAD_Class() : led_pin(-1), led_off(LOW) {
+}
+
+
+void UPLOAD_Class::begin(int8_t led_pin, uint8_t led_off) {
+	this->led_pin = led_pin;
+	this->led_off = led_off;
+}
+
+
+static uint16_t crc16(uint16_t crc, uint8_t b) {
+	crc ^= (uint16_t)b << 8;
+	for (uint8_t i = 0; i < 8; ++i) {
+		crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+
+static uint32_t get_le32(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+int UPLOAD_Class::getc_timeout(uint16_t ms) {
+	unsigned long start = millis();
+	while (0 == Serial.available()) {
+		if (millis() - start >= ms) {
+			return -1;
+		}
+	}
+	return Serial.read();
+}
+
+
+void UPLOAD_Class::toggle_led(void) {
+	if (this->led_pin >= 0) {
+		digitalWrite(this->led_pin, !digitalRead(this->led_pin));
+	}
+}
+
+
+void UPLOAD_Class::send(uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length) {
+	uint8_t header[3] = {type, sequence, length};
+	uint16_t crc = 0xffff;
+	Serial.write(UPLOAD_SOF);
+	for (uint8_t i = 0; i < sizeof(header); ++i) {
+		Serial.write(header[i]);
+		crc = crc16(crc, header[i]);
+	}
+	for (uint8_t i = 0; i < length; ++i) {
+		Serial.write(payload[i]);
+		crc = crc16(crc, payload[i]);
+	}
+	Serial.write(crc & 0xff);
+	Serial.write(crc >> 8);
+}
+
+
+void UPLOAD_Class::nak(uint8_t error, uint8_t expected) {
+	uint8_t payload[2] = {error, expected};
+	this->send(UPLOAD_NAK, expected, payload, sizeof(payload));
+}
+
+
+// returns 1 for a good frame, 0 for a damaged one, -1 if the host went quiet
+int8_t UPLOAD_Class::receive_frame(UPLOAD_frame *frame, uint16_t idle_ms) {
+	int c;
+	do {
+		c = getc_timeout(idle_ms);
+		if (c < 0) {
+			return -1;
+		}
+	} while (UPLOAD_SOF != c);
+
+	uint8_t *p = &frame->type;
+	uint16_t crc = 0xffff;
+	for (uint8_t i = 0; i < 3; ++i) {
+		if ((c = getc_timeout(UPLOAD_BYTE_TIMEOUT_MS)) < 0) {
+			return 0;
+		}
+		p[i] = c;
+		crc = crc16(crc, c);
+	}
+	if (frame->length > sizeof(frame->payload)) {
+		return 0;
+	}
+	for (uint8_t i = 0; i < frame->length; ++i) {
+		if ((c = getc_timeout(UPLOAD_BYTE_TIMEOUT_MS)) < 0) {
+			return 0;
+		}
+		frame->payload[i] = c;
+		crc = crc16(crc, c);
+	}
+	for (uint8_t i = 0; i < 16; i += 8) {
+		if ((c = getc_timeout(UPLOAD_BYTE_TIMEOUT_MS)) < 0) {
+			return 0;
+		}
+		crc ^= (uint16_t)c << i;
+	}
+	return 0 == crc;
+}
+
+
+int16_t UPLOAD_Class::receive(void) {
+	UPLOAD_frame frame;
+	int8_t r;
+
+	// start frame
+	do {
+		r = this->receive_frame(&frame, UPLOAD_IDLE_TIMEOUT_MS);
+		if (r < 0) {
+			return -1;
+		}
+	} while (0 == r || UPLOAD_START != frame.type || 0 != frame.sequence);
+
+	if (frame.length < 11 || frame.length > 10 + FLASH_STORE_NAME_SIZE - 1) {
+		this->nak(UPLOAD_NO_SPACE, 0);
+		return -1;
+	}
+	uint32_t length = get_le32(&frame.payload[0]);
+	uint8_t panel = frame.payload[4];
+	uint8_t format = frame.payload[5];
+	uint32_t image_crc = get_le32(&frame.payload[6]);
+	char name[FLASH_STORE_NAME_SIZE];
+	memcpy(name, &frame.payload[10], frame.length - 10);
+	name[frame.length - 10] = '\0';
+
+	int16_t sector = FLASH_STORE.allocate(length, false);
+	if (sector < 0) {
+		this->nak(UPLOAD_NO_SPACE, 0);
+		return -1;
+	}
+	uint8_t limits[2] = {UPLOAD_PAYLOAD, UPLOAD_WINDOW};
+	this->send(UPLOAD_ACK, 0, limits, sizeof(limits));
+
+	FLASH_page_writer writer(FLASH, (uint32_t)sector << FLASH_SECTOR_SHIFT);
+	uint32_t received = 0;
+	uint32_t crc = 0;
+	uint8_t expected = 1;
+	bool nak_sent = false;
+	int16_t id = -1;
+
+	for (;;) {
+		r = this->receive_frame(&frame, UPLOAD_IDLE_TIMEOUT_MS);
+		if (r < 0) {
+			break;
+		}
+		if (0 == r || frame.sequence != expected) {
+			if (1 == r && UPLOAD_START == frame.type) {
+				// our start ack was lost
+				this->send(UPLOAD_ACK, 0, limits, sizeof(limits));
+			} else if (1 == r && (uint8_t)(expected - frame.sequence) <= UPLOAD_WINDOW) {
+				// already have it, the ack was lost
+				this->send(UPLOAD_ACK, expected - 1, 0, 0);
+			} else if (!nak_sent) {
+				// only once, the rest of the window is also discarded
+				this->nak(UPLOAD_RETRY, expected);
+				nak_sent = true;
+			}
+			continue;
+		}
+		nak_sent = false;
+
+		if (UPLOAD_DATA == frame.type) {
+			if (received + frame.length > length) {
+				this->nak(UPLOAD_BAD_LENGTH, expected);
+				break;
+			}
+			writer.write(frame.payload, frame.length);
+			crc = FLASH_STORE.crc32(crc, frame.payload, frame.length);
+			received += frame.length;
+			this->send(UPLOAD_ACK, expected++, 0, 0);
+			this->toggle_led();
+
+		} else if (UPLOAD_END == frame.type) {
+			writer.finish();
+			if (received != length || crc != image_crc
+			    || FLASH_STORE.crc32_flash((uint32_t)sector << FLASH_SECTOR_SHIFT, length) != crc) {
+				this->nak(UPLOAD_BAD_CRC32, expected);
+				break;
+			}
+			// replace an older image of the same name
+			FLASH_STORE_entry entry;
+			int16_t old = FLASH_STORE.find(name, &entry);
+			if (old >= 0) {
+				FLASH_STORE.remove(old);
+			}
+			id = FLASH_STORE.add(name, sector, length, panel, format, crc);
+			if (id < 0) {
+				this->nak(UPLOAD_DIRECTORY_FULL, expected);
+				break;
+			}
+			uint8_t result = id;
+			this->send(UPLOAD_ACK, expected, &result, sizeof(result));
+
+			// the host sends the end frame again if the ack got lost, after
+			// going back to the data frames of the last window if their acks
+			// were lost too; answer both until it is done or starts again
+			while ((r = this->receive_frame(&frame, UPLOAD_LINGER_MS)) >= 0) {
+				if (1 != r) {
+					continue;
+				}
+				if (UPLOAD_END == frame.type && expected == frame.sequence) {
+					this->send(UPLOAD_ACK, expected, &result, sizeof(result));
+				} else if (UPLOAD_DATA == frame.type && (uint8_t)(expected - frame.sequence) <= UPLOAD_WINDOW) {
+					this->send(UPLOAD_ACK, expected - 1, 0, 0);
+				} else if (UPLOAD_ABORT == frame.type || UPLOAD_START == frame.type) {
+					break;
+				}
+			}
+			break;
+
+		} else {
+			// abort (or nonsense)
+			this->send(UPLOAD_ACK, expected, 0, 0);
+			break;
+		}
+	}
+	if (this->led_pin >= 0) {
+		digitalWrite(this->led_pin, this->led_off);
+	}
+	return id;
+}
@@ -0,0 +1,103 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+#if !defined(UPLOAD_H)
+#define UPLOAD_H 1
+
+#include <Arduino.h>
+
+
+// binary image upload into the FLASH_STORE over Serial (see upload.py)
+// frame: 0xa5 type sequence length payload[length] crc16 (little endian)
+// crc16 is CRC-16/CCITT (0x1021, start 0xffff) over type, sequence, length and payload
+//
+// host -> device:
+//   'S' seq 0    length:4 panel:1 format:1 crc32:4 name  (start)
+//   'D' seq 1..  image data, at most UPLOAD_PAYLOAD bytes
+//   'E'          end, the data is checked against crc32 and stored
+//   'A'          abort, or after the end ack: done
+// device -> host:
+//   'K' seq      all frames up to seq were accepted, the start ack carries
+//                UPLOAD_PAYLOAD and UPLOAD_WINDOW, the end ack the image id
+//   'N' seq      error:1 expected:1, frames from expected must be sent again
+//                (UPLOAD_RETRY) or the upload has failed
+//
+// the host never has more than UPLOAD_WINDOW frames unacknowledged, so a
+// whole window fits the serial receive buffer while the FLASH is busy
+#if defined(__MSP430_CPU__)
+#define UPLOAD_PAYLOAD 10   // 16 byte receive buffer
+#define UPLOAD_WINDOW 1
+#else
+#define UPLOAD_PAYLOAD 26   // 64 byte receive buffer
+#define UPLOAD_WINDOW 2
+#endif
+#define UPLOAD_FRAME_PAYLOAD 26     // largest frame (the start frame)
+#define UPLOAD_SOF 0xa5
+#define UPLOAD_BYTE_TIMEOUT_MS 100  // give up on a partial frame
+#define UPLOAD_IDLE_TIMEOUT_MS 5000 // give up on the upload
+#define UPLOAD_LINGER_MS 2000       // keep answering a repeated end frame
+
+typedef enum {
+	UPLOAD_START = 'S',
+	UPLOAD_DATA = 'D',
+	UPLOAD_END = 'E',
+	UPLOAD_ABORT = 'A',
+	UPLOAD_ACK = 'K',
+	UPLOAD_NAK = 'N'
+} UPLOAD_type;
+
+typedef enum {
+	UPLOAD_RETRY,         // bad CRC or sequence: resend from expected
+	UPLOAD_NO_SPACE,      // no free sectors or bad start frame
+	UPLOAD_BAD_LENGTH,    // more data than announced
+	UPLOAD_BAD_CRC32,     // image data does not match
+	UPLOAD_DIRECTORY_FULL
+} UPLOAD_error;
+
+typedef struct {
+	uint8_t type;
+	uint8_t sequence;
+	uint8_t length;
+	uint8_t payload[UPLOAD_FRAME_PAYLOAD];
+} UPLOAD_frame;
+
+
+class UPLOAD_Class {
+private:
+	int8_t led_pin;
+	uint8_t led_off;
+
+	void send(uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length);
+	void nak(uint8_t error, uint8_t expected);
+	int8_t receive_frame(UPLOAD_frame *frame, uint16_t idle_ms);
+	void toggle_led(void);
+	static int getc_timeout(uint16_t ms);
+	UPLOAD_Class(const UPLOAD_Class &f);  // prevent copy
+
+public:
+	// led_pin: toggled for each data frame stored, -1 for none
+	void begin(int8_t led_pin = -1, uint8_t led_off = LOW);
+
+	// wait for a start frame and store the image that follows in the
+	// FLASH_STORE (replacing one of the same name), returns its id or -1 if
+	// the upload failed or the host went quiet (FLASH and FLASH_STORE must
+	// have been started)
+	int16_t receive(void);
+
+	UPLOAD_Class();
+};
+
+extern UPLOAD_Class UPLOAD;
+
+#endif
@@ -32,8 +32,10 @@
 
 // required libraried
 #include <SPI.h>
+#include <SPI_BUS.h>
 #include <FLASH.h>
 #include <EPD.h>
+#include <TEMPERATURE.h>
 #include <S5813A.h>
 #include <Adafruit_GFX.h>
 #include <EPD_GFX.h>
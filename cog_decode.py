@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+# Decode a captured COG SPI stream into a simulated panel and timing counts
+#
+# Input: one SPI transaction (chip select low .. high) per line as hex bytes,
+# e.g. the CSV/text export of a logic analyser SPI decoder.
+# Blank lines and lines starting with '#' are ignored.
+#
+#   70 04
+#   72 03
+#   70 0a
+#   72 00 00 ... 00
+#
+# Output: per stage (a run of identical frames) the passes, lines, bytes and
+# the time those bytes take at the SPI clock, plus the final panel as a PBM.
+#
+# usage: cog_decode.py [-s 1.44|2.0|2.7] [-c spi_hz] [-o panel.pbm] capture.txt
+
+import argparse
+import sys
+
+PANELS = {
+	# size: (dots_per_line, lines_per_display, border_byte, filler)
+	'1.44': (128, 96, True, False),
+	'2.0': (200, 96, False, True),
+	'2.7': (264, 176, False, True),
+}
+
+
+def read_transactions(f):
+	for n, text in enumerate(f, 1):
+		text = text.split('#', 1)[0].replace(',', ' ').strip()
+		if not text:
+			continue
+		try:
+			yield n, bytes(int(b, 16) for b in text.split())
+		except ValueError:
+			sys.exit('line %d: not hex bytes: %s' % (n, text))
+
+
+class Panel:
+	def __init__(self, size):
+		self.dots, self.lines, self.border, self.filler = PANELS[size]
+		self.bytes_per_line = self.dots // 8
+		self.bytes_per_scan = self.lines // 4
+		self.length = (1 + (1 if self.border else 0) + 2 * self.bytes_per_line +
+		               self.bytes_per_scan + (1 if self.filler else 0))
+		self.pixels = [[0] * self.dots for _ in range(self.lines)]  # 1 = black
+
+	def scan_line(self, scan):
+		for i, b in enumerate(scan):
+			if b:
+				return 4 * i + (0, 1, 2, 3)[(0xc0, 0x30, 0x0c, 0x03).index(b)]
+		return None  # dummy line, nothing is driven
+
+	def apply(self, line, cells):
+		# 11 = black, 10 = white, 0x = no change
+		row = self.pixels[line]
+		for x, cell in cells:
+			if 3 == cell:
+				row[x] = 1
+			elif 2 == cell:
+				row[x] = 0
+
+	def decode(self, data):
+		# returns the line number (or None) and the (x, cell) pairs
+		p = 2 if self.border else 1
+		even = data[p:p + self.bytes_per_line]
+		p += self.bytes_per_line
+		scan = data[p:p + self.bytes_per_scan]
+		p += self.bytes_per_scan
+		odd = data[p:p + self.bytes_per_line]
+
+		cells = []
+		# even pixels: bytes sent last first, cells are pixels 7, 5, 3, 1
+		for i, b in enumerate(even):
+			base = 8 * (self.bytes_per_line - 1 - i)
+			for k, x in enumerate((7, 5, 3, 1)):
+				cells.append((base + x, (b >> (6 - 2 * k)) & 0x03))
+		# odd pixels: bytes in order, cells are pixels 0, 2, 4, 6
+		for i, b in enumerate(odd):
+			base = 8 * i
+			for k, x in enumerate((0, 2, 4, 6)):
+				cells.append((base + x, (b >> (6 - 2 * k)) & 0x03))
+		return self.scan_line(scan), cells
+
+	def write_pbm(self, name):
+		with open(name, 'w') as f:
+			f.write('P1\n%d %d\n' % (self.dots, self.lines))
+			for row in self.pixels:
+				f.write(' '.join(str(v) for v in row) + '\n')
+
+
+class Stage:
+	def __init__(self, frame):
+		self.frame = frame  # encoded lines of one pass
+		self.passes = 0
+		self.lines = 0
+		self.bytes = 0
+
+
+def main():
+	parser = argparse.ArgumentParser(description='decode a COG SPI capture')
+	parser.add_argument('-s', '--size', default='2.7', choices=sorted(PANELS))
+	parser.add_argument('-c', '--clock', type=int, default=8000000, help='SPI clock in Hz (default Uno SPI_CLOCK_DIV2)')
+	parser.add_argument('-o', '--output', help='write the final panel as a PBM image')
+	parser.add_argument('capture', type=argparse.FileType('r'))
+	args = parser.parse_args()
+
+	panel = Panel(args.size)
+	register = None
+	total_bytes = 0
+	other_bytes = 0
+	sessions = 0
+	stages = []
+	frame = []
+	frame_bytes = 0
+	last_line = None
+
+	def end_frame():
+		if not frame:
+			return
+		if not stages or stages[-1].frame != frame:
+			stages.append(Stage(list(frame)))
+		s = stages[-1]
+		s.passes += 1
+		s.lines += len(frame)
+		s.bytes += frame_bytes
+
+	for n, t in read_transactions(args.capture):
+		total_bytes += len(t)
+		if 0x70 == t[0] and 2 == len(t):
+			register = t[1]
+			other_bytes += len(t)
+			continue
+		if 0x72 != t[0]:
+			other_bytes += len(t)
+			continue
+
+		if 0x0a == register:
+			if len(t) != panel.length:
+				sys.exit('line %d: line data is %d bytes, %s" panel needs %d' % (n, len(t), args.size, panel.length))
+			line, cells = panel.decode(t)
+			# a new pass starts when the scan goes back up (or a dummy line ends it)
+			if None is line or (None is not last_line and line <= last_line):
+				end_frame()
+				frame = []
+				frame_bytes = 0
+			last_line = line
+			frame_bytes += len(t)
+			if None is not line:
+				panel.apply(line, cells)
+				frame.append(t)
+		else:
+			other_bytes += len(t)
+			if 0x01 == register:
+				sessions += 1  # channel select is the first command of EPD_Class::begin
+
+	end_frame()
+
+	us_per_byte = 8e6 / args.clock
+	print('%s" panel, SPI clock %d Hz' % (args.size, args.clock))
+	for i, s in enumerate(stages):
+		print('stage %2d: %4d passes %6d lines %8d bytes %10.0f us' % (
+			i, s.passes, s.lines, s.bytes, s.bytes * us_per_byte))
+	print('line data %d bytes, commands %d bytes, total %d bytes %.0f us' % (
+		total_bytes - other_bytes, other_bytes, total_bytes, total_bytes * us_per_byte))
+	if sessions:
+		print('power up sequences: %d' % sessions)
+
+	if args.output:
+		panel.write_pbm(args.output)
+
+
+if '__main__' == __name__:
+	main()
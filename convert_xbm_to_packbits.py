@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# Compress XBM images with PackBits for EPD_packbits_source
+#
+# Each image becomes one PackBits stream of its bytes in XBM order
+# (runs may cross line ends):
+#   n = 0..127    n + 1 literal bytes follow
+#   n = 129..255  the next byte is repeated 257 - n times
+#
+# By default a C array (PROGMEM) is written next to the XBM as <name>.pb.h,
+# with -b the raw stream is written as <name>.pb for loading into flash.
+#
+# usage: convert_xbm_to_packbits.py [-b] image.xbm...
+
+import argparse
+import os
+import re
+import sys
+
+
+def read_xbm(name):
+	text = open(name).read()
+	width = int(re.search(r'_width\s+(\d+)', text).group(1))
+	height = int(re.search(r'_height\s+(\d+)', text).group(1))
+	body = text[text.index('{') + 1:text.rindex('}')]
+	data = bytes(int(v, 16) for v in re.findall(r'0x[0-9a-fA-F]+', body))
+	if len(data) != (width + 7) // 8 * height:
+		sys.exit('%s: %d bytes for %d x %d' % (name, len(data), width, height))
+	return width, height, data
+
+
+def packbits(data):
+	out = bytearray()
+	literal = bytearray()
+
+	def flush():
+		if literal:
+			out.append(len(literal) - 1)
+			out.extend(literal)
+			del literal[:]
+
+	i = 0
+	while i < len(data):
+		run = 1
+		while i + run < len(data) and run < 128 and data[i + run] == data[i]:
+			run += 1
+		# a 2 byte run only pays when it does not split a literal
+		if run >= 3 or (2 == run and not literal):
+			flush()
+			out.append(257 - run)
+			out.append(data[i])
+			i += run
+		else:
+			literal.append(data[i])
+			i += 1
+			if 128 == len(literal):
+				flush()
+	flush()
+	return bytes(out)
+
+
+def unpackbits(data, length):
+	out = bytearray()
+	i = 0
+	while len(out) < length:
+		n = data[i]
+		i += 1
+		if n < 128:
+			out.extend(data[i:i + n + 1])
+			i += n + 1
+		elif n > 128:
+			out.extend(data[i:i + 1] * (257 - n))
+			i += 1
+	return bytes(out)
+
+
+def main():
+	parser = argparse.ArgumentParser(description='PackBits compress XBM images')
+	parser.add_argument('-b', '--binary', action='store_true', help='write raw .pb files instead of C arrays')
+	parser.add_argument('images', nargs='+')
+	args = parser.parse_args()
+
+	for name in args.images:
+		width, height, data = read_xbm(name)
+		packed = packbits(data)
+		assert unpackbits(packed, len(data)) == data
+
+		base = os.path.splitext(name)[0]
+		symbol = re.sub(r'\W', '_', os.path.basename(base))
+		if args.binary:
+			out = base + '.pb'
+			with open(out, 'wb') as f:
+				f.write(packed)
+		else:
+			out = base + '.pb.h'
+			with open(out, 'w') as f:
+				f.write('// %s: %d x %d PackBits compressed, %d -> %d bytes\n' % (
+					os.path.basename(name), width, height, len(data), len(packed)))
+				f.write('#define %s_pb_width %d\n' % (symbol, width))
+				f.write('#define %s_pb_height %d\n' % (symbol, height))
+				f.write('static const unsigned char %s_pb[] PROGMEM = {' % symbol)
+				for i, b in enumerate(packed):
+					f.write(('\n   ' if 0 == i % 12 else ' ') + '0x%02x,' % b)
+				f.write('\n};\n')
+		print('%s -> %s %d -> %d bytes (%.1fx)' % (name, out, len(data), len(packed), len(data) / float(len(packed))))
+
+
+if '__main__' == __name__:
+	main()
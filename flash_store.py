@@ -0,0 +1,360 @@
+#!/usr/bin/env python3
+# Build and inspect FLASH images holding a FLASH_STORE image directory
+#
+# The FLASH is simulated as a file of FLASH_SECTOR_COUNT sectors (created
+# erased if missing).  The simulation keeps the NOR rules of the real chip:
+# programming can only clear bits, only whole sectors are erased and a
+# program must stay inside one 256 byte page, so the store code below (which
+# follows FLASH_STORE.cpp step by step) fails here the same way it would on
+# the device.  The file can also be a dump read back from a board.
+#
+# usage: flash_store.py flash.bin format
+#        flash_store.py flash.bin add [-p] [-n name] image.xbm...
+#        flash_store.py flash.bin list
+#        flash_store.py flash.bin remove id|name
+#        flash_store.py flash.bin extract id|name output
+#        flash_store.py flash.bin check
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+from convert_xbm_to_packbits import packbits, read_xbm
+
+SECTOR_SIZE = 4096
+SECTOR_COUNT = 256
+PAGE_SIZE = 256
+
+MAGIC = b'EPDS'
+VERSION = 1
+DIRECTORY_SECTOR = 0
+FIRST_DATA_SECTOR = 2
+ENTRY_SIZE = 32
+ENTRIES = SECTOR_SIZE // ENTRY_SIZE - 1
+NAME_SIZE = 16
+
+EMPTY = 0xff
+VALID = 0x7f
+DELETED = 0x00
+
+XBM = 0
+PACKBITS = 1
+FORMATS = {XBM: 'xbm', PACKBITS: 'packbits'}
+
+# EPD_size: (name, width, height)
+PANELS = {0: ('1.44', 128, 96), 1: ('2.0', 200, 96), 2: ('2.7', 264, 176)}
+
+HEADER = struct.Struct('<4sBBBBH')
+ENTRY = struct.Struct('<BBBBB3sII%ds' % NAME_SIZE)
+
+
+class FlashError(Exception):
+	pass
+
+
+class MockFlash:
+	def __init__(self, name):
+		self.name = name
+		if os.path.exists(name):
+			self.data = bytearray(open(name, 'rb').read())
+			if len(self.data) != SECTOR_SIZE * SECTOR_COUNT:
+				sys.exit('%s: %d bytes, expected %d' % (name, len(self.data), SECTOR_SIZE * SECTOR_COUNT))
+		else:
+			self.data = bytearray(b'\xff' * (SECTOR_SIZE * SECTOR_COUNT))
+
+	def save(self):
+		with open(self.name, 'wb') as f:
+			f.write(self.data)
+
+	def read(self, address, length):
+		return bytes(self.data[address:address + length])
+
+	def write(self, address, buffer):
+		if address // PAGE_SIZE != (address + len(buffer) - 1) // PAGE_SIZE:
+			raise FlashError('program 0x%06x+%d crosses a page' % (address, len(buffer)))
+		for i, b in enumerate(buffer):
+			old = self.data[address + i]
+			if b & ~old & 0xff:
+				raise FlashError('program 0x%06x: 0x%02x over 0x%02x needs an erase' % (address + i, b, old))
+			self.data[address + i] = old & b
+
+	def sector_erase(self, address):
+		address -= address % SECTOR_SIZE
+		self.data[address:address + SECTOR_SIZE] = b'\xff' * SECTOR_SIZE
+
+
+class Entry:
+	def __init__(self, raw):
+		(self.state, self.first_sector, self.sector_count, self.panel, self.format,
+		 _, self.length, self.crc, name) = ENTRY.unpack(raw)
+		self.name = name.split(b'\0', 1)[0].decode('latin-1')
+
+	def address(self):
+		return self.first_sector * SECTOR_SIZE
+
+
+def sectors_for(length):
+	return max(1, (length + SECTOR_SIZE - 1) // SECTOR_SIZE)
+
+
+class Store:
+	def __init__(self, flash):
+		self.flash = flash
+		self.directory = None
+		self.next_sector = FIRST_DATA_SECTOR
+
+	def entry_address(self, directory, id):
+		return directory * SECTOR_SIZE + (id + 1) * ENTRY_SIZE
+
+	def read_header(self, sector):
+		magic, version, entry_size, entries, _, sequence = HEADER.unpack(self.flash.read(sector * SECTOR_SIZE, HEADER.size))
+		if (MAGIC, VERSION, ENTRY_SIZE, ENTRIES) != (magic, version, entry_size, entries):
+			return None
+		return sequence
+
+	def write_header(self, sector, sequence):
+		self.flash.write(sector * SECTOR_SIZE, HEADER.pack(MAGIC, VERSION, ENTRY_SIZE, ENTRIES, 0xff, sequence & 0xffff))
+
+	def begin(self):
+		s0 = self.read_header(DIRECTORY_SECTOR)
+		s1 = self.read_header(DIRECTORY_SECTOR + 1)
+		if None is not s0 and (None is s1 or 0 < ((s0 - s1) & 0xffff) < 0x8000):
+			self.directory, self.sequence = DIRECTORY_SECTOR, s0
+		elif None is not s1:
+			self.directory, self.sequence = DIRECTORY_SECTOR + 1, s1
+		else:
+			self.directory = None
+			return False
+		self.used = set()
+		self.free_slots = 0
+		self.deleted_slots = 0
+		for id in range(ENTRIES):
+			e = self.get(id, any_state=True)
+			if VALID == e.state:
+				self.used.update(range(e.first_sector, e.first_sector + e.sector_count))
+			elif EMPTY == e.state:
+				self.free_slots += 1
+			else:
+				self.deleted_slots += 1
+		# allocate after the last image
+		self.next_sector = max(self.used) + 1 if self.used else FIRST_DATA_SECTOR
+		return True
+
+	def format(self):
+		for i in range(2):
+			self.flash.sector_erase((DIRECTORY_SECTOR + i) * SECTOR_SIZE)
+		self.write_header(DIRECTORY_SECTOR, 0)
+		self.begin()
+
+	def get(self, id, any_state=False):
+		e = Entry(self.flash.read(self.entry_address(self.directory, id), ENTRY_SIZE))
+		return e if any_state or VALID == e.state else None
+
+	def entries(self):
+		for id in range(ENTRIES):
+			e = self.get(id)
+			if e:
+				yield id, e
+
+	def find(self, name):
+		for id, e in self.entries():
+			if e.name == name:
+				return id, e
+		return None, None
+
+	def lookup(self, key):
+		id, e = self.find(key)
+		if None is e and key.isdigit() and int(key) < ENTRIES:
+			id, e = int(key), self.get(int(key))
+		if None is e:
+			sys.exit('%s: no such image' % key)
+		return id, e
+
+	def free_run(self, start, count):
+		run = 0
+		for s in range(start, SECTOR_COUNT):
+			if s in self.used:
+				run = 0
+				continue
+			run += 1
+			if run == count:
+				return s + 1 - count
+		return None
+
+	def allocate(self, length, erase=True):
+		# next fit, wrapping round to the first data sector
+		count = sectors_for(length)
+		first = self.free_run(self.next_sector, count)
+		if None is first:
+			first = self.free_run(FIRST_DATA_SECTOR, count)
+			if None is first:
+				return None
+		if erase:
+			for i in range(first, first + count):
+				self.flash.sector_erase(i * SECTOR_SIZE)
+		self.next_sector = first + count
+		return first
+
+	def compact(self):
+		if 0 == self.deleted_slots:
+			return False
+		old = self.directory
+		new = DIRECTORY_SECTOR + 1 if DIRECTORY_SECTOR == old else DIRECTORY_SECTOR
+		self.flash.sector_erase(new * SECTOR_SIZE)
+		for id in range(ENTRIES):
+			raw = self.flash.read(self.entry_address(old, id), ENTRY_SIZE)
+			if VALID == raw[0]:
+				self.flash.write(self.entry_address(new, id), raw)
+		self.write_header(new, self.sequence + 1)
+		self.flash.sector_erase(old * SECTOR_SIZE)
+		next_sector = self.next_sector
+		mounted = self.begin()
+		self.next_sector = next_sector
+		return mounted
+
+	def add(self, name, first_sector, length, panel, format, crc):
+		if 0 == self.free_slots and not self.compact():
+			return None
+		for id in range(ENTRIES):
+			if EMPTY == self.get(id, any_state=True).state:
+				break
+		else:
+			return None
+		count = sectors_for(length)
+		raw = ENTRY.pack(VALID, first_sector, count, panel, format, b'\xff\xff\xff', length, crc,
+		                 name.encode('latin-1')[:NAME_SIZE - 1])
+		self.flash.write(self.entry_address(self.directory, id), raw)
+		self.used.update(range(first_sector, first_sector + count))
+		self.free_slots -= 1
+		return id
+
+	def remove(self, id):
+		e = self.get(id)
+		if not e:
+			return False
+		self.flash.write(self.entry_address(self.directory, id), bytes([DELETED]))
+		self.used.difference_update(range(e.first_sector, e.first_sector + e.sector_count))
+		self.deleted_slots += 1
+		return True
+
+	def program(self, address, data):
+		offset = 0
+		while offset < len(data):
+			n = min(PAGE_SIZE - (address + offset) % PAGE_SIZE, len(data) - offset)
+			self.flash.write(address + offset, data[offset:offset + n])
+			offset += n
+
+
+def panel_for(width, height):
+	for panel, (_, w, h) in PANELS.items():
+		if (w, h) == (width, height):
+			return panel
+	return None
+
+
+def main():
+	parser = argparse.ArgumentParser(description='FLASH_STORE image tool (simulated FLASH)')
+	parser.add_argument('flash', help='FLASH image file')
+	sub = parser.add_subparsers(dest='command')
+	sub.required = True
+	sub.add_parser('format', help='create an empty image store')
+	p = sub.add_parser('add', help='store XBM images')
+	p.add_argument('-p', '--packbits', action='store_true', help='store PackBits compressed')
+	p.add_argument('-n', '--name', help='image name (default: file name)')
+	p.add_argument('images', nargs='+')
+	sub.add_parser('list', help='list stored images')
+	p = sub.add_parser('remove', help='delete an image')
+	p.add_argument('image', help='id or name')
+	p = sub.add_parser('extract', help='write the data of an image to a file')
+	p.add_argument('image', help='id or name')
+	p.add_argument('output')
+	sub.add_parser('check', help='verify the directory and image CRCs')
+	args = parser.parse_args()
+
+	flash = MockFlash(args.flash)
+	store = Store(flash)
+
+	if 'format' == args.command:
+		store.format()
+		flash.save()
+		return
+
+	if not store.begin():
+		sys.exit('%s: no image store, use format first' % args.flash)
+
+	if 'add' == args.command:
+		if args.name and 1 != len(args.images):
+			sys.exit('--name needs a single image')
+		for file_name in args.images:
+			width, height, data = read_xbm(file_name)
+			panel = panel_for(width, height)
+			if None is panel:
+				sys.exit('%s: %d x %d does not match a panel' % (file_name, width, height))
+			format = XBM
+			if args.packbits:
+				data = packbits(data)
+				format = PACKBITS
+			name = args.name or os.path.splitext(os.path.basename(file_name))[0]
+			if len(name) >= NAME_SIZE:
+				sys.exit('%s: name longer than %d characters' % (name, NAME_SIZE - 1))
+			old, _ = store.find(name)
+			if None is not old:
+				store.remove(old)
+			first = store.allocate(len(data))
+			if None is first:
+				sys.exit('%s: no run of %d free sectors' % (file_name, sectors_for(len(data))))
+			store.program(first * SECTOR_SIZE, data)
+			id = store.add(name, first, len(data), panel, format, zlib.crc32(data) & 0xffffffff)
+			if None is id:
+				sys.exit('%s: directory full' % file_name)
+			print('%3d %-15s sector %3d+%d %5d bytes' % (id, name, first, sectors_for(len(data)), len(data)))
+
+	elif 'list' == args.command:
+		for id, e in store.entries():
+			print('%3d %-15s sector %3d+%d %5d bytes %-4s %-8s crc %08x' % (
+				id, e.name, e.first_sector, e.sector_count, e.length,
+				PANELS.get(e.panel, ('?',))[0], FORMATS.get(e.format, '?'), e.crc))
+		print('directory sector %d, %d free entries, %d free sectors' % (
+			store.directory, store.free_slots + store.deleted_slots,
+			SECTOR_COUNT - FIRST_DATA_SECTOR - len(store.used)))
+
+	elif 'remove' == args.command:
+		id, _ = store.lookup(args.image)
+		store.remove(id)
+
+	elif 'extract' == args.command:
+		_, e = store.lookup(args.image)
+		with open(args.output, 'wb') as f:
+			f.write(flash.read(e.address(), e.length))
+
+	elif 'check' == args.command:
+		errors = 0
+		owner = {}
+		for id, e in store.entries():
+			if e.first_sector < FIRST_DATA_SECTOR or e.first_sector + e.sector_count > SECTOR_COUNT:
+				print('%d %s: sectors %d+%d out of range' % (id, e.name, e.first_sector, e.sector_count))
+				errors += 1
+			if e.sector_count != sectors_for(e.length):
+				print('%d %s: %d sectors for %d bytes' % (id, e.name, e.sector_count, e.length))
+				errors += 1
+			for s in range(e.first_sector, e.first_sector + e.sector_count):
+				if s in owner:
+					print('%d %s: sector %d also used by %d' % (id, e.name, s, owner[s]))
+					errors += 1
+				owner[s] = id
+			if zlib.crc32(flash.read(e.address(), e.length)) & 0xffffffff != e.crc:
+				print('%d %s: CRC mismatch' % (id, e.name))
+				errors += 1
+		print('%d errors' % errors)
+		sys.exit(1 if errors else 0)
+
+	flash.save()
+
+
+if '__main__' == __name__:
+	try:
+		main()
+	except FlashError as e:
+		sys.exit('FLASH: %s' % e)
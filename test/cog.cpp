@@ -0,0 +1,186 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include "cog.h"
+
+
+std::vector<cog_transaction> cog_log;
+
+static uint8_t cog_cs_pin;
+static bool cog_selected;
+
+
+static void cog_pin_write(uint8_t pin, uint8_t value) {
+	if (pin != cog_cs_pin) {
+		return;
+	}
+	if (LOW == value && !cog_selected) {
+		cog_log.push_back(cog_transaction());
+	}
+	cog_selected = LOW == value;
+}
+
+
+static uint8_t cog_spi_transfer(uint8_t value) {
+	if (cog_selected) {
+		cog_log.back().push_back(value);
+	}
+	return 0x00;
+}
+
+
+void cog_attach(uint8_t cs_pin) {
+	cog_cs_pin = cs_pin;
+	cog_selected = false;
+	cog_log.clear();
+	mock_on_pin_write = cog_pin_write;
+	mock_on_spi_transfer = cog_spi_transfer;
+}
+
+
+void cog_clear() {
+	cog_log.clear();
+	if (cog_selected) {
+		cog_log.push_back(cog_transaction());
+	}
+}
+
+
+uint8_t cog_even_pixels(uint8_t data, EPD_stage stage) {
+	uint8_t pixels = data & 0xaa;
+	switch(stage) {
+	case EPD_compensate:  // B -> W, W -> B (Current Image)
+		pixels = 0xaa | ((pixels ^ 0xaa) >> 1);
+		break;
+	case EPD_white:       // B -> N, W -> W (Current Image)
+		pixels = 0x55 + ((pixels ^ 0xaa) >> 1);
+		break;
+	case EPD_inverse:     // B -> N, W -> B (New Image)
+		pixels = 0x55 | (pixels ^ 0xaa);
+		break;
+	case EPD_normal:       // B -> B, W -> W (New Image)
+		pixels = 0xaa | (pixels >> 1);
+		break;
+	}
+	return pixels;
+}
+
+
+uint8_t cog_odd_pixels(uint8_t data, EPD_stage stage) {
+	uint8_t pixels = data & 0x55;
+	switch(stage) {
+	case EPD_compensate:  // B -> W, W -> B (Current Image)
+		pixels = 0xaa | (pixels ^ 0x55);
+		break;
+	case EPD_white:       // B -> N, W -> W (Current Image)
+		pixels = 0x55 + (pixels ^ 0x55);
+		break;
+	case EPD_inverse:     // B -> N, W -> B (New Image)
+		pixels = 0x55 | ((pixels ^ 0x55) << 1);
+		break;
+	case EPD_normal:       // B -> B, W -> W (New Image)
+		pixels = 0xaa | pixels;
+		break;
+	}
+	uint8_t p1 = (pixels >> 6) & 0x03;
+	uint8_t p2 = (pixels >> 4) & 0x03;
+	uint8_t p3 = (pixels >> 2) & 0x03;
+	uint8_t p4 = (pixels >> 0) & 0x03;
+	return (p1 << 0) | (p2 << 2) | (p3 << 4) | (p4 << 6);
+}
+
+
+std::vector<cog_command> cog_commands() {
+	std::vector<cog_command> commands;
+	bool indexed = false;
+	cog_command c;
+	for (size_t i = 0; i < cog_log.size(); ++i) {
+		const cog_transaction &t = cog_log[i];
+		if (2 == t.size() && 0x70 == t[0]) {
+			c.index = t[1];
+			indexed = true;
+		} else if (indexed && 0 != t.size() && 0x72 == t[0]) {
+			c.data.assign(t.begin() + 1, t.end());
+			commands.push_back(c);
+			indexed = false;
+		}
+	}
+	return commands;
+}
+
+
+bool cog_write_capture(const char *path) {
+	FILE *f = fopen(path, "w");
+	if (0 == f) {
+		return false;
+	}
+	fprintf(f, "# COG SPI transactions from the host build of EPD.cpp\n");
+	for (size_t i = 0; i < cog_log.size(); ++i) {
+		if (0 == cog_log[i].size()) {
+			continue;
+		}
+		for (size_t b = 0; b < cog_log[i].size(); ++b) {
+			fprintf(f, 0 == b ? "%02x" : " %02x", cog_log[i][b]);
+		}
+		fprintf(f, "\n");
+	}
+	return 0 == fclose(f);
+}
+
+
+uint16_t cog_lines(EPD_size size) {
+	return EPD_2_7 == size ? 176 : 96;
+}
+
+
+uint16_t cog_bytes_per_line(EPD_size size) {
+	switch (size) {
+	default:
+	case EPD_1_44:
+		return 128 / 8;
+	case EPD_2_0:
+		return 200 / 8;
+	case EPD_2_7:
+		return 264 / 8;
+	}
+}
+
+
+cog_transaction cog_line(EPD_size size, uint16_t line_no, const uint8_t *data, uint8_t fixed_value, EPD_stage stage) {
+	uint16_t bytes_per_line = cog_bytes_per_line(size);
+	uint16_t bytes_per_scan = cog_lines(size) / 4;
+	cog_transaction t;
+
+	t.push_back(0x72);
+	if (EPD_1_44 == size) {
+		t.push_back(0x00);  // border byte
+	}
+	for (uint16_t b = bytes_per_line; b > 0; --b) {
+		t.push_back(0 != data ? cog_even_pixels(data[b - 1], stage) : fixed_value);
+	}
+	for (uint16_t b = 0; b < bytes_per_scan; ++b) {
+		t.push_back(line_no / 4 == b ? 0xc0 >> (2 * (line_no & 0x03)) : 0x00);
+	}
+	for (uint16_t b = 0; b < bytes_per_line; ++b) {
+		t.push_back(0 != data ? cog_odd_pixels(data[b], stage) : fixed_value);
+	}
+	if (EPD_1_44 != size) {
+		t.push_back(0x00);  // filler
+	}
+	return t;
+}
@@ -0,0 +1,59 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// Records what the EPD driver sends to the COG and provides the reference
+// (per pixel, as in the original EPD_Class::line()) encoding to compare with
+
+#if !defined(COG_H)
+#define COG_H 1
+
+#include <vector>
+
+#include <Arduino.h>
+#include <EPD.h>
+
+// one chip select low..high transaction
+typedef std::vector<uint8_t> cog_transaction;
+
+// every transaction since cog_attach()/cog_clear()
+extern std::vector<cog_transaction> cog_log;
+
+// follow cs_pin and record SPI bytes sent while it is low
+void cog_attach(uint8_t cs_pin);
+void cog_clear();
+
+// reference encoding of an image byte
+uint8_t cog_even_pixels(uint8_t data, EPD_stage stage);
+uint8_t cog_odd_pixels(uint8_t data, EPD_stage stage);
+
+// the 0x72 line data transaction for one line (data == 0 sends fixed_value)
+cog_transaction cog_line(EPD_size size, uint16_t line_no, const uint8_t *data, uint8_t fixed_value, EPD_stage stage);
+
+// a register write: the 0x70 index transaction and the 0x72 data after it
+// (data without the 0x72), other transactions (e.g. SPI flush bytes) are skipped
+struct cog_command {
+	uint8_t index;
+	cog_transaction data;
+};
+std::vector<cog_command> cog_commands();
+
+// write cog_log in the cog_decode.py input format (one transaction per line)
+bool cog_write_capture(const char *path);
+
+// panel geometry
+uint16_t cog_lines(EPD_size size);
+uint16_t cog_bytes_per_line(EPD_size size);
+
+#endif
@@ -0,0 +1,345 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+#include <Arduino.h>
+
+#include "Adafruit_GFX.h"
+#include "glcdfont.c"
+
+
+template<class T> static void swap(T &a, T &b) {
+	T t = a;
+	a = b;
+	b = t;
+}
+
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h) :
+	WIDTH(w), HEIGHT(h), _width(w), _height(h),
+	cursor_x(0), cursor_y(0), textcolor(0xffff), textbgcolor(0xffff),
+	textsize(1), wrap(true) {
+}
+
+
+// Bresenham
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t colour) {
+	int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+	if (steep) {
+		swap(x0, y0);
+		swap(x1, y1);
+	}
+	if (x0 > x1) {
+		swap(x0, x1);
+		swap(y0, y1);
+	}
+
+	int16_t dx = x1 - x0;
+	int16_t dy = abs(y1 - y0);
+	int16_t err = dx / 2;
+	int16_t ystep = (y0 < y1) ? 1 : -1;
+
+	for (; x0 <= x1; x0++) {
+		if (steep) {
+			drawPixel(y0, x0, colour);
+		} else {
+			drawPixel(x0, y0, colour);
+		}
+		err -= dy;
+		if (err < 0) {
+			y0 += ystep;
+			err += dx;
+		}
+	}
+}
+
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t colour) {
+	drawLine(x, y, x, y + h - 1, colour);
+}
+
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t colour) {
+	drawLine(x, y, x + w - 1, y, colour);
+}
+
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) {
+	drawFastHLine(x, y, w, colour);
+	drawFastHLine(x, y + h - 1, w, colour);
+	drawFastVLine(x, y, h, colour);
+	drawFastVLine(x + w - 1, y, h, colour);
+}
+
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) {
+	for (int16_t i = x; i < x + w; i++) {
+		drawFastVLine(i, y, h, colour);
+	}
+}
+
+
+void Adafruit_GFX::fillScreen(uint16_t colour) {
+	fillRect(0, 0, _width, _height, colour);
+}
+
+
+// midpoint circle
+void Adafruit_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colour) {
+	int16_t f = 1 - r;
+	int16_t ddF_x = 1;
+	int16_t ddF_y = -2 * r;
+	int16_t x = 0;
+	int16_t y = r;
+
+	drawPixel(x0, y0 + r, colour);
+	drawPixel(x0, y0 - r, colour);
+	drawPixel(x0 + r, y0, colour);
+	drawPixel(x0 - r, y0, colour);
+
+	while (x < y) {
+		if (f >= 0) {
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+
+		drawPixel(x0 + x, y0 + y, colour);
+		drawPixel(x0 - x, y0 + y, colour);
+		drawPixel(x0 + x, y0 - y, colour);
+		drawPixel(x0 - x, y0 - y, colour);
+		drawPixel(x0 + y, y0 + x, colour);
+		drawPixel(x0 - y, y0 + x, colour);
+		drawPixel(x0 + y, y0 - x, colour);
+		drawPixel(x0 - y, y0 - x, colour);
+	}
+}
+
+
+void Adafruit_GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colour) {
+	drawFastVLine(x0, y0 - r, 2 * r + 1, colour);
+	fillCircleHelper(x0, y0, r, 3, 0, colour);
+}
+
+
+// the right (cornername bit 0) and left (bit 1) halves of a filled circle
+void Adafruit_GFX::fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, int16_t delta, uint16_t colour) {
+	int16_t f = 1 - r;
+	int16_t ddF_x = 1;
+	int16_t ddF_y = -2 * r;
+	int16_t x = 0;
+	int16_t y = r;
+
+	while (x < y) {
+		if (f >= 0) {
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+
+		if (cornername & 0x1) {
+			drawFastVLine(x0 + x, y0 - y, 2 * y + 1 + delta, colour);
+			drawFastVLine(x0 + y, y0 - x, 2 * x + 1 + delta, colour);
+		}
+		if (cornername & 0x2) {
+			drawFastVLine(x0 - x, y0 - y, 2 * y + 1 + delta, colour);
+			drawFastVLine(x0 - y, y0 - x, 2 * x + 1 + delta, colour);
+		}
+	}
+}
+
+
+void Adafruit_GFX::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t colour) {
+	drawLine(x0, y0, x1, y1, colour);
+	drawLine(x1, y1, x2, y2, colour);
+	drawLine(x2, y2, x0, y0, colour);
+}
+
+
+// horizontal spans between the edges, top to bottom
+void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t colour) {
+	int16_t a, b, y, last;
+
+	// sort by y (y2 >= y1 >= y0)
+	if (y0 > y1) {
+		swap(y0, y1);
+		swap(x0, x1);
+	}
+	if (y1 > y2) {
+		swap(y2, y1);
+		swap(x2, x1);
+	}
+	if (y0 > y1) {
+		swap(y0, y1);
+		swap(x0, x1);
+	}
+
+	if (y0 == y2) {
+		// all on one row
+		a = b = x0;
+		if (x1 < a) {
+			a = x1;
+		} else if (x1 > b) {
+			b = x1;
+		}
+		if (x2 < a) {
+			a = x2;
+		} else if (x2 > b) {
+			b = x2;
+		}
+		drawFastHLine(a, y0, b - a + 1, colour);
+		return;
+	}
+
+	int16_t dx01 = x1 - x0;
+	int16_t dy01 = y1 - y0;
+	int16_t dx02 = x2 - x0;
+	int16_t dy02 = y2 - y0;
+	int16_t dx12 = x2 - x1;
+	int16_t dy12 = y2 - y1;
+	int32_t sa = 0;
+	int32_t sb = 0;
+
+	// the upper part (down to y1, or y1 - 1 if the lower part has rows)
+	if (y1 == y2) {
+		last = y1;
+	} else {
+		last = y1 - 1;
+	}
+	for (y = y0; y <= last; y++) {
+		a = x0 + sa / dy01;
+		b = x0 + sb / dy02;
+		sa += dx01;
+		sb += dx02;
+		if (a > b) {
+			swap(a, b);
+		}
+		drawFastHLine(a, y, b - a + 1, colour);
+	}
+
+	// the lower part
+	sa = dx12 * (y - y1);
+	sb = dx02 * (y - y0);
+	for (; y <= y2; y++) {
+		a = x1 + sa / dy12;
+		b = x0 + sb / dy02;
+		sa += dx12;
+		sb += dx02;
+		if (a > b) {
+			swap(a, b);
+		}
+		drawFastHLine(a, y, b - a + 1, colour);
+	}
+}
+
+
+// rows MSB first, set bits drawn, clear bits left alone
+void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t colour) {
+	int16_t byte_width = (w + 7) / 8;
+	for (int16_t j = 0; j < h; j++) {
+		for (int16_t i = 0; i < w; i++) {
+			if (pgm_read_byte(bitmap + j * byte_width + i / 8) & (128 >> (i & 7))) {
+				drawPixel(x + i, y + j, colour);
+			}
+		}
+	}
+}
+
+
+// a 5x7 glyph in a 6x8 cell, scaled by size
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t colour, uint16_t bg, uint8_t size) {
+	if ((x >= _width) || (y >= _height) || ((x + 6 * size - 1) < 0) || ((y + 8 * size - 1) < 0)) {
+		return;
+	}
+
+	for (int8_t i = 0; i < 6; i++) {
+		uint8_t line = (5 == i) ? 0x00 : pgm_read_byte(font + (c * 5) + i);
+		for (int8_t j = 0; j < 8; j++, line >>= 1) {
+			if (line & 0x1) {
+				if (1 == size) {
+					drawPixel(x + i, y + j, colour);
+				} else {
+					fillRect(x + (i * size), y + (j * size), size, size, colour);
+				}
+			} else if (bg != colour) {
+				if (1 == size) {
+					drawPixel(x + i, y + j, bg);
+				} else {
+					fillRect(x + i * size, y + j * size, size, size, bg);
+				}
+			}
+		}
+	}
+}
+
+
+void Adafruit_GFX::setCursor(int16_t x, int16_t y) {
+	cursor_x = x;
+	cursor_y = y;
+}
+
+
+void Adafruit_GFX::setTextColor(uint16_t c) {
+	// the same background as foreground: transparent
+	textcolor = c;
+	textbgcolor = c;
+}
+
+
+void Adafruit_GFX::setTextColor(uint16_t c, uint16_t bg) {
+	textcolor = c;
+	textbgcolor = bg;
+}
+
+
+void Adafruit_GFX::setTextSize(uint8_t s) {
+	textsize = (s > 0) ? s : 1;
+}
+
+
+void Adafruit_GFX::setTextWrap(boolean w) {
+	wrap = w;
+}
+
+
+size_t Adafruit_GFX::write(uint8_t c) {
+	if ('\n' == c) {
+		cursor_y += textsize * 8;
+		cursor_x = 0;
+	} else if ('\r' == c) {
+		// skip
+	} else {
+		drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+		cursor_x += textsize * 6;
+		if (wrap && (cursor_x > (_width - textsize * 6))) {
+			cursor_y += textsize * 8;
+			cursor_x = 0;
+		}
+	}
+	return 1;
+}
+
+
+void Adafruit_GFX::print(const char *s) {
+	while ('\0' != *s) {
+		write(*s++);
+	}
+}
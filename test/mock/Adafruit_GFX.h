@@ -0,0 +1,79 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+// Host stand-in for the Adafruit_GFX library (the 2013 release EPD_GFX is
+// written against): the same drawing algorithms, each ending in drawPixel()
+// or one of the virtual span functions, so a subclass gets the pixels the
+// real library would give.  Text is drawn with the glyphs in glcdfont.c.
+
+#if !defined(MOCK_ADAFRUIT_GFX_H)
+#define MOCK_ADAFRUIT_GFX_H 1
+
+#include <Arduino.h>
+
+class Adafruit_GFX {
+public:
+	Adafruit_GFX(int16_t w, int16_t h);
+	virtual ~Adafruit_GFX() {}
+
+	// the colour is an unsigned int as uint16_t is on AVR
+	virtual void drawPixel(int16_t x, int16_t y, unsigned int colour) = 0;
+
+	virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t colour);
+	virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t colour);
+	virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t colour);
+	virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour);
+	virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour);
+	virtual void fillScreen(uint16_t colour);
+
+	void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colour);
+	void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colour);
+	void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t colour);
+	void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t colour);
+	void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t colour);
+	virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t colour, uint16_t bg, uint8_t size);
+
+	void setCursor(int16_t x, int16_t y);
+	void setTextColor(uint16_t c);
+	void setTextColor(uint16_t c, uint16_t bg);
+	void setTextSize(uint8_t s);
+	void setTextWrap(boolean w);
+	virtual size_t write(uint8_t c);
+	void print(const char *s);
+
+	int16_t width() {
+		return _width;
+	}
+	int16_t height() {
+		return _height;
+	}
+
+protected:
+	void fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, int16_t delta, uint16_t colour);
+
+	const int16_t WIDTH;
+	const int16_t HEIGHT;
+	int16_t _width;
+	int16_t _height;
+	int16_t cursor_x;
+	int16_t cursor_y;
+	uint16_t textcolor;
+	uint16_t textbgcolor;
+	uint8_t textsize;
+	boolean wrap;
+};
+
+#endif
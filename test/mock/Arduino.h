@@ -0,0 +1,144 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// Host (PC) stand-in for the Arduino core, enough to build the libraries
+// for the tests in this directory.  Time is simulated: it only moves when
+// the code under test calls delay()/delayMicroseconds() or sends SPI bytes.
+// See mock.h for the hooks the tests use to play the part of the hardware.
+
+#if !defined(MOCK_ARDUINO_H)
+#define MOCK_ARDUINO_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+
+// the C++ library has to be seen before the min/max macros below
+#if defined(__cplusplus)
+#include <algorithm>
+#include <string>
+#include <vector>
+#endif
+
+#include <avr/pgmspace.h>
+
+typedef uint8_t boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define DEC 10
+#define HEX 16
+
+#define DEFAULT 1
+#define INTERNAL2V5 2
+
+#define A0 14
+#define A4 18
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+#include "mock.h"
+
+inline unsigned long millis() {
+	return mock_micros / 1000;
+}
+inline unsigned long micros() {
+	return mock_micros;
+}
+inline void delay(unsigned long ms) {
+	mock_micros += ms * 1000;
+}
+inline void delayMicroseconds(unsigned int us) {
+	mock_micros += us;
+}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+int analogRead(uint8_t pin);
+inline void analogReference(uint8_t) {}
+void analogWrite(uint8_t pin, int value);
+
+// every pin is on one port whose input register is mock_port
+inline uint8_t digitalPinToPort(uint8_t) {
+	return 0;
+}
+inline uint8_t digitalPinToBitMask(uint8_t pin) {
+	return 1 << (pin & 7);
+}
+inline volatile uint8_t *portInputRegister(uint8_t) {
+	return &mock_port;
+}
+inline volatile uint8_t *portOutputRegister(uint8_t) {
+	return &mock_port;
+}
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+
+// Serial output goes to stdout when mock_serial_echo is set, input comes from mock_serial_input
+class HardwareSerial {
+public:
+	void begin(long) {}
+	operator bool() {
+		return true;
+	}
+	int available();
+	int read();
+	size_t write(uint8_t c);
+	void print(const char *s);
+	void print(char c);
+	void print(long n, int base = DEC);
+	void print(int n, int base = DEC) {
+		this->print((long)n, base);
+	}
+	void print(unsigned int n, int base = DEC) {
+		this->print((long)n, base);
+	}
+	void print(unsigned long n, int base = DEC);
+	void print(uint8_t n, int base = DEC) {
+		this->print((long)n, base);
+	}
+	void println() {
+		this->print("\n");
+	}
+	template<class T> void println(T value) {
+		this->print(value);
+		this->println();
+	}
+	template<class T> void println(T value, int base) {
+		this->print(value, base);
+		this->println();
+	}
+};
+
+extern HardwareSerial Serial;
+
+#endif
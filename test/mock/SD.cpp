@@ -0,0 +1,119 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <SD.h>
+
+
+SDClass SD;
+unsigned long mock_sd_reads;
+unsigned long mock_sd_seeks;
+unsigned long mock_sd_wrong_mode;
+
+
+void mock_sd_reset() {
+	mock_sd_reads = 0;
+	mock_sd_seeks = 0;
+	mock_sd_wrong_mode = 0;
+}
+
+
+// the card only talks SPI mode 0
+static void mock_sd_access(unsigned long *counter) {
+	++*counter;
+	if (SPI_MODE0 != mock_spi_mode) {
+		++mock_sd_wrong_mode;
+	}
+}
+
+
+File::File(FILE *file) : file(file), length(0) {
+	if (0 != file) {
+		fseek(file, 0, SEEK_END);
+		this->length = ftell(file);
+		fseek(file, 0, SEEK_SET);
+	}
+}
+
+
+int File::read() {
+	uint8_t c;
+	return 1 == this->read(&c, 1) ? c : -1;
+}
+
+
+int File::read(void *buffer, uint16_t length) {
+	if (0 == this->file) {
+		return -1;
+	}
+	mock_sd_access(&mock_sd_reads);
+	return fread(buffer, 1, length, this->file);
+}
+
+
+int File::peek() {
+	if (0 == this->file) {
+		return -1;
+	}
+	int c = fgetc(this->file);
+	if (EOF != c) {
+		ungetc(c, this->file);
+	}
+	return EOF == c ? -1 : c;
+}
+
+
+bool File::seek(uint32_t position) {
+	if (0 == this->file || position > this->length) {
+		return false;
+	}
+	mock_sd_access(&mock_sd_seeks);
+	return 0 == fseek(this->file, position, SEEK_SET);
+}
+
+
+uint32_t File::position() {
+	return 0 == this->file ? 0 : ftell(this->file);
+}
+
+
+uint32_t File::size() {
+	return this->length;
+}
+
+
+int File::available() {
+	return this->size() - this->position();
+}
+
+
+void File::close() {
+	if (0 != this->file) {
+		fclose(this->file);
+		this->file = 0;
+	}
+}
+
+
+bool SDClass::begin(uint8_t) {
+	return true;
+}
+
+
+File SDClass::open(const char *path, uint8_t) {
+	return File(fopen(path, "rb"));
+}
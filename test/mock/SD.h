@@ -0,0 +1,66 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+// Host stand-in for the Arduino SD library: files are read from the PC's
+// file system through stdio (copies of a File share the open file, as with
+// the SD library)
+
+#if !defined(MOCK_SD_H)
+#define MOCK_SD_H 1
+
+#include <Arduino.h>
+
+#define FILE_READ 0x01
+
+// file accesses since mock_sd_reset(), for checking how a reader uses the card
+extern unsigned long mock_sd_reads;       // read() calls (of a block or a byte)
+extern unsigned long mock_sd_seeks;       // seek() calls
+extern unsigned long mock_sd_wrong_mode;  // reads and seeks with the SPI not in SPI_MODE0
+void mock_sd_reset();
+
+class File {
+private:
+	FILE *file;
+	uint32_t length;
+
+public:
+	File(FILE *file = 0);
+
+	int read();
+	int read(void *buffer, uint16_t length);
+	int peek();
+	bool seek(uint32_t position);
+	uint32_t position();
+	uint32_t size();
+	int available();
+	void close();
+
+	operator bool() {
+		return 0 != this->file;
+	}
+};
+
+class SDClass {
+public:
+	bool begin(uint8_t chip_select_pin);
+
+	// path on the PC
+	File open(const char *path, uint8_t mode = FILE_READ);
+};
+
+extern SDClass SD;
+
+#endif
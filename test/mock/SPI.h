@@ -0,0 +1,58 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// Host stand-in for the Arduino SPI library: each transfer() is passed to
+// the device hook in mock.h
+
+#if !defined(MOCK_SPI_H)
+#define MOCK_SPI_H 1
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0c
+
+#define SPI_CLOCK_DIV4 0x00
+#define SPI_CLOCK_DIV16 0x01
+#define SPI_CLOCK_DIV64 0x02
+#define SPI_CLOCK_DIV128 0x03
+#define SPI_CLOCK_DIV2 0x04
+#define SPI_CLOCK_DIV8 0x05
+#define SPI_CLOCK_DIV32 0x06
+
+class SPIClass {
+public:
+	uint8_t transfer(uint8_t value);
+	void begin();
+	void end();
+	void setBitOrder(uint8_t order);
+	void setDataMode(uint8_t mode);
+	void setClockDivider(uint8_t divider);
+};
+
+extern SPIClass SPI;
+
+// the SPI transfer complete interrupt, for code built with EPD_SPI_INTERRUPT_MOCK
+// SPI_mock_write() starts sending a byte (SPDR = value) and returns at once,
+// SPI_mock_interrupt() sets the handler (SPIE on) or 0 (SPIE off), and
+// mock_spi_tick() runs the handler if a byte has finished and it is enabled
+typedef void SPI_mock_isr(void);
+void SPI_mock_write(uint8_t value);
+void SPI_mock_interrupt(SPI_mock_isr *isr);
+bool mock_spi_tick();
+
+#endif
@@ -0,0 +1,66 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+#include <Arduino.h>
+#include <Wire.h>
+
+
+TwoWire Wire;
+uint8_t mock_wire_response[MOCK_WIRE_BUFFER];
+uint8_t mock_wire_response_length;
+unsigned long mock_wire_requests;
+uint8_t mock_wire_address;
+
+
+void mock_wire_reset() {
+	mock_wire_response_length = 0;
+	mock_wire_requests = 0;
+	mock_wire_address = 0;
+}
+
+
+void TwoWire::beginTransmission(uint8_t address) {
+	mock_wire_address = address;
+}
+
+
+size_t TwoWire::write(uint8_t) {
+	return 1;
+}
+
+
+uint8_t TwoWire::endTransmission() {
+	return 0;
+}
+
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+	++mock_wire_requests;
+	mock_wire_address = address;
+	this->received = min(quantity, mock_wire_response_length);
+	this->next = 0;
+	return this->received;
+}
+
+
+int TwoWire::available() {
+	return this->received - this->next;
+}
+
+
+int TwoWire::read() {
+	return this->next < this->received ? mock_wire_response[this->next++] : -1;
+}
@@ -0,0 +1,54 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+// Host stand-in for the Arduino Wire (I2C) library with one device that
+// answers every requestFrom() with the bytes the test puts in
+// mock_wire_response (an LM75A's temperature register, say)
+
+#if !defined(MOCK_WIRE_H)
+#define MOCK_WIRE_H 1
+
+#include <Arduino.h>
+
+#define MOCK_WIRE_BUFFER 8
+
+// the device's answer: mock_wire_response_length bytes, 0 for no answer
+extern uint8_t mock_wire_response[MOCK_WIRE_BUFFER];
+extern uint8_t mock_wire_response_length;
+
+// requestFrom() calls since mock_wire_reset(), and the last address written
+extern unsigned long mock_wire_requests;
+extern uint8_t mock_wire_address;
+void mock_wire_reset();
+
+class TwoWire {
+private:
+	uint8_t received;
+	uint8_t next;
+
+public:
+	void begin() {}
+	void beginTransmission(uint8_t address);
+	size_t write(uint8_t value);
+	uint8_t endTransmission();
+	uint8_t requestFrom(uint8_t address, uint8_t quantity);
+	int available();
+	int read();
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,35 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// AVR program memory on the host is just memory
+
+#if !defined(MOCK_PGMSPACE_H)
+#define MOCK_PGMSPACE_H 1
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_byte_near(p) pgm_read_byte(p)
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_word_near(p) pgm_read_word(p)
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_dword_near(p) pgm_read_dword(p)
+
+#define memcpy_P memcpy
+
+#endif
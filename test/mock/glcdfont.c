@@ -0,0 +1,286 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+// Host stand-in for the Adafruit_GFX font: 256 glyphs of 5 columns (bit 0
+// is the top row) in the same layout as the real glcdfont.c.  The glyphs
+// are not letters, just a fixed pattern with every column used and rows 0
+// to 7 set in some of them, which is all the text drawing tests compare.
+
+#if !defined(MOCK_GLCDFONT_C)
+#define MOCK_GLCDFONT_C 1
+
+#include <avr/pgmspace.h>
+
+static const unsigned char font[] PROGMEM = {
+	0x00, 0x00, 0x00, 0x00, 0x00,
+	0xfb, 0xe2, 0xfb, 0x54, 0xf6,
+	0xbd, 0xdf, 0x7c, 0x1c, 0xe1,
+	0x87, 0x01, 0xbf, 0x31, 0xde,
+	0x56, 0x72, 0x0f, 0x47, 0x67,
+	0x66, 0x87, 0x59, 0xaa, 0x88,
+	0x3c, 0x59, 0xea, 0x56, 0x13,
+	0x7b, 0xd2, 0x85, 0xa1, 0xd8,
+	0x3c, 0x54, 0x55, 0x2f, 0x37,
+	0xae, 0x65, 0x5b, 0xda, 0x02,
+	0x79, 0x98, 0xcc, 0xe3, 0x1a,
+	0x76, 0x8e, 0x5f, 0xd9, 0x99,
+	0x8f, 0x1f, 0x3f, 0x36, 0xee,
+	0x43, 0x78, 0x4d, 0x0d, 0xfa,
+	0xbe, 0xa6, 0xda, 0xe4, 0x86,
+	0x8e, 0xdc, 0x29, 0x6d, 0x4e,
+	0xff, 0x56, 0xe1, 0x70, 0x20,
+	0xfb, 0x8f, 0xb1, 0x58, 0x05,
+	0x90, 0xc5, 0x09, 0xdc, 0x53,
+	0xcd, 0xaa, 0x3b, 0x48, 0x99,
+	0x52, 0xd3, 0x52, 0x9d, 0x06,
+	0x9f, 0xea, 0xb5, 0xc2, 0x06,
+	0x13, 0x98, 0x49, 0xb2, 0x01,
+	0x1e, 0xac, 0x32, 0x88, 0x31,
+	0x9c, 0x52, 0x46, 0x95, 0x71,
+	0x36, 0x8f, 0x57, 0xf6, 0x39,
+	0x1d, 0x16, 0xfa, 0x88, 0x74,
+	0xf5, 0x98, 0x7c, 0x17, 0x5c,
+	0x41, 0xbb, 0x6d, 0x71, 0x8e,
+	0x0f, 0x70, 0x59, 0xc7, 0x01,
+	0x1b, 0x2f, 0x33, 0x3d, 0x91,
+	0xc0, 0x1d, 0xa5, 0x0d, 0x0d,
+	0xab, 0x33, 0x8d, 0x7e, 0x5e,
+	0x8f, 0x3e, 0xe6, 0x68, 0x74,
+	0xa6, 0x3a, 0xb1, 0xc3, 0x93,
+	0x11, 0xa8, 0x64, 0xc7, 0xdb,
+	0xca, 0xe0, 0x60, 0xe1, 0xf3,
+	0xbf, 0x09, 0x00, 0x67, 0xa2,
+	0xe3, 0x25, 0xa0, 0x21, 0x31,
+	0x87, 0xd5, 0x62, 0xc5, 0xa8,
+	0x4f, 0x7e, 0x2e, 0x09, 0x6b,
+	0x94, 0x9f, 0xb0, 0x6d, 0xa9,
+	0x9e, 0x5a, 0x0b, 0x46, 0x70,
+	0x80, 0xb6, 0xcf, 0x47, 0x0c,
+	0xa6, 0xa5, 0x2a, 0xd8, 0xac,
+	0xfb, 0xa0, 0xeb, 0xb7, 0x79,
+	0x24, 0x72, 0x23, 0x92, 0x48,
+	0x80, 0xc5, 0xa6, 0xa7, 0x85,
+	0xb7, 0xd7, 0x8c, 0x90, 0xe4,
+	0xab, 0x63, 0x44, 0x52, 0x66,
+	0xe3, 0x9c, 0x33, 0x25, 0xf9,
+	0x5e, 0xaa, 0xba, 0x73, 0x60,
+	0x5d, 0x4b, 0x71, 0x7e, 0xbe,
+	0xa9, 0x8c, 0x57, 0x19, 0x71,
+	0xc3, 0xca, 0x5e, 0xe5, 0x2a,
+	0x33, 0xac, 0x88, 0x51, 0x66,
+	0xa1, 0x7b, 0x75, 0x67, 0x64,
+	0x9a, 0x69, 0xef, 0x6f, 0x56,
+	0x42, 0xa0, 0x1d, 0x51, 0xc5,
+	0x02, 0xf7, 0xbb, 0x92, 0x45,
+	0xbe, 0x6f, 0x0d, 0xb6, 0x38,
+	0xcc, 0x10, 0xfd, 0xbb, 0x54,
+	0x51, 0x1c, 0x7b, 0x07, 0x94,
+	0x27, 0x93, 0x7d, 0x92, 0xc3,
+	0xd4, 0xc6, 0xa5, 0x61, 0x51,
+	0x01, 0x38, 0x38, 0xa7, 0xbf,
+	0xf1, 0x04, 0x0d, 0x15, 0x9b,
+	0x80, 0x1f, 0x83, 0xd5, 0xa4,
+	0x69, 0x88, 0x7c, 0x9f, 0xb6,
+	0x01, 0xda, 0x93, 0x17, 0x45,
+	0x8b, 0x12, 0xb2, 0x02, 0x33,
+	0x5c, 0x50, 0xd6, 0xe1, 0x56,
+	0xa4, 0xad, 0x42, 0x4a, 0x5c,
+	0xdd, 0x86, 0x61, 0xe9, 0x03,
+	0x12, 0xe1, 0x0f, 0x9b, 0xea,
+	0x26, 0x2c, 0x61, 0xdc, 0x62,
+	0x48, 0x6b, 0x6d, 0x14, 0xe0,
+	0x03, 0x85, 0x4a, 0x72, 0x46,
+	0xda, 0x96, 0xc8, 0x7d, 0x1c,
+	0xd1, 0x05, 0x3e, 0xe5, 0x92,
+	0x70, 0x43, 0x5f, 0x6c, 0x03,
+	0x05, 0xb3, 0xeb, 0xb3, 0x20,
+	0x35, 0x4d, 0x7e, 0x66, 0x50,
+	0x01, 0x36, 0xc0, 0x33, 0xe1,
+	0x0f, 0xc9, 0x38, 0x2e, 0xe9,
+	0x29, 0x19, 0x4f, 0x5e, 0xb1,
+	0xd1, 0x49, 0x8b, 0x3b, 0x53,
+	0xfd, 0x9f, 0x3f, 0xee, 0x25,
+	0x25, 0x35, 0x7b, 0x0d, 0x11,
+	0xaf, 0x4c, 0x11, 0x8c, 0x32,
+	0xd4, 0xda, 0x7f, 0xd8, 0x16,
+	0x57, 0xe1, 0xa6, 0xce, 0x7d,
+	0xc1, 0xae, 0x62, 0xbf, 0x13,
+	0xe4, 0x87, 0x4c, 0x3a, 0xc1,
+	0xb3, 0x0c, 0x59, 0x99, 0x47,
+	0x58, 0x5a, 0xbd, 0x78, 0x7c,
+	0xba, 0x50, 0x01, 0xed, 0x1b,
+	0xea, 0x8a, 0x49, 0x88, 0xee,
+	0xd6, 0x14, 0x85, 0xab, 0xb0,
+	0x2c, 0xde, 0x35, 0x93, 0x11,
+	0x2d, 0x01, 0x1c, 0xd7, 0x28,
+	0x43, 0x30, 0xe7, 0xb0, 0x08,
+	0xed, 0x79, 0x99, 0x13, 0x51,
+	0xd2, 0x3a, 0x77, 0xad, 0x3d,
+	0xb4, 0xf8, 0xc7, 0xca, 0x03,
+	0x22, 0xd2, 0xc9, 0xc6, 0x27,
+	0x0f, 0x04, 0xce, 0x7a, 0x3f,
+	0xc0, 0x68, 0x2c, 0xcf, 0x72,
+	0x6a, 0x09, 0xc2, 0x42, 0x00,
+	0x72, 0x5e, 0x41, 0x34, 0xf8,
+	0x96, 0x69, 0x3f, 0xbd, 0x3a,
+	0x58, 0x91, 0x8b, 0xe1, 0xcc,
+	0xa2, 0xb1, 0x92, 0xdd, 0x77,
+	0xa1, 0x35, 0xfe, 0xf3, 0x4b,
+	0xbc, 0xb1, 0xe3, 0x37, 0x11,
+	0x0d, 0xc7, 0x65, 0xbe, 0xf1,
+	0x61, 0xe5, 0x5e, 0x06, 0xff,
+	0x35, 0xc7, 0x76, 0x89, 0x5d,
+	0xf4, 0x6e, 0x4a, 0xcc, 0xb5,
+	0x54, 0x7e, 0xf1, 0x15, 0xc8,
+	0xa0, 0x99, 0x8f, 0x5c, 0x70,
+	0x0b, 0xef, 0x14, 0xc6, 0xe5,
+	0x0a, 0x9c, 0x19, 0xb4, 0x1d,
+	0x4c, 0xce, 0x56, 0x06, 0xdc,
+	0x42, 0x11, 0x25, 0xe7, 0x96,
+	0x6f, 0x0f, 0x21, 0x3d, 0xdf,
+	0xf9, 0x57, 0x47, 0x0d, 0xdf,
+	0x2b, 0x6a, 0xfc, 0x77, 0x8d,
+	0xd5, 0xe9, 0xd9, 0xf9, 0xb5,
+	0xe0, 0xeb, 0x72, 0x84, 0x1a,
+	0x8e, 0x42, 0x14, 0x1d, 0x8a,
+	0x6e, 0x5f, 0x92, 0x3a, 0xfb,
+	0x0b, 0xe5, 0xf6, 0xe4, 0xc0,
+	0x9f, 0x45, 0xd6, 0x2a, 0x83,
+	0xbf, 0xb1, 0xcd, 0x6a, 0xc4,
+	0xbf, 0x8c, 0xde, 0xdf, 0xb2,
+	0xf7, 0x79, 0xf7, 0x60, 0x57,
+	0xfc, 0x3b, 0x3d, 0x7b, 0x2e,
+	0xcb, 0x9c, 0x41, 0x7b, 0x27,
+	0xa5, 0xe3, 0x48, 0x58, 0x15,
+	0x07, 0x17, 0xe0, 0xb9, 0x85,
+	0x5f, 0x63, 0xa8, 0xf6, 0x29,
+	0x12, 0x43, 0x00, 0x6a, 0xdb,
+	0xee, 0x64, 0x24, 0x52, 0x8b,
+	0xc4, 0x3b, 0x5d, 0xbb, 0x35,
+	0x18, 0xa2, 0xd3, 0x89, 0xff,
+	0xb2, 0xa0, 0x59, 0x30, 0xf2,
+	0xdb, 0xd5, 0xc1, 0x4d, 0x6a,
+	0x4b, 0x36, 0x9c, 0x5d, 0x78,
+	0xe6, 0xd0, 0xa3, 0x92, 0x0d,
+	0xe5, 0x90, 0x11, 0xb0, 0x86,
+	0x0f, 0x41, 0x34, 0x80, 0xa6,
+	0x89, 0xbd, 0xe9, 0x2f, 0x78,
+	0x47, 0x0d, 0x50, 0x95, 0x87,
+	0x1b, 0xbf, 0xe3, 0x7f, 0x94,
+	0x37, 0x36, 0xe4, 0x6f, 0x39,
+	0x38, 0x2f, 0x0c, 0x83, 0x3a,
+	0x85, 0xdf, 0x51, 0xbc, 0x48,
+	0xd9, 0x56, 0xbb, 0x79, 0x95,
+	0x79, 0xbd, 0xd4, 0x48, 0x50,
+	0x9d, 0xa9, 0x65, 0x5d, 0x17,
+	0x7c, 0x13, 0x0b, 0x12, 0x5c,
+	0x4f, 0x67, 0xb0, 0x04, 0xe1,
+	0x9e, 0x18, 0xb3, 0x00, 0x3a,
+	0xfe, 0xcb, 0xc4, 0x1c, 0xf7,
+	0x2b, 0x50, 0x38, 0x7e, 0x4e,
+	0xbb, 0x13, 0xc5, 0x20, 0xc3,
+	0xfe, 0x3d, 0xa4, 0x30, 0x0f,
+	0xe4, 0x47, 0x0a, 0xe4, 0x52,
+	0x01, 0x7a, 0x17, 0x81, 0x31,
+	0x80, 0x80, 0x5f, 0x35, 0x5a,
+	0x2d, 0x15, 0xcc, 0xb0, 0x22,
+	0x15, 0x2d, 0x80, 0xd1, 0xe6,
+	0xe4, 0xcc, 0x58, 0xaf, 0x6f,
+	0x05, 0x7d, 0x85, 0x9c, 0x35,
+	0x6a, 0x74, 0xa0, 0xf0, 0x28,
+	0x4f, 0xf7, 0xf9, 0xdc, 0x38,
+	0x00, 0xb3, 0xc4, 0xee, 0x54,
+	0x4e, 0xf1, 0xd9, 0xea, 0xad,
+	0xc2, 0xd7, 0xeb, 0x19, 0x24,
+	0xc4, 0x56, 0xa8, 0x8b, 0xcb,
+	0x54, 0x6b, 0xaf, 0x70, 0x58,
+	0x5a, 0x07, 0x59, 0xfe, 0x00,
+	0x06, 0xdf, 0xa1, 0xe6, 0x18,
+	0x59, 0xba, 0xc1, 0x5b, 0x23,
+	0xfc, 0x5b, 0x1e, 0x70, 0x30,
+	0x42, 0x1a, 0xd4, 0xd0, 0x32,
+	0x72, 0x90, 0x66, 0x42, 0x6c,
+	0x9d, 0xa2, 0xd1, 0xed, 0x77,
+	0x3e, 0x30, 0xb6, 0xae, 0x92,
+	0x0d, 0x61, 0x2e, 0xf6, 0xa2,
+	0x1a, 0x49, 0xdb, 0xa1, 0x1d,
+	0x89, 0xa8, 0xde, 0xf2, 0x38,
+	0x56, 0xba, 0x6b, 0xab, 0xca,
+	0x53, 0x5a, 0x53, 0xf6, 0x6d,
+	0x13, 0x81, 0xae, 0x1f, 0xa5,
+	0xfc, 0x4a, 0x3d, 0xd7, 0x45,
+	0x01, 0x89, 0xe4, 0xa4, 0x00,
+	0x98, 0xf6, 0xfb, 0x4d, 0x86,
+	0x64, 0x46, 0x5f, 0x59, 0xac,
+	0xf5, 0x79, 0x36, 0x2f, 0xea,
+	0xca, 0x46, 0xaf, 0x50, 0x46,
+	0x66, 0x89, 0x21, 0x42, 0x91,
+	0xb1, 0x76, 0xd2, 0x0d, 0x72,
+	0x8d, 0xe3, 0x58, 0xe3, 0x9c,
+	0x17, 0xd1, 0x28, 0x58, 0x63,
+	0x27, 0x6e, 0x44, 0x6b, 0x82,
+	0xa4, 0xba, 0x98, 0x73, 0xfa,
+	0xbb, 0xff, 0x9c, 0x1a, 0x76,
+	0xf2, 0x1f, 0x29, 0x99, 0x62,
+	0xc8, 0x7c, 0x5b, 0xfb, 0xf9,
+	0x1a, 0x46, 0xfd, 0x59, 0xf6,
+	0xc5, 0xdb, 0x3c, 0xe9, 0x71,
+	0x96, 0xd0, 0x71, 0x1c, 0xd8,
+	0x0d, 0x2c, 0x99, 0xd0, 0x5a,
+	0x12, 0x51, 0xd0, 0x00, 0x75,
+	0x87, 0xa8, 0x4f, 0xba, 0x66,
+	0xc0, 0x92, 0xd5, 0xd0, 0xf7,
+	0xb4, 0x86, 0xe5, 0x3f, 0xaf,
+	0x55, 0x55, 0xf5, 0xb8, 0x4e,
+	0x66, 0x01, 0x2c, 0x7d, 0xc4,
+	0xb2, 0x38, 0x28, 0x0c, 0x56,
+	0x4b, 0xcf, 0x17, 0x9c, 0x3d,
+	0xe4, 0x07, 0xab, 0x3c, 0x4a,
+	0x12, 0xfe, 0x7b, 0x90, 0x11,
+	0x06, 0x99, 0xea, 0xc7, 0x7d,
+	0xd1, 0xf3, 0xf2, 0x8c, 0xe7,
+	0x25, 0x14, 0x9c, 0xce, 0x14,
+	0xfe, 0xfc, 0x19, 0x6d, 0x21,
+	0x37, 0x28, 0xb2, 0x94, 0x33,
+	0x0f, 0xb3, 0xe4, 0x0a, 0x45,
+	0xcb, 0x9f, 0xa8, 0x11, 0xe0,
+	0x9f, 0x29, 0xb4, 0x18, 0x17,
+	0xef, 0x57, 0x5c, 0x5f, 0x86,
+	0xb3, 0x8d, 0x7f, 0x39, 0x82,
+	0x89, 0x7d, 0x71, 0xa9, 0xdc,
+	0x67, 0xd0, 0x22, 0x46, 0x1f,
+	0x11, 0xab, 0xf1, 0xe9, 0x9e,
+	0x30, 0x6f, 0xb6, 0xee, 0xf9,
+	0x75, 0x2e, 0xa5, 0x94, 0x59,
+	0x7f, 0x69, 0x80, 0x4d, 0xe8,
+	0x85, 0x9e, 0x59, 0x04, 0x40,
+	0x58, 0x1a, 0xd7, 0xfb, 0x8e,
+	0x3c, 0x9a, 0x0d, 0x45, 0xb9,
+	0x46, 0x5f, 0x0e, 0xce, 0xe2,
+	0xc6, 0x38, 0xc2, 0x8d, 0x24,
+	0xb5, 0x56, 0x4b, 0x3d, 0xcd,
+	0x0b, 0x8f, 0x59, 0x84, 0x16,
+	0x8c, 0x9f, 0xcc, 0x24, 0x3c,
+	0x2c, 0x6b, 0xce, 0x2d, 0xf6,
+	0xaa, 0xda, 0x0e, 0x64, 0xc3,
+	0x37, 0xfd, 0xa9, 0x08, 0xb7,
+	0x8e, 0xe4, 0xd3, 0x8a, 0x9b,
+	0xf9, 0x31, 0x7e, 0xce, 0x2d,
+	0x4d, 0xf8, 0xef, 0x83, 0x9e,
+	0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+#endif
@@ -0,0 +1,207 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include "mock.h"
+
+
+unsigned long mock_micros;
+uint8_t mock_pin[MOCK_PINS];
+volatile uint8_t mock_port;
+int mock_analog[MOCK_PINS];
+mock_pin_hook *mock_on_pin_write;
+mock_spi_hook *mock_on_spi_transfer;
+uint8_t mock_spi_mode;
+uint8_t mock_spi_clock;
+bool mock_spi_enabled;
+bool mock_serial_echo;
+const char *mock_serial_input;
+mock_serial_available_hook *mock_on_serial_available;
+mock_serial_read_hook *mock_on_serial_read;
+mock_serial_write_hook *mock_on_serial_write;
+
+HardwareSerial Serial;
+SPIClass SPI;
+static SPI_mock_isr *spi_isr;
+static bool spi_complete;  // SPIF
+
+
+void mock_reset() {
+	mock_micros = 0;
+	memset(mock_pin, 0, sizeof(mock_pin));
+	mock_port = 0;
+	memset(mock_analog, 0, sizeof(mock_analog));
+	mock_on_pin_write = 0;
+	mock_on_spi_transfer = 0;
+	mock_spi_mode = SPI_MODE0;
+	mock_spi_clock = SPI_CLOCK_DIV4;
+	mock_spi_enabled = false;
+	spi_isr = 0;
+	spi_complete = false;
+	mock_serial_echo = false;
+	mock_serial_input = 0;
+	mock_on_serial_available = 0;
+	mock_on_serial_read = 0;
+	mock_on_serial_write = 0;
+}
+
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+	if (pin < MOCK_PINS) {
+		mock_pin[pin] = value;
+	}
+	if (0 != mock_on_pin_write) {
+		mock_on_pin_write(pin, value);
+	}
+}
+
+
+int digitalRead(uint8_t pin) {
+	return pin < MOCK_PINS ? mock_pin[pin] : LOW;
+}
+
+
+int analogRead(uint8_t pin) {
+	return pin < MOCK_PINS ? mock_analog[pin] : 0;
+}
+
+
+void analogWrite(uint8_t, int) {
+}
+
+
+uint8_t SPIClass::transfer(uint8_t value) {
+	mock_micros += MOCK_SPI_BYTE_US;
+	if (0 != mock_on_spi_transfer) {
+		return mock_on_spi_transfer(value);
+	}
+	return 0xff;
+}
+
+
+void SPI_mock_write(uint8_t value) {
+	SPI.transfer(value);
+	spi_complete = true;
+}
+
+
+void SPI_mock_interrupt(SPI_mock_isr *isr) {
+	spi_isr = isr;
+}
+
+
+bool mock_spi_tick() {
+	if (!spi_complete || 0 == spi_isr) {
+		return false;
+	}
+	spi_complete = false;  // cleared on entry to the vector, as on the AVR
+	spi_isr();
+	return true;
+}
+
+
+void SPIClass::begin() {
+	mock_spi_enabled = true;
+}
+
+
+void SPIClass::end() {
+	mock_spi_enabled = false;
+}
+
+
+void SPIClass::setBitOrder(uint8_t) {
+}
+
+
+void SPIClass::setDataMode(uint8_t mode) {
+	mock_spi_mode = mode;
+}
+
+
+void SPIClass::setClockDivider(uint8_t divider) {
+	mock_spi_clock = divider;
+}
+
+
+int HardwareSerial::available() {
+	if (0 != mock_on_serial_available) {
+		return mock_on_serial_available();
+	}
+	return (0 != mock_serial_input && 0 != *mock_serial_input) ? strlen(mock_serial_input) : 0;
+}
+
+
+int HardwareSerial::read() {
+	if (0 != mock_on_serial_read) {
+		return mock_on_serial_read();
+	}
+	if (0 == this->available()) {
+		return -1;
+	}
+	return (uint8_t)*mock_serial_input++;
+}
+
+
+size_t HardwareSerial::write(uint8_t c) {
+	if (0 != mock_on_serial_write) {
+		mock_on_serial_write(c);
+	}
+	if (mock_serial_echo) {
+		putchar(c);
+	}
+	return 1;
+}
+
+
+void HardwareSerial::print(const char *s) {
+	while (0 != *s) {
+		this->write(*s++);
+	}
+}
+
+
+void HardwareSerial::print(char c) {
+	this->write(c);
+}
+
+
+void HardwareSerial::print(long n, int base) {
+	if (n < 0) {
+		this->write('-');
+		this->print((unsigned long)-n, base);
+	} else {
+		this->print((unsigned long)n, base);
+	}
+}
+
+
+void HardwareSerial::print(unsigned long n, int base) {
+	char digits[33];
+	int i = sizeof(digits) - 1;
+	digits[i] = 0;
+	do {
+		int d = n % base;
+		digits[--i] = d < 10 ? '0' + d : 'A' + d - 10;
+		n /= base;
+	} while (0 != n);
+	this->print(&digits[i]);
+}
@@ -0,0 +1,67 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// Hooks for the tests to play the part of the hardware around the code under test
+
+#if !defined(MOCK_H)
+#define MOCK_H 1
+
+#include <stdint.h>
+
+// simulated time in microseconds
+// each SPI byte adds MOCK_SPI_BYTE_US (8 bits at SPI_CLOCK_DIV2 on a 16MHz AVR)
+extern unsigned long mock_micros;
+#define MOCK_SPI_BYTE_US 1
+
+// pin levels: digitalWrite() sets them, digitalRead() returns them
+#define MOCK_PINS 64
+extern uint8_t mock_pin[MOCK_PINS];
+
+// input register of the only port (BUSY is polled through portInputRegister())
+extern volatile uint8_t mock_port;
+
+// analogRead() returns mock_analog[pin]
+extern int mock_analog[MOCK_PINS];
+
+// called after every digitalWrite() (e.g. to follow a chip select)
+typedef void mock_pin_hook(uint8_t pin, uint8_t value);
+extern mock_pin_hook *mock_on_pin_write;
+
+// the device on the SPI bus: gets each byte sent and returns the byte received
+typedef uint8_t mock_spi_hook(uint8_t value);
+extern mock_spi_hook *mock_on_spi_transfer;
+
+// SPI settings last set by the code under test
+extern uint8_t mock_spi_mode;
+extern uint8_t mock_spi_clock;
+extern bool mock_spi_enabled;
+
+// Serial: print to stdout if set, read() takes characters from mock_serial_input
+extern bool mock_serial_echo;
+extern const char *mock_serial_input;
+
+// or, when set, the other end of the line: available() and read() ask these
+// instead of mock_serial_input and each byte written is passed on
+typedef int mock_serial_available_hook();
+typedef int mock_serial_read_hook();
+typedef void mock_serial_write_hook(uint8_t value);
+extern mock_serial_available_hook *mock_on_serial_available;
+extern mock_serial_read_hook *mock_on_serial_read;
+extern mock_serial_write_hook *mock_on_serial_write;
+
+// back to power on state (time, pins, hooks, SPI)
+void mock_reset();
+
+#endif
@@ -0,0 +1,194 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <stdio.h>
+
+#include <Arduino.h>
+
+#include "mx25.h"
+
+
+uint8_t mx25_memory[MX25_SIZE];
+unsigned long mx25_commands;
+unsigned long mx25_erases[FLASH_SECTOR_COUNT];
+
+static FILE *mx25_file;
+static uint8_t mx25_cs_pin;
+static bool mx25_selected;
+static bool mx25_write_enabled;
+static long mx25_cut;
+
+// the command in progress: its first byte and the bytes seen so far
+static uint8_t mx25_command;
+static uint32_t mx25_count;
+static uint32_t mx25_address;
+
+// page program data, applied when chip select goes high
+static uint8_t mx25_page[MX25_PAGE_SIZE];
+static bool mx25_page_loaded[MX25_PAGE_SIZE];
+
+
+static void mx25_store(uint32_t address, uint32_t length) {
+	fseek(mx25_file, address, SEEK_SET);
+	fwrite(&mx25_memory[address], 1, length, mx25_file);
+	fflush(mx25_file);
+}
+
+
+// true if a program or erase may go ahead
+static bool mx25_powered(void) {
+	++mx25_commands;
+	return mx25_cut < 0 || mx25_commands <= (unsigned long)mx25_cut;
+}
+
+
+static void mx25_finish(void) {
+	if (mx25_count < 4) {
+		return;
+	}
+	uint32_t address = mx25_address & (MX25_SIZE - 1);
+	if (0x02 == mx25_command && mx25_write_enabled) {        // PP
+		mx25_write_enabled = false;
+		if (mx25_powered()) {
+			uint32_t page = address & ~(uint32_t)(MX25_PAGE_SIZE - 1);
+			for (uint16_t i = 0; i < MX25_PAGE_SIZE; ++i) {
+				if (mx25_page_loaded[i]) {
+					mx25_memory[page + i] &= mx25_page[i];
+				}
+			}
+			mx25_store(page, MX25_PAGE_SIZE);
+		}
+	} else if (0x20 == mx25_command && mx25_write_enabled) { // SE
+		mx25_write_enabled = false;
+		if (mx25_powered()) {
+			uint32_t sector = address & ~(uint32_t)(FLASH_SECTOR_SIZE - 1);
+			memset(&mx25_memory[sector], 0xff, FLASH_SECTOR_SIZE);
+			++mx25_erases[sector >> FLASH_SECTOR_SHIFT];
+			mx25_store(sector, FLASH_SECTOR_SIZE);
+		}
+	}
+}
+
+
+static void mx25_pin_write(uint8_t pin, uint8_t value) {
+	if (pin != mx25_cs_pin) {
+		return;
+	}
+	if (LOW == value && !mx25_selected) {
+		mx25_count = 0;
+		mx25_address = 0;
+		memset(mx25_page_loaded, 0, sizeof(mx25_page_loaded));
+	} else if (HIGH == value && mx25_selected) {
+		mx25_finish();
+	}
+	mx25_selected = LOW == value;
+}
+
+
+static uint8_t mx25_spi_transfer(uint8_t value) {
+	if (!mx25_selected) {
+		return 0xff;
+	}
+	uint32_t n = mx25_count++;
+	if (0 == n) {
+		mx25_command = value;
+		if (0x06 == value) {         // WREN
+			mx25_write_enabled = true;
+		} else if (0x04 == value) {  // WRDI
+			mx25_write_enabled = false;
+		}
+		return 0xff;
+	}
+
+	switch (mx25_command) {
+	case 0x9f:  // RDID
+		return n <= 3 ? "\xc2\x20\x14"[n - 1] : 0xff;
+
+	case 0x05:  // RDSR (repeated while selected)
+		return mx25_write_enabled ? 0x02 : 0x00;
+
+	case 0x03:  // READ
+	case 0x0b:  // FAST_READ (one dummy byte)
+	case 0x02:  // PP
+	case 0x20:  // SE
+		if (n <= 3) {
+			mx25_address = (mx25_address << 8) | value;
+			return 0xff;
+		}
+		break;
+
+	default:
+		return 0xff;
+	}
+
+	uint32_t address = mx25_address & (MX25_SIZE - 1);
+	switch (mx25_command) {
+	case 0x03:
+		return mx25_memory[(address + n - 4) & (MX25_SIZE - 1)];
+	case 0x0b:
+		return n < 5 ? 0xff : mx25_memory[(address + n - 5) & (MX25_SIZE - 1)];
+	case 0x02: {
+		uint8_t i = (address + n - 4) & (MX25_PAGE_SIZE - 1);
+		mx25_page[i] = value;
+		mx25_page_loaded[i] = true;
+		break;
+	}
+	}
+	return 0xff;
+}
+
+
+bool mx25_attach(uint8_t cs_pin, const char *path) {
+	mx25_detach();
+	memset(mx25_memory, 0xff, sizeof(mx25_memory));
+	mx25_file = fopen(path, "r+b");
+	if (0 == mx25_file) {
+		mx25_file = fopen(path, "w+b");
+		if (0 == mx25_file) {
+			return false;
+		}
+	} else {
+		// a short file is padded with erased sectors
+		fread(mx25_memory, 1, sizeof(mx25_memory), mx25_file);
+	}
+	mx25_store(0, sizeof(mx25_memory));
+
+	mx25_cs_pin = cs_pin;
+	mx25_selected = false;
+	mx25_write_enabled = false;
+	mx25_cut = -1;
+	mx25_commands = 0;
+	memset(mx25_erases, 0, sizeof(mx25_erases));
+	mock_on_pin_write = mx25_pin_write;
+	mock_on_spi_transfer = mx25_spi_transfer;
+	return true;
+}
+
+
+void mx25_detach() {
+	if (0 != mx25_file) {
+		fclose(mx25_file);
+		mx25_file = 0;
+	}
+	if (mx25_pin_write == mock_on_pin_write) {
+		mock_on_pin_write = 0;
+		mock_on_spi_transfer = 0;
+	}
+}
+
+
+void mx25_power_cut(long count) {
+	mx25_cut = count < 0 ? -1 : (long)mx25_commands + count;
+}
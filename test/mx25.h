@@ -0,0 +1,50 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// MX25V8005 FLASH on the mock SPI bus with its contents kept in a file
+// (the same image format as flash_store.py, so either can open the other's files)
+//
+// implements RDID, RDSR, WREN, WRDI, READ, FAST_READ, PP and SE with the
+// NOR rules: programming only clears bits, a page program wraps inside its
+// 256 byte page and needs WREN first; program and erase finish at once
+// (WIP is never set) and are written through to the file
+
+#if !defined(MX25_H)
+#define MX25_H 1
+
+#include <Arduino.h>
+#include <FLASH.h>
+
+#define MX25_SIZE ((uint32_t)FLASH_SECTOR_COUNT * FLASH_SECTOR_SIZE)
+#define MX25_PAGE_SIZE 256
+
+// load path (created erased if missing) and answer while cs_pin is low
+bool mx25_attach(uint8_t cs_pin, const char *path);
+void mx25_detach();
+
+// the chip contents (changes made here are not written to the file)
+extern uint8_t mx25_memory[MX25_SIZE];
+
+// power cut: only the next count program and erase commands are carried out
+// (each is either done completely or not at all), count < 0 for no cut
+void mx25_power_cut(long count);
+
+// program and erase commands received since mx25_attach()
+extern unsigned long mx25_commands;
+
+// erase count of each sector since mx25_attach()
+extern unsigned long mx25_erases[FLASH_SECTOR_COUNT];
+
+#endif
@@ -0,0 +1,31 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+#include <stdio.h>
+
+#include "test.h"
+
+
+int test_failures = 0;
+
+
+int test_report(const char *name) {
+	if (0 == test_failures) {
+		printf("PASS %s\n", name);
+		return 0;
+	}
+	printf("FAIL %s: %d failed checks\n", name, test_failures);
+	return 1;
+}
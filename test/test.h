@@ -0,0 +1,46 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// Minimal checks for the host tests: count failures, report, exit status
+
+#if !defined(TEST_H)
+#define TEST_H 1
+
+#include <stdio.h>
+
+extern int test_failures;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			++test_failures; \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		long long e_ = (long long)(expected); \
+		long long a_ = (long long)(actual); \
+		if (e_ != a_) { \
+			++test_failures; \
+			printf("%s:%d: %s: expected %lld got %lld\n", __FILE__, __LINE__, #actual, e_, a_); \
+		} \
+	} while (0)
+
+// print the result line, use as the exit status of main()
+int test_report(const char *name);
+
+#endif
@@ -0,0 +1,175 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// a whole image update (begin, image, end) through the host build of
+// EPD.cpp, checked command by command against the COG sequence: power
+// up, every line of every pass of the four stages, the dummy frame and
+// line, and power down
+//
+// with a directory argument the streams are also written there as
+// cog_<size>.txt for cog_decode.py (see the captures target in Makefile)
+
+#include <string>
+
+#include <Arduino.h>
+#include <EPD.h>
+
+#include "cog.h"
+#include "test.h"
+
+static const uint8_t Pin_EPD_CS = 8;
+
+
+struct panel {
+	EPD_size size;
+	const char *name;
+	uint8_t channel_select[8];
+	uint8_t gate_source;
+};
+
+static const panel panels[] = {
+	{EPD_1_44, "1.44", {0x00, 0x00, 0x00, 0x00, 0x00, 0x0f, 0xff, 0x00}, 0x03},
+	{EPD_2_0, "2.0", {0x00, 0x00, 0x00, 0x00, 0x01, 0xff, 0xe0, 0x00}, 0x03},
+	{EPD_2_7, "2.7", {0x00, 0x00, 0x00, 0x7f, 0xff, 0xfe, 0x00, 0x00}, 0x00},
+};
+
+
+// the expected commands, built up in order
+class expected_commands {
+public:
+	std::vector<cog_command> commands;
+
+	void add(uint8_t index, const cog_transaction &data) {
+		cog_command c;
+		c.index = index;
+		c.data = data;
+		this->commands.push_back(c);
+	}
+	void add(uint8_t index, uint8_t data) {
+		this->add(index, cog_transaction(1, data));
+	}
+	void add(uint8_t index, uint8_t data0, uint8_t data1) {
+		cog_transaction t;
+		t.push_back(data0);
+		t.push_back(data1);
+		this->add(index, t);
+	}
+
+	// charge pump levels, line data, output enable
+	void line(const panel &p, uint16_t line_no, const uint8_t *data, uint8_t fixed_value, EPD_stage stage) {
+		cog_transaction t = cog_line(p.size, line_no, data, fixed_value, stage);
+		this->add(0x04, p.gate_source);
+		this->add(0x0a, cog_transaction(t.begin() + 1, t.end()));
+		this->add(0x02, 0x2f);
+	}
+
+	void frame(const panel &p, const uint8_t *image, uint8_t fixed_value, EPD_stage stage) {
+		uint16_t bytes_per_line = cog_bytes_per_line(p.size);
+		for (uint16_t n = 0; n < cog_lines(p.size); ++n) {
+			this->line(p, n, 0 != image ? &image[n * bytes_per_line] : 0, fixed_value, stage);
+		}
+	}
+};
+
+
+static void check_update(const panel &p, const char *capture_dir) {
+	EPD_Class EPD(p.size, 2, 3, 4, 5, 6, 7, Pin_EPD_CS);
+	uint16_t bytes_per_line = cog_bytes_per_line(p.size);
+	std::vector<uint8_t> image(cog_lines(p.size) * bytes_per_line);
+	for (size_t i = 0; i < image.size(); ++i) {
+		image[i] = rand();
+	}
+
+	cog_attach(Pin_EPD_CS);
+	EPD.setFactor(25);
+	EPD.begin();
+	EPD.image(&image[0]);
+	EPD.end();
+
+	uint16_t passes = (EPD_1_44 == p.size) ? 29 : (EPD_2_0 == p.size) ? 24 : 13;
+	passes = (passes * EPD.temperature_to_factor_10x(25) + 9) / 10;
+
+	expected_commands e;
+
+	// power up
+	e.add(0x01, cog_transaction(p.channel_select, p.channel_select + sizeof(p.channel_select)));
+	e.add(0x06, 0xff);
+	e.add(0x07, 0x9d);
+	e.add(0x08, 0x00);
+	e.add(0x09, 0xd0, 0x00);
+	e.add(0x04, p.gate_source);
+	e.add(0x03, 0x01);
+	e.add(0x03, 0x00);
+	e.add(0x05, 0x01);
+	e.add(0x05, 0x03);
+	e.add(0x05, 0x0f);
+	e.add(0x02, 0x24);
+
+	// image onto a white panel
+	for (uint16_t n = 0; n < passes; ++n) {
+		e.frame(p, 0, 0xaa, EPD_compensate);
+	}
+	for (uint16_t n = 0; n < passes; ++n) {
+		e.frame(p, 0, 0xaa, EPD_white);
+	}
+	for (uint16_t n = 0; n < passes; ++n) {
+		e.frame(p, &image[0], 0, EPD_inverse);
+	}
+	for (uint16_t n = 0; n < passes; ++n) {
+		e.frame(p, &image[0], 0, EPD_normal);
+	}
+
+	// dummy frame and dummy line, then power down
+	e.frame(p, 0, 0x55, EPD_normal);
+	e.line(p, 0x7fff, 0, (EPD_1_44 == p.size) ? 0xaa : 0x55, EPD_normal);
+	e.add(0x03, 0x01);
+	e.add(0x02, 0x05);
+	e.add(0x05, 0x0e);
+	e.add(0x05, 0x02);
+	e.add(0x04, 0x0c);
+	e.add(0x05, 0x00);
+	e.add(0x07, 0x0d);
+	e.add(0x04, 0x50);
+	e.add(0x04, 0xa0);
+	e.add(0x04, 0x00);
+
+	std::vector<cog_command> sent = cog_commands();
+	CHECK_EQUAL(e.commands.size(), sent.size());
+	for (size_t i = 0; i < e.commands.size() && i < sent.size(); ++i) {
+		if (e.commands[i].index != sent[i].index || e.commands[i].data != sent[i].data) {
+			printf("%s: command %u: expected index 0x%02x, sent 0x%02x (%u data bytes)\n", p.name,
+			       (unsigned)i, e.commands[i].index, sent[i].index, (unsigned)sent[i].data.size());
+			CHECK(false);
+			break;
+		}
+	}
+
+	if (0 != capture_dir) {
+		std::string path = std::string(capture_dir) + "/cog_" + p.name + ".txt";
+		CHECK(cog_write_capture(path.c_str()));
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	mock_reset();
+	srand(1);
+
+	for (size_t i = 0; i < sizeof(panels) / sizeof(panels[0]); ++i) {
+		check_update(panels[i], argc > 1 ? argv[1] : 0);
+	}
+
+	return test_report("cog_stream");
+}
@@ -0,0 +1,200 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// the asynchronous update against the blocking one: the same COG byte
+// stream, with the SPI interrupt simulated and the COG holding BUSY high
+// now and then, which the interrupt must not wait for; a stage read from
+// another SPI device must not select it in the middle of a line
+// (built again without EPD_SPI_INTERRUPT_MOCK for the targets that send
+// each line from poll(), where BUSY is left low)
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <EPD.h>
+
+#include "cog.h"
+#include "test.h"
+
+static const uint8_t Pin_BUSY = 7;
+static const uint8_t Pin_EPD_CS = 8;
+static const uint8_t Pin_FLASH_CS = 9;
+
+// BUSY goes high after every busy_every bytes and stays high for busy_ticks
+static const uint16_t busy_every = 7;
+static const uint16_t busy_ticks = 3;
+
+static mock_spi_hook *cog_hook;
+static uint16_t bytes_sent;
+static uint16_t busy_left;
+static uint32_t busy_count;
+
+
+static uint8_t busy_spi_transfer(uint8_t value) {
+#if defined(EPD_SPI_INTERRUPT_MOCK)
+	if (0 == ++bytes_sent % busy_every) {
+		mock_port |= digitalPinToBitMask(Pin_BUSY);
+		busy_left = busy_ticks;
+		++busy_count;
+	}
+#endif
+	return cog_hook(value);
+}
+
+
+// a reader on another device of the SPI bus (as FLASH.read)
+static const uint8_t *reader_image;
+static mock_pin_hook *cog_pin_hook;
+static uint32_t select_conflicts;
+
+
+static void flash_reader(void *buffer, uint32_t address, uint16_t length) {
+	digitalWrite(Pin_FLASH_CS, LOW);
+	memcpy(buffer, reader_image + address, length);
+	digitalWrite(Pin_FLASH_CS, HIGH);
+}
+
+
+static void shared_bus_pin_write(uint8_t pin, uint8_t value) {
+	if (LOW == value && LOW == mock_pin[Pin_EPD_CS] && LOW == mock_pin[Pin_FLASH_CS]) {
+		++select_conflicts;
+	}
+	cog_pin_hook(pin, value);
+}
+
+
+// one step of the main loop: the COG works on BUSY and pending interrupts run
+static void tick() {
+	if (0 != busy_left && 0 == --busy_left) {
+		mock_port &= ~digitalPinToBitMask(Pin_BUSY);
+	}
+	mock_spi_tick();
+}
+
+
+static void run_async(EPD_Class &EPD) {
+	cog_hook = mock_on_spi_transfer;
+	mock_on_spi_transfer = busy_spi_transfer;
+	bytes_sent = 0;
+	busy_count = 0;
+	uint32_t polls = 0;
+	while (EPD.poll()) {
+		// a few interrupts between polls
+		for (int i = 0; i < 4; ++i) {
+			tick();
+		}
+		CHECK(++polls < 10000000);
+		if (polls >= 10000000) {
+			break;
+		}
+	}
+	mock_on_spi_transfer = cog_hook;
+	mock_port &= ~digitalPinToBitMask(Pin_BUSY);
+	busy_left = 0;
+#if defined(EPD_SPI_INTERRUPT_MOCK)
+	CHECK(0 != busy_count);
+#endif
+}
+
+
+static void check_async(EPD_size size) {
+	EPD_Class EPD(size, 2, 3, 4, 5, 6, Pin_BUSY, Pin_EPD_CS);
+	uint16_t lines = cog_lines(size);
+	uint16_t bytes_per_line = cog_bytes_per_line(size);
+	std::vector<uint8_t> image(lines * bytes_per_line);
+	for (size_t i = 0; i < image.size(); ++i) {
+		image[i] = rand();
+	}
+
+	cog_attach(Pin_EPD_CS);
+	EPD.setFactor(25);
+
+	// clear
+	cog_clear();
+	EPD.frame_fixed_repeat(0xff, EPD_compensate);
+	EPD.frame_fixed_repeat(0xff, EPD_white);
+	EPD.frame_fixed_repeat(0xaa, EPD_inverse);
+	EPD.frame_fixed_repeat(0xaa, EPD_normal);
+	std::vector<cog_transaction> expected = cog_log;
+
+	cog_clear();
+	EPD.start_clear_async();
+	run_async(EPD);
+	CHECK(expected == cog_log);
+
+	// image (SRAM), whole panel and a band
+	cog_clear();
+	EPD.frame_sram_repeat(&image[0], EPD_inverse);
+	EPD.frame_sram_repeat(&image[0], EPD_normal);
+	expected = cog_log;
+
+	cog_clear();
+	EPD.start_image_sram_async(&image[0]);
+	run_async(EPD);
+	CHECK(expected == cog_log);
+
+	cog_clear();
+	EPD.frame_sram_repeat(&image[0], EPD_inverse, 8, 16);
+	EPD.frame_sram_repeat(&image[0], EPD_normal, 8, 16);
+	expected = cog_log;
+
+	bool completed = false;
+	cog_clear();
+	EPD.start_image_sram_async(&image[0], 8, 16);
+	run_async(EPD);
+	completed = !EPD.busy();
+	CHECK(completed);
+	CHECK(expected == cog_log);
+
+	// image from a reader, which must never be called in the middle of a line
+	reader_image = &image[0];
+	cog_pin_hook = mock_on_pin_write;
+	mock_on_pin_write = shared_bus_pin_write;
+	digitalWrite(Pin_EPD_CS, HIGH);
+	digitalWrite(Pin_FLASH_CS, HIGH);
+	select_conflicts = 0;
+
+	cog_clear();
+	EPD.frame_cb_repeat(0, flash_reader, EPD_inverse);
+	EPD.frame_cb_repeat(0, flash_reader, EPD_normal);
+	expected = cog_log;
+	CHECK_EQUAL(0, select_conflicts);
+
+	const EPD_async_stage stages[] = {
+		{EPD_inverse, 0, 0, false, flash_reader, 0},
+		{EPD_normal, 0, 0, false, flash_reader, 0}
+	};
+	cog_clear();
+	EPD.start_async(stages, 2);
+	run_async(EPD);
+	CHECK(expected == cog_log);
+	CHECK_EQUAL(0, select_conflicts);
+	mock_on_pin_write = cog_pin_hook;
+}
+
+
+int main() {
+	mock_reset();
+	srand(1);
+
+	check_async(EPD_1_44);
+	check_async(EPD_2_0);
+	check_async(EPD_2_7);
+
+#if defined(EPD_SPI_INTERRUPT_MOCK)
+	return test_report("epd_async");
+#else
+	return test_report("epd_async_poll");
+#endif
+}
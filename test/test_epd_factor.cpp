@@ -0,0 +1,117 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// the temperature compensation factor against the datasheet bands: the
+// band's factor inside each band, never less than it at a band edge, and
+// falling steadily as the temperature rises
+
+#include <Arduino.h>
+#include <EPD.h>
+
+#include "test.h"
+
+
+// the COG document's step function: upper edge of each band and its factor
+struct band {
+	int upper;
+	int factor_10x;
+};
+
+static const band bands[] = {
+	{-10, 170},
+	{-5, 120},
+	{5, 80},
+	{10, 40},
+	{15, 30},
+	{20, 20},
+	{40, 10},
+	{127, 7}
+};
+
+static const size_t band_count = sizeof(bands) / sizeof(bands[0]);
+
+// degrees above the band below that may still be ramping down to a band's factor
+static const int ramp = 2;
+
+
+static size_t band_of(int temperature) {
+	size_t b = 0;
+	while (b < band_count - 1 && temperature > bands[b].upper) {
+		++b;
+	}
+	return b;
+}
+
+
+static void check_table() {
+	EPD_Class EPD(EPD_2_7, 2, 3, 4, 5, 6, 7, 8);
+
+	int previous = 1000;
+	for (int t = -40; t <= 85; ++t) {
+		int factor = EPD.temperature_to_factor_10x(t);
+		size_t b = band_of(t);
+		CHECK(factor >= bands[b].factor_10x);
+		CHECK(factor <= previous);
+		if (0 == b || t > bands[b - 1].upper + ramp) {
+			CHECK_EQUAL(bands[b].factor_10x, factor);
+		} else {
+			CHECK(factor <= bands[b - 1].factor_10x);
+		}
+		previous = factor;
+	}
+
+	// room temperature is the 1x stage time
+	CHECK_EQUAL(10, EPD.temperature_to_factor_10x(25));
+	CHECK_EQUAL(10, EPD.temperature_to_factor_10x(30));
+	CHECK_EQUAL(10, EPD.temperature_to_factor_10x(40));
+	CHECK_EQUAL(80, EPD.temperature_to_factor_10x(0));
+	CHECK_EQUAL(170, EPD.temperature_to_factor_10x(-20));
+	CHECK_EQUAL(7, EPD.temperature_to_factor_10x(50));
+}
+
+
+#if defined(EPD_FACTOR_INTERPOLATION)
+static PROGMEM const EPD_factor_point test_table[] = {
+	{0, 100},
+	{10, 0},
+	{20, 5}
+};
+
+
+// interpolation rounds to nearest and holds the end points outside the table
+static void check_interpolation() {
+	EPD_Class EPD(EPD_2_7, 2, 3, 4, 5, 6, 7, 8);
+	EPD.setFactorTable(test_table, sizeof(test_table) / sizeof(test_table[0]));
+
+	CHECK_EQUAL(100, EPD.temperature_to_factor_10x(-5));
+	CHECK_EQUAL(100, EPD.temperature_to_factor_10x(0));
+	CHECK_EQUAL(70, EPD.temperature_to_factor_10x(3));
+	CHECK_EQUAL(50, EPD.temperature_to_factor_10x(5));
+	CHECK_EQUAL(0, EPD.temperature_to_factor_10x(10));
+	CHECK_EQUAL(1, EPD.temperature_to_factor_10x(11));   // 0.5
+	CHECK_EQUAL(2, EPD.temperature_to_factor_10x(13));   // 1.5
+	CHECK_EQUAL(5, EPD.temperature_to_factor_10x(20));
+	CHECK_EQUAL(5, EPD.temperature_to_factor_10x(60));
+}
+#endif
+
+
+int main() {
+	check_table();
+#if defined(EPD_FACTOR_INTERPOLATION)
+	check_interpolation();
+#endif
+	return test_report("epd_factor");
+}
@@ -0,0 +1,613 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+// EPD_GFX on the host with the 2.7" panel: which segments display() sends
+// to the COG once it knows what each one holds, and display_transition()
+// driving each changed segment from the old scene's rows to the new one's;
+// shapes replayed from a display list against the same shapes drawn
+// directly and against the Adafruit_GFX algorithms on a whole panel canvas,
+// pixel for pixel in every segment and with shapes off the panel's edges;
+// the span fills against the same rectangles set with drawPixel(); text
+// from drawChar(), drawText() and a display list against Adafruit_GFX's
+// drawChar() for sizes 1 to 5, off the panel's edges and across segments
+
+#include <algorithm>
+#include <vector>
+
+#include <Arduino.h>
+#include <EPD.h>
+#include <EPD_GFX.h>
+
+#include "cog.h"
+#include "test.h"
+
+static const uint8_t Pin_EPD_CS = 8;
+static const uint16_t panel_width = 264;
+static const uint16_t panel_height = 176;
+static const uint16_t segment_height = 8;
+static const uint8_t segments = panel_height / segment_height;
+static const uint32_t all_segments = (1UL << segments) - 1;
+
+
+// a scene: a black box over some rows (0 is white)
+struct box {
+	int16_t top;
+	int16_t bottom;
+};
+
+static void draw_box(EPD_GFX &gfx, const void *state) {
+	const box *b = (const box *)state;
+	if (0 != b) {
+		gfx.fillRect(10, b->top, 100, b->bottom - b->top + 1, EPD_GFX::BLACK);
+	}
+}
+
+
+static uint32_t segment_bits(uint8_t first, uint8_t last) {
+	return ((1UL << (last + 1)) - 1) & ~((1UL << first) - 1);
+}
+
+
+// display() one segment of a scene, true if it went to the COG
+static bool display_segment(EPD_GFX &gfx, uint8_t s, const box *scene) {
+	gfx.set_current_segment(s);
+	draw_box(gfx, scene);
+	cog_clear();
+	gfx.display(false, false, false);
+	// (after EPD.end() the chip select is left low, so there may be an empty transaction)
+	for (size_t i = 0; i < cog_log.size(); ++i) {
+		if (!cog_log[i].empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// a bit for each segment sent
+static uint32_t display_all(EPD_GFX &gfx, const box *scene) {
+	uint32_t sent = 0;
+	for (uint8_t s = 0; s < segments; ++s) {
+		if (display_segment(gfx, s, scene)) {
+			sent |= 1UL << s;
+		}
+	}
+	return sent;
+}
+
+
+static void check_differential() {
+	EPD_Class EPD(EPD_2_7, 2, 3, 4, 5, 6, 7, Pin_EPD_CS);
+	EPD_GFX gfx(EPD, panel_width, panel_height, 25, segment_height);
+	cog_attach(Pin_EPD_CS);
+
+	// nothing is known about the panel, then each segment as it is sent
+	CHECK_EQUAL(all_segments, display_all(gfx, 0));
+	CHECK_EQUAL(0, display_all(gfx, 0));
+
+	// only the segments a change touches
+	const box box_a = {20, 35};
+	CHECK_EQUAL(segment_bits(2, 4), display_all(gfx, &box_a));
+	CHECK_EQUAL(0, display_all(gfx, &box_a));
+
+	// a whole panel image behind its back: each segment is known again once sent
+	static const uint8_t white[panel_width / 8 * panel_height] = {0};
+	gfx.drawBitmapFast(white, false);
+	CHECK(display_segment(gfx, 5, &box_a));
+	CHECK(!display_segment(gfx, 5, &box_a));
+	CHECK_EQUAL(all_segments & ~segment_bits(5, 5), display_all(gfx, &box_a));
+	CHECK_EQUAL(0, display_all(gfx, &box_a));
+
+	gfx.invalidate_segments();
+	CHECK_EQUAL(all_segments, display_all(gfx, &box_a));
+	CHECK_EQUAL(0, display_all(gfx, &box_a));
+
+	// clear() makes every segment white
+	gfx.clear();
+	CHECK_EQUAL(0, display_all(gfx, 0));
+	CHECK_EQUAL(segment_bits(2, 4), display_all(gfx, &box_a));
+
+	// as does display_interleaved() with its new scene
+	const box box_b = {100, 130};
+	gfx.display_interleaved(draw_box, &box_a, &box_b);
+	CHECK_EQUAL(0, display_all(gfx, &box_b));
+	CHECK_EQUAL(segment_bits(2, 4) | segment_bits(12, 16), display_all(gfx, &box_a));
+}
+
+
+// the rows of segment s of a scene
+static std::vector<uint8_t> segment_rows(EPD_GFX &gfx, uint8_t s, const box *scene) {
+	gfx.set_current_segment(s);
+	draw_box(gfx, scene);
+	const uint8_t *buffer = gfx.get_segment_buffer();
+	return std::vector<uint8_t>(buffer, buffer + gfx.get_segment_buffer_size_bytes());
+}
+
+
+static bool line_sent(uint16_t line_no, const uint8_t *data, EPD_stage stage) {
+	cog_transaction t = cog_line(EPD_2_7, line_no, data, 0, stage);
+	return cog_log.end() != std::find(cog_log.begin(), cog_log.end(), t);
+}
+
+
+// display_transition(old, new): the segments that change, old rows for the
+// compensate and white stages, new rows for inverse and normal
+static void check_swap(EPD_GFX &gfx, const box *old_scene, const box *new_scene) {
+	std::vector<std::vector<uint8_t> > old_rows;
+	std::vector<std::vector<uint8_t> > new_rows;
+	for (uint8_t s = 0; s < segments; ++s) {
+		old_rows.push_back(segment_rows(gfx, s, old_scene));
+		new_rows.push_back(segment_rows(gfx, s, new_scene));
+	}
+
+	cog_clear();
+	gfx.display_transition(draw_box, old_scene, new_scene);
+
+	const uint16_t bytes_per_line = panel_width / 8;
+	for (uint8_t s = 0; s < segments; ++s) {
+		bool changed = old_rows[s] != new_rows[s];
+		for (uint16_t row = 0; row < segment_height; ++row) {
+			uint16_t line_no = s * segment_height + row;
+			const uint8_t *old_line = &old_rows[s][row * bytes_per_line];
+			const uint8_t *new_line = &new_rows[s][row * bytes_per_line];
+			CHECK_EQUAL(changed, line_sent(line_no, old_line, EPD_compensate));
+			CHECK_EQUAL(changed, line_sent(line_no, old_line, EPD_white));
+			CHECK_EQUAL(changed, line_sent(line_no, new_line, EPD_inverse));
+			CHECK_EQUAL(changed, line_sent(line_no, new_line, EPD_normal));
+		}
+	}
+
+	// the panel holds the new scene
+	CHECK_EQUAL(0, display_all(gfx, new_scene));
+}
+
+
+static void check_transition() {
+	EPD_Class EPD(EPD_2_7, 2, 3, 4, 5, 6, 7, Pin_EPD_CS);
+	EPD_GFX gfx(EPD, panel_width, panel_height, 25, segment_height);
+	cog_attach(Pin_EPD_CS);
+
+	const box box_a = {20, 35};
+	const box box_b = {30, 60};
+	const box box_c = {0, panel_height - 1};
+	gfx.clear();
+	check_swap(gfx, 0, &box_a);
+	check_swap(gfx, &box_a, &box_b);
+	check_swap(gfx, &box_b, &box_c);
+	check_swap(gfx, &box_c, 0);
+
+	// no change: nothing sent
+	cog_clear();
+	gfx.display_transition(draw_box, &box_a, &box_a);
+	CHECK(cog_log.empty() || (1 == cog_log.size() && cog_log[0].empty()));
+}
+
+
+// the whole panel drawn by the Adafruit_GFX algorithms a pixel at a time,
+// clipped to the panel
+class canvas : public Adafruit_GFX {
+public:
+	uint8_t pixels[panel_height][panel_width / 8];
+
+	canvas() : Adafruit_GFX(panel_width, panel_height) {
+		memset(this->pixels, 0, sizeof(this->pixels));
+	}
+
+	void drawPixel(int16_t x, int16_t y, unsigned int colour) {
+		if (x < 0 || x >= (int16_t)panel_width || y < 0 || y >= (int16_t)panel_height) {
+			return;
+		}
+		uint8_t bit = 1 << (x & 0x07);
+		if (EPD_GFX::BLACK == colour) {
+			this->pixels[y][x / 8] |= bit;
+		} else {
+			this->pixels[y][x / 8] &= ~bit;
+		}
+	}
+};
+
+
+// the segment whose rows are in gfx's buffer is the same as on the canvas
+static bool segment_matches(EPD_GFX &gfx, uint8_t s, const canvas &reference) {
+	const uint16_t rows = gfx.get_segment_buffer_size_bytes() / (panel_width / 8);
+	return 0 == memcmp(gfx.get_segment_buffer(), reference.pixels[s * rows], gfx.get_segment_buffer_size_bytes());
+}
+
+
+static uint32_t seed = 1;
+
+static int16_t random_between(int16_t low, int16_t high) {
+	seed = seed * 1103515245 + 12345;
+	return low + (int16_t)((seed >> 8) % (uint32_t)(high - low + 1));
+}
+
+
+// a bitmap for the BITMAP shapes (up to 40x30 pixels)
+static uint8_t bitmap[30 * 5];
+
+
+// one shape of each display list type, with its corners and radius
+struct shape {
+	uint8_t type;
+	uint16_t colour;
+	int16_t x0, y0, x1, y1, x2, y2;
+};
+
+
+static shape random_shape(int16_t x_low, int16_t x_high, int16_t y_low, int16_t y_high) {
+	shape p;
+	p.type = random_between(EPD_GFX_display_list::FILL_RECT, EPD_GFX_display_list::FILL_TRIANGLE);
+	if (EPD_GFX_display_list::FILL_TRIANGLE == p.type && 0 == random_between(0, 2)) {
+		p.type = EPD_GFX_display_list::BITMAP;
+	}
+	p.colour = (0 == random_between(0, 3)) ? EPD_GFX::WHITE : EPD_GFX::BLACK;
+	p.x0 = random_between(x_low, x_high);
+	p.y0 = random_between(y_low, y_high);
+	p.x1 = random_between(x_low, x_high);
+	p.y1 = random_between(y_low, y_high);
+	p.x2 = random_between(x_low, x_high);
+	p.y2 = random_between(y_low, y_high);
+
+	switch (p.type) {
+	case EPD_GFX_display_list::FILL_RECT:
+	case EPD_GFX_display_list::DRAW_RECT:
+		// w, h (not 0: the span fills draw nothing where Adafruit_GFX's
+		// drawLine() based spans draw two pixels)
+		p.x1 = random_between(1, 80);
+		p.y1 = random_between(1, 80);
+		break;
+	case EPD_GFX_display_list::DRAW_CIRCLE:
+	case EPD_GFX_display_list::FILL_CIRCLE:
+		p.x1 = random_between(0, 50);   // r
+		break;
+	case EPD_GFX_display_list::BITMAP:
+		p.x1 = random_between(1, 40);   // w, h
+		p.y1 = random_between(1, 30);
+		break;
+	}
+	return p;
+}
+
+
+// a shape that only covers panel pixels, as EPD_GFX::drawPixel() needs
+static bool on_panel(const shape &p) {
+	int16_t left, right, top, bottom;
+	switch (p.type) {
+	case EPD_GFX_display_list::FILL_RECT:
+	case EPD_GFX_display_list::DRAW_RECT:
+		return true;  // span fills are clipped
+	case EPD_GFX_display_list::DRAW_CIRCLE:
+	case EPD_GFX_display_list::FILL_CIRCLE:
+		left = p.x0 - p.x1;
+		right = p.x0 + p.x1;
+		top = p.y0 - p.x1;
+		bottom = p.y0 + p.x1;
+		break;
+	case EPD_GFX_display_list::BITMAP:
+		left = p.x0;
+		right = p.x0 + p.x1 - 1;
+		top = p.y0;
+		bottom = p.y0 + p.y1 - 1;
+		break;
+	default:
+		left = min(p.x0, min(p.x1, p.x2));
+		right = max(p.x0, max(p.x1, p.x2));
+		top = min(p.y0, min(p.y1, p.y2));
+		bottom = max(p.y0, max(p.y1, p.y2));
+		break;
+	}
+	return left >= 0 && right < (int16_t)panel_width && top >= 0 && bottom < (int16_t)panel_height;
+}
+
+
+static void draw_shape(Adafruit_GFX &gfx, const shape &p) {
+	switch (p.type) {
+	case EPD_GFX_display_list::FILL_RECT:
+		gfx.fillRect(p.x0, p.y0, p.x1, p.y1, p.colour);
+		break;
+	case EPD_GFX_display_list::DRAW_RECT:
+		gfx.drawRect(p.x0, p.y0, p.x1, p.y1, p.colour);
+		break;
+	case EPD_GFX_display_list::LINE:
+		gfx.drawLine(p.x0, p.y0, p.x1, p.y1, p.colour);
+		break;
+	case EPD_GFX_display_list::DRAW_CIRCLE:
+		gfx.drawCircle(p.x0, p.y0, p.x1, p.colour);
+		break;
+	case EPD_GFX_display_list::FILL_CIRCLE:
+		gfx.fillCircle(p.x0, p.y0, p.x1, p.colour);
+		break;
+	case EPD_GFX_display_list::DRAW_TRIANGLE:
+		gfx.drawTriangle(p.x0, p.y0, p.x1, p.y1, p.x2, p.y2, p.colour);
+		break;
+	case EPD_GFX_display_list::FILL_TRIANGLE:
+		gfx.fillTriangle(p.x0, p.y0, p.x1, p.y1, p.x2, p.y2, p.colour);
+		break;
+	case EPD_GFX_display_list::BITMAP:
+		gfx.drawBitmap(p.x0, p.y0, bitmap, p.x1, p.y1, p.colour);
+		break;
+	}
+}
+
+
+static bool record_shape(EPD_GFX_display_list &list, const shape &p) {
+	switch (p.type) {
+	case EPD_GFX_display_list::FILL_RECT:
+		return list.fillRect(p.x0, p.y0, p.x1, p.y1, p.colour);
+	case EPD_GFX_display_list::DRAW_RECT:
+		return list.drawRect(p.x0, p.y0, p.x1, p.y1, p.colour);
+	case EPD_GFX_display_list::LINE:
+		return list.drawLine(p.x0, p.y0, p.x1, p.y1, p.colour);
+	case EPD_GFX_display_list::DRAW_CIRCLE:
+		return list.drawCircle(p.x0, p.y0, p.x1, p.colour);
+	case EPD_GFX_display_list::FILL_CIRCLE:
+		return list.fillCircle(p.x0, p.y0, p.x1, p.colour);
+	case EPD_GFX_display_list::DRAW_TRIANGLE:
+		return list.drawTriangle(p.x0, p.y0, p.x1, p.y1, p.x2, p.y2, p.colour);
+	case EPD_GFX_display_list::FILL_TRIANGLE:
+		return list.fillTriangle(p.x0, p.y0, p.x1, p.y1, p.x2, p.y2, p.colour);
+	case EPD_GFX_display_list::BITMAP:
+		return list.drawBitmap(p.x0, p.y0, bitmap, p.x1, p.y1, p.colour);
+	}
+	return false;
+}
+
+
+// a scene in every segment: replayed from the list, and drawn directly
+// (if all of it is on the panel), against the canvas
+static void check_scene(EPD_GFX &gfx, const std::vector<shape> &scene) {
+	static EPD_GFX_primitive storage[40];
+	EPD_GFX_display_list list(storage, sizeof(storage) / sizeof(storage[0]));
+	canvas reference;
+	bool direct = true;
+	for (size_t i = 0; i < scene.size(); ++i) {
+		CHECK(record_shape(list, scene[i]));
+		draw_shape(reference, scene[i]);
+		direct = direct && on_panel(scene[i]);
+	}
+
+	uint16_t list_different = 0;
+	uint16_t direct_different = 0;
+	for (uint8_t s = 0; s < gfx.get_segment_count(); ++s) {
+		gfx.set_current_segment(s);
+		gfx.draw_list(list);
+		list_different += !segment_matches(gfx, s, reference);
+
+		if (direct) {
+			gfx.set_current_segment(s);
+			for (size_t i = 0; i < scene.size(); ++i) {
+				draw_shape(gfx, scene[i]);
+			}
+			direct_different += !segment_matches(gfx, s, reference);
+		}
+	}
+	CHECK_EQUAL(0, list_different);
+	CHECK_EQUAL(0, direct_different);
+}
+
+
+static void check_display_list() {
+	for (size_t i = 0; i < sizeof(bitmap); ++i) {
+		bitmap[i] = random_between(0, 255);
+	}
+
+	// shapes on the edges of the panel and segments
+	static const shape edges[] = {
+		{EPD_GFX_display_list::LINE, EPD_GFX::BLACK, -30, -20, 300, 200, 0, 0},
+		{EPD_GFX_display_list::LINE, EPD_GFX::BLACK, 5, 180, 250, -7, 0, 0},
+		{EPD_GFX_display_list::LINE, EPD_GFX::BLACK, 0, 7, 263, 8, 0, 0},
+		{EPD_GFX_display_list::LINE, EPD_GFX::BLACK, 20, 0, 21, 175, 0, 0},
+		{EPD_GFX_display_list::LINE, EPD_GFX::BLACK, 40, 15, 40, 15, 0, 0},
+		{EPD_GFX_display_list::LINE, EPD_GFX::BLACK, -10, 16, 270, 16, 0, 0},
+		{EPD_GFX_display_list::LINE, EPD_GFX::BLACK, 50, -40, 60, -1, 0, 0},
+		{EPD_GFX_display_list::DRAW_CIRCLE, EPD_GFX::BLACK, 0, 0, 30, 0, 0, 0},
+		{EPD_GFX_display_list::DRAW_CIRCLE, EPD_GFX::BLACK, 250, 170, 40, 0, 0, 0},
+		{EPD_GFX_display_list::DRAW_CIRCLE, EPD_GFX::BLACK, 100, 8, 0, 0, 0, 0},
+		{EPD_GFX_display_list::FILL_CIRCLE, EPD_GFX::BLACK, 132, -10, 25, 0, 0, 0},
+		{EPD_GFX_display_list::DRAW_TRIANGLE, EPD_GFX::BLACK, -20, 100, 150, -30, 290, 190},
+		{EPD_GFX_display_list::FILL_TRIANGLE, EPD_GFX::WHITE, -20, 100, 150, -30, 290, 190},
+		{EPD_GFX_display_list::BITMAP, EPD_GFX::BLACK, -5, -3, 37, 30, 0, 0},
+		{EPD_GFX_display_list::BITMAP, EPD_GFX::BLACK, 240, 150, 33, 29, 0, 0},
+		{EPD_GFX_display_list::DRAW_RECT, EPD_GFX::BLACK, -1, -1, 266, 178, 0, 0},
+		{EPD_GFX_display_list::FILL_RECT, EPD_GFX::BLACK, 3, 7, 9, 2, 0, 0}
+	};
+	std::vector<shape> edge_scene(edges, edges + sizeof(edges) / sizeof(edges[0]));
+
+	static const uint16_t segment_heights[] = {1, 8, 11, 16, 176};
+	for (size_t h = 0; h < sizeof(segment_heights) / sizeof(segment_heights[0]); ++h) {
+		EPD_Class EPD(EPD_2_7, 2, 3, 4, 5, 6, 7, Pin_EPD_CS);
+		EPD_GFX gfx(EPD, panel_width, panel_height, 25, segment_heights[h]);
+
+		check_scene(gfx, edge_scene);
+
+		for (int n = 0; n < 60; ++n) {
+			std::vector<shape> scene;
+			for (int i = 0; i < 30; ++i) {
+				if (0 == n % 2) {
+					scene.push_back(random_shape(-60, panel_width + 60, -60, panel_height + 60));
+				} else {
+					// on the panel, to be drawn directly as well
+					shape p;
+					do {
+						p = random_shape(0, panel_width - 1, 0, panel_height - 1);
+					} while (!on_panel(p));
+					scene.push_back(p);
+				}
+			}
+			check_scene(gfx, scene);
+		}
+	}
+}
+
+
+// fillRect(), drawFastHLine() or drawFastVLine() in one segment against the
+// rectangle's pixels (those on the panel) set with drawPixel()
+enum span_call {
+	SPAN_FILL_RECT,
+	SPAN_HLINE,
+	SPAN_VLINE
+};
+
+static bool span_matches(EPD_GFX &gfx, uint8_t s, span_call call,
+                         int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour) {
+	const uint16_t size = gfx.get_segment_buffer_size_bytes();
+	const int16_t rows = size / (panel_width / 8);
+	const uint16_t background = (EPD_GFX::BLACK == colour) ? EPD_GFX::WHITE : EPD_GFX::BLACK;
+
+	gfx.set_current_segment(s);
+	gfx.fillScreen(background);
+	switch (call) {
+	case SPAN_FILL_RECT:
+		gfx.fillRect(x, y, w, h, colour);
+		break;
+	case SPAN_HLINE:
+		gfx.drawFastHLine(x, y, w, colour);
+		h = 1;
+		break;
+	case SPAN_VLINE:
+		gfx.drawFastVLine(x, y, h, colour);
+		w = 1;
+		break;
+	}
+	std::vector<uint8_t> spans(gfx.get_segment_buffer(), gfx.get_segment_buffer() + size);
+
+	gfx.set_current_segment(s);
+	gfx.fillScreen(background);
+	for (int16_t j = max(y, (int16_t)(s * rows)); j < min((int16_t)(y + h), (int16_t)((s + 1) * rows)); ++j) {
+		for (int16_t i = max(x, (int16_t)0); i < min((int16_t)(x + w), (int16_t)panel_width); ++i) {
+			gfx.drawPixel(i, j, colour);
+		}
+	}
+	return 0 == memcmp(&spans[0], gfx.get_segment_buffer(), size);
+}
+
+
+static void check_spans() {
+	// panel and byte edges, off both sides, one pixel, up to more than the panel
+	static const int16_t xs[] = {-20, -9, -8, -1, 0, 1, 3, 7, 8, 9, 100, 255, 256, 257, 262, 263, 264, 270};
+	static const int16_t ws[] = {-3, 0, 1, 2, 5, 7, 8, 9, 15, 16, 17, 33, 264, 300};
+	static const int16_t ys[] = {-12, -1, 0, 5, 7, 8, 10, 168, 175, 176};
+	static const int16_t hs[] = {-1, 0, 1, 2, 3, 8, 9, 30, 200};
+	static const uint16_t segment_heights[] = {8, 11};
+
+	for (size_t sh = 0; sh < sizeof(segment_heights) / sizeof(segment_heights[0]); ++sh) {
+		EPD_Class EPD(EPD_2_7, 2, 3, 4, 5, 6, 7, Pin_EPD_CS);
+		EPD_GFX gfx(EPD, panel_width, panel_height, 25, segment_heights[sh]);
+
+		uint32_t different = 0;
+		for (size_t a = 0; a < sizeof(xs) / sizeof(xs[0]); ++a) {
+			for (size_t b = 0; b < sizeof(ws) / sizeof(ws[0]); ++b) {
+				for (size_t c = 0; c < sizeof(ys) / sizeof(ys[0]); ++c) {
+					for (uint8_t s = 0; s < gfx.get_segment_count(); ++s) {
+						for (uint16_t colour = EPD_GFX::WHITE; colour <= EPD_GFX::BLACK; ++colour) {
+							different += !span_matches(gfx, s, SPAN_HLINE, xs[a], ys[c], ws[b], 1, colour);
+							different += !span_matches(gfx, s, SPAN_VLINE, xs[a], ys[c], 1, ws[b], colour);
+							for (size_t d = 0; d < sizeof(hs) / sizeof(hs[0]); ++d) {
+								different += !span_matches(gfx, s, SPAN_FILL_RECT, xs[a], ys[c], ws[b], hs[d], colour);
+							}
+						}
+					}
+				}
+			}
+		}
+		CHECK_EQUAL(0, different);
+	}
+}
+
+
+
+// a line of text in every segment, three ways, against Adafruit_GFX's
+// drawChar() on the canvas (over a black left half, to show the background)
+static void check_text_line(EPD_GFX &gfx, int16_t x, int16_t y, const char *text,
+                            uint16_t colour, uint16_t bg, uint8_t size) {
+	const int16_t advance = 6 * size;
+	const int16_t end = x + strlen(text) * advance;
+
+	canvas reference;
+	reference.fillRect(0, 0, panel_width / 2, panel_height, EPD_GFX::BLACK);
+	for (const char *c = text; '\0' != *c; ++c) {
+		reference.Adafruit_GFX::drawChar(x + (c - text) * advance, y, *c, colour, bg, size);
+	}
+
+	static EPD_GFX_primitive storage[2];
+	EPD_GFX_display_list list(storage, sizeof(storage) / sizeof(storage[0]));
+	list.fillRect(0, 0, panel_width / 2, panel_height, EPD_GFX::BLACK);
+	list.drawText(x, y, text, colour, bg, size);
+
+	uint16_t chars_different = 0;
+	uint16_t text_different = 0;
+	uint16_t list_different = 0;
+	for (uint8_t s = 0; s < gfx.get_segment_count(); ++s) {
+		gfx.set_current_segment(s);
+		gfx.fillRect(0, 0, panel_width / 2, panel_height, EPD_GFX::BLACK);
+		for (const char *c = text; '\0' != *c; ++c) {
+			gfx.drawChar(x + (c - text) * advance, y, *c, colour, bg, size);
+		}
+		chars_different += !segment_matches(gfx, s, reference);
+
+		gfx.set_current_segment(s);
+		gfx.fillRect(0, 0, panel_width / 2, panel_height, EPD_GFX::BLACK);
+		CHECK_EQUAL(end, gfx.drawText(x, y, text, colour, bg, size));
+		text_different += !segment_matches(gfx, s, reference);
+
+		gfx.set_current_segment(s);
+		gfx.draw_list(list);
+		list_different += !segment_matches(gfx, s, reference);
+	}
+	CHECK_EQUAL(0, chars_different);
+	CHECK_EQUAL(0, text_different);
+	CHECK_EQUAL(0, list_different);
+}
+
+
+static void check_text() {
+	// every row and column of the glyphs is used somewhere in here
+	static const char text[] = "\x01" "Ab7\x7f\x80\xfe\xff";
+	// off the left, on byte edges and the middle (the background's edge), off the right
+	static const int16_t xs[] = {-40, -13, -6, -1, 0, 3, 8, 127, 130, 250, 259, 263, 264};
+	// off the top, within a segment, straddling 8 and 11 row segments, off the bottom
+	static const int16_t ys[] = {-30, -9, -3, 0, 2, 5, 9, 20, 84, 150, 170, 175, 176};
+	static const uint16_t segment_heights[] = {1, 8, 11};
+
+	for (size_t sh = 0; sh < sizeof(segment_heights) / sizeof(segment_heights[0]); ++sh) {
+		EPD_Class EPD(EPD_2_7, 2, 3, 4, 5, 6, 7, Pin_EPD_CS);
+		EPD_GFX gfx(EPD, panel_width, panel_height, 25, segment_heights[sh]);
+		for (uint8_t size = 1; size <= 5; ++size) {
+			for (size_t a = 0; a < sizeof(xs) / sizeof(xs[0]); ++a) {
+				for (size_t b = 0; b < sizeof(ys) / sizeof(ys[0]); ++b) {
+					// transparent, then opaque on either background
+					check_text_line(gfx, xs[a], ys[b], text, EPD_GFX::BLACK, EPD_GFX::BLACK, size);
+					check_text_line(gfx, xs[a], ys[b], text, EPD_GFX::WHITE, EPD_GFX::WHITE, size);
+					check_text_line(gfx, xs[a], ys[b], text, EPD_GFX::BLACK, EPD_GFX::WHITE, size);
+					check_text_line(gfx, xs[a], ys[b], text, EPD_GFX::WHITE, EPD_GFX::BLACK, size);
+				}
+			}
+		}
+	}
+}
+
+
+int main() {
+	mock_reset();
+
+	check_differential();
+	check_transition();
+	check_display_list();
+	check_spans();
+	check_text();
+
+	return test_report("epd_gfx");
+}
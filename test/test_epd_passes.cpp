@@ -0,0 +1,86 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// the number of passes in a stage only depends on the panel size and
+// the temperature factor, not on how long the lines take to produce
+
+#include <Arduino.h>
+#include <EPD.h>
+
+#include "cog.h"
+#include "test.h"
+
+static const uint8_t Pin_EPD_CS = 8;
+
+// transactions sent for each line by EPD_Class::line()
+static const size_t transactions_per_line = 6;
+
+
+// an image source that takes a long time over every line
+static void slow_reader(void *buffer, uint32_t address, uint16_t length) {
+	memset(buffer, address, length);
+	delay(5);
+}
+
+
+static uint16_t passes_sent(EPD_size size) {
+	return cog_log.size() / transactions_per_line / cog_lines(size);
+}
+
+
+static void check_passes(EPD_size size, uint16_t passes_1x) {
+	EPD_Class EPD(size, 2, 3, 4, 5, 6, 7, Pin_EPD_CS);
+	cog_attach(Pin_EPD_CS);
+
+	static const int temperatures[] = {-10, 0, 10, 25, 45};
+	for (size_t t = 0; t < sizeof(temperatures) / sizeof(temperatures[0]); ++t) {
+		EPD.setFactor(temperatures[t]);
+		uint16_t expected = (passes_1x * EPD.temperature_to_factor_10x(temperatures[t]) + 9) / 10;
+
+		cog_clear();
+		EPD.frame_fixed_repeat(0xaa, EPD_compensate);
+		CHECK_EQUAL(expected, passes_sent(size));
+
+		cog_clear();
+		EPD.frame_cb_repeat(0, slow_reader, EPD_normal);
+		CHECK_EQUAL(expected, passes_sent(size));
+
+		// caller driven stage in two bands
+		cog_clear();
+		uint16_t half = cog_lines(size) / 2;
+		EPD.stage_start();
+		while (EPD.stage_pass()) {
+			EPD.frame_cb(0, slow_reader, EPD_inverse, 0, half);
+			EPD.frame_fixed(0x00, EPD_inverse, half, cog_lines(size) - half);
+		}
+		CHECK_EQUAL(expected, passes_sent(size));
+
+		// a partial update gives each of its lines the same drive
+		cog_clear();
+		EPD.frame_fixed_repeat(0xff, EPD_white, 8, 16);
+		CHECK_EQUAL(expected * 16 * transactions_per_line, cog_log.size());
+	}
+}
+
+
+int main() {
+	mock_reset();
+
+	check_passes(EPD_1_44, 29);
+	check_passes(EPD_2_0, 24);
+	check_passes(EPD_2_7, 13);
+
+	return test_report("epd_passes");
+}
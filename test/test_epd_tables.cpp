@@ -0,0 +1,77 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// EPD_tables.h against the original per pixel encoder, table by table and
+// for whole lines sent by EPD_Class::line()
+
+#include <Arduino.h>
+#include <EPD.h>
+#include <EPD_tables.h>
+
+#include "cog.h"
+#include "test.h"
+
+static const uint8_t Pin_EPD_CS = 8;
+
+
+static void check_tables() {
+	for (int stage = EPD_compensate; stage <= EPD_normal; ++stage) {
+		for (int pixels = 0; pixels < 256; ++pixels) {
+			CHECK_EQUAL(cog_even_pixels(pixels, (EPD_stage)stage), pgm_read_byte_near(&EPD_even_pixels[stage][pixels]));
+			CHECK_EQUAL(cog_odd_pixels(pixels, (EPD_stage)stage), pgm_read_byte_near(&EPD_odd_pixels[stage][pixels]));
+		}
+	}
+}
+
+
+static void check_lines(EPD_size size) {
+	EPD_Class EPD(size, 2, 3, 4, 5, 6, 7, Pin_EPD_CS);
+	uint8_t data[264 / 8];
+
+	cog_attach(Pin_EPD_CS);
+	for (int stage = EPD_compensate; stage <= EPD_normal; ++stage) {
+		for (uint16_t line_no = 0; line_no < cog_lines(size); ++line_no) {
+			for (uint16_t b = 0; b < sizeof(data); ++b) {
+				data[b] = rand();
+			}
+			cog_clear();
+			EPD.line(line_no, data, 0, false, (EPD_stage)stage);
+			// 0x70 0x04, gate source, 0x70 0x0a, line data, 0x70 0x02, 0x72 0x2f
+			CHECK_EQUAL(6, cog_log.size());
+			if (cog_log.size() >= 4) {
+				CHECK(cog_line(size, line_no, data, 0, (EPD_stage)stage) == cog_log[3]);
+			}
+
+			cog_clear();
+			EPD.line(line_no, 0, 0x55, false, (EPD_stage)stage);
+			if (cog_log.size() >= 4) {
+				CHECK(cog_line(size, line_no, 0, 0x55, (EPD_stage)stage) == cog_log[3]);
+			}
+		}
+	}
+}
+
+
+int main() {
+	mock_reset();
+	srand(1);
+
+	check_tables();
+	check_lines(EPD_1_44);
+	check_lines(EPD_2_0);
+	check_lines(EPD_2_7);
+
+	return test_report("epd_tables");
+}
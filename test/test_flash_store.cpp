@@ -0,0 +1,418 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// the image store (FLASH.cpp and FLASH_STORE.cpp as built for the board)
+// on a simulated FLASH kept in a file next to this program: format, add,
+// remove, listing, directory compaction, wear levelling, and a power cut after every
+// program/erase command of a sequence that includes a compaction, each
+// followed by a remount from the file that must find either the state
+// before or the state after the interrupted operation
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <FLASH.h>
+#include <FLASH_STORE.h>
+
+#include "mx25.h"
+#include "test.h"
+
+static const uint8_t Pin_FLASH_CS = 9;
+
+static std::string flash_file;     // the FLASH contents
+static std::string snapshot_file;  // saved contents to restart from
+
+typedef std::vector<std::string> names;
+
+
+// the bytes of image seed (any length)
+static uint8_t image_byte(uint8_t seed, uint32_t offset) {
+	return seed * 37 + offset * 11 + (offset >> 8);
+}
+
+
+// write an image and record it, as flash_loader and amslide do
+static int16_t store_image(FLASH_STORE_Class &store, const char *name, uint32_t length, uint8_t seed) {
+	int16_t sector = store.allocate(length, false);
+	if (sector < 0) {
+		return -1;
+	}
+	uint32_t address = (uint32_t)sector << FLASH_SECTOR_SHIFT;
+	FLASH_page_writer writer(FLASH, address);
+	uint32_t crc = 0;
+	uint8_t buffer[50];
+	for (uint32_t offset = 0; offset < length; offset += sizeof(buffer)) {
+		uint16_t n = std::min<uint32_t>(sizeof(buffer), length - offset);
+		for (uint16_t i = 0; i < n; ++i) {
+			buffer[i] = image_byte(seed, offset + i);
+		}
+		writer.write(buffer, n);
+		crc = FLASH_STORE_Class::crc32(crc, buffer, n);
+	}
+	writer.finish();
+	if (store.crc32_flash(address, length) != crc) {
+		return -1;
+	}
+	return store.add(name, sector, length, 1, FLASH_STORE_XBM, crc);
+}
+
+
+static bool copy_file(const std::string &from, const std::string &to) {
+	FILE *in = fopen(from.c_str(), "rb");
+	FILE *out = fopen(to.c_str(), "wb");
+	bool ok = 0 != in && 0 != out;
+	char buffer[4096];
+	for (size_t n; ok && 0 != (n = fread(buffer, 1, sizeof(buffer), in)); ) {
+		ok = fwrite(buffer, 1, n, out) == n;
+	}
+	if (0 != in) {
+		fclose(in);
+	}
+	if (0 != out) {
+		fclose(out);
+	}
+	return ok;
+}
+
+
+// reopen the FLASH file as after a reset
+static void power_on() {
+	mock_reset();
+	CHECK(mx25_attach(Pin_FLASH_CS, flash_file.c_str()));
+	FLASH.begin(Pin_FLASH_CS);
+}
+
+
+// the images in the store (checking each against its CRC) and that no
+// two share a sector and the free count matches
+static names check_store(FLASH_STORE_Class &store) {
+	names found;
+	std::vector<bool> used(FLASH_SECTOR_COUNT, false);
+	uint16_t used_count = 0;
+	FLASH_STORE_entry entry;
+	for (int16_t id = store.next(0, &entry); id >= 0; id = store.next(id + 1, &entry)) {
+		found.push_back(entry.name);
+		CHECK(FLASH_STORE_Class::verify(&entry));
+		CHECK(entry.first_sector >= FLASH_STORE_FIRST_DATA_SECTOR);
+		for (uint16_t s = entry.first_sector; s < entry.first_sector + entry.sector_count; ++s) {
+			CHECK(s < FLASH_SECTOR_COUNT && !used[s]);
+			used[s] = true;
+			++used_count;
+		}
+	}
+	CHECK_EQUAL(FLASH_SECTOR_COUNT - FLASH_STORE_FIRST_DATA_SECTOR - used_count, store.free_sectors());
+	std::sort(found.begin(), found.end());
+	return found;
+}
+
+
+static void test_crc32() {
+	CHECK_EQUAL(0xcbf43926, FLASH_STORE_Class::crc32(0, "123456789", 9));
+	uint32_t crc = FLASH_STORE_Class::crc32(0, "1234", 4);
+	CHECK_EQUAL(0xcbf43926, FLASH_STORE_Class::crc32(crc, "56789", 5));
+}
+
+
+static void test_format() {
+	remove(flash_file.c_str());
+	power_on();
+	CHECK(FLASH.available());
+
+	FLASH_STORE_Class store;
+	CHECK(!store.begin());
+	CHECK(!store.mounted());
+	CHECK_EQUAL(-1, store.allocate(100));
+
+	store.format();
+	CHECK(store.mounted());
+	CHECK_EQUAL(FLASH_STORE_ENTRIES, store.free_entries());
+	CHECK_EQUAL(FLASH_SECTOR_COUNT - FLASH_STORE_FIRST_DATA_SECTOR, store.free_sectors());
+	CHECK(0 == memcmp(&mx25_memory[0], FLASH_STORE_MAGIC, 4));
+
+	power_on();
+	FLASH_STORE_Class remounted;
+	CHECK(remounted.begin());
+	CHECK(check_store(remounted).empty());
+}
+
+
+static void test_add_remove() {
+	power_on();
+	FLASH_STORE_Class store;
+	store.begin();
+
+	CHECK_EQUAL(0, store_image(store, "one", 1, 1));
+	CHECK_EQUAL(1, store_image(store, "two", 3 * FLASH_SECTOR_SIZE, 2));
+	CHECK_EQUAL(2, store_image(store, "three", 5000, 3));
+	CHECK_EQUAL(FLASH_SECTOR_COUNT - FLASH_STORE_FIRST_DATA_SECTOR - 6, store.free_sectors());
+	CHECK_EQUAL(FLASH_STORE_ENTRIES - 3, store.free_entries());
+
+	FLASH_STORE_entry entry;
+	CHECK_EQUAL(1, store.find("two", &entry));
+	CHECK_EQUAL(3 * FLASH_SECTOR_SIZE, entry.length);
+	CHECK_EQUAL(3, entry.sector_count);
+	CHECK_EQUAL(FLASH_STORE_FIRST_DATA_SECTOR + 1, entry.first_sector);
+	CHECK_EQUAL(-1, store.find("four", &entry));
+
+	// a changed byte fails the check
+	CHECK(store.get(2, &entry));
+	CHECK(FLASH_STORE_Class::verify(&entry));
+	mx25_memory[FLASH_STORE_Class::address(&entry) + 4321] ^= 0x01;
+	CHECK(!FLASH_STORE_Class::verify(&entry));
+	mx25_memory[FLASH_STORE_Class::address(&entry) + 4321] ^= 0x01;
+
+	CHECK(store.remove(1));
+	CHECK(!store.remove(1));
+	CHECK(!store.get(1, &entry));
+	CHECK_EQUAL(-1, store.find("two", &entry));
+	CHECK_EQUAL(2, store.next(1, &entry));
+	CHECK_EQUAL(-1, store.next(3, &entry));
+	CHECK_EQUAL(FLASH_SECTOR_COUNT - FLASH_STORE_FIRST_DATA_SECTOR - 3, store.free_sectors());
+
+	// next fit: after the last image, not in the gap
+	CHECK_EQUAL(3, store_image(store, "four", 2 * FLASH_SECTOR_SIZE, 4));
+	CHECK(store.get(3, &entry));
+	CHECK_EQUAL(FLASH_STORE_FIRST_DATA_SECTOR + 6, entry.first_sector);
+
+	names expected;
+	expected.push_back("four");
+	expected.push_back("one");
+	expected.push_back("three");
+	CHECK(check_store(store) == expected);
+
+	power_on();
+	FLASH_STORE_Class remounted;
+	CHECK(remounted.begin());
+	CHECK(check_store(remounted) == expected);
+	CHECK_EQUAL(FLASH_STORE_ENTRIES - 3, remounted.free_entries());
+
+	// more than fits
+	CHECK_EQUAL(-1, remounted.allocate((uint32_t)FLASH_SECTOR_COUNT * FLASH_SECTOR_SIZE));
+
+	// after the remount allocation also continues after the last image,
+	// then wraps round to the gap once the end is reached (runs that are
+	// not added stay free)
+	uint16_t rest = FLASH_SECTOR_COUNT - FLASH_STORE_FIRST_DATA_SECTOR - 8;
+	CHECK_EQUAL(FLASH_STORE_FIRST_DATA_SECTOR + 8, remounted.allocate((uint32_t)rest * FLASH_SECTOR_SIZE, false));
+	CHECK_EQUAL(FLASH_STORE_FIRST_DATA_SECTOR + 1, remounted.allocate(FLASH_SECTOR_SIZE, false));
+	CHECK_EQUAL(FLASH_STORE_FIRST_DATA_SECTOR + 2, remounted.allocate(2 * FLASH_SECTOR_SIZE, false));
+	CHECK_EQUAL(FLASH_STORE_FIRST_DATA_SECTOR + 8, remounted.allocate(4 * FLASH_SECTOR_SIZE, false));
+}
+
+
+// two images replaced in turn (amslide's slots) spread their erases over
+// the whole FLASH
+static void test_wear() {
+	power_on();
+	FLASH_STORE_Class store;
+	store.format();
+
+	int16_t slot[2] = {-1, -1};
+	const int rounds = 1000;
+	for (int i = 0; i < rounds; ++i) {
+		if (slot[i % 2] >= 0) {
+			CHECK(store.remove(slot[i % 2]));
+		}
+		slot[i % 2] = store_image(store, i % 2 ? "slide.1" : "slide.0", 5000, i);
+		CHECK(slot[i % 2] >= 0);
+	}
+
+	// 2 sectors per image
+	const unsigned long even = (2 * rounds + FLASH_SECTOR_COUNT - FLASH_STORE_FIRST_DATA_SECTOR - 1)
+		/ (FLASH_SECTOR_COUNT - FLASH_STORE_FIRST_DATA_SECTOR);
+	for (uint16_t s = FLASH_STORE_FIRST_DATA_SECTOR; s < FLASH_SECTOR_COUNT; ++s) {
+		CHECK(mx25_erases[s] <= even);
+	}
+}
+
+
+// keep replacing images until the directory has moved back and forth
+static void test_compaction() {
+	power_on();
+	FLASH_STORE_Class store;
+	store.format();
+
+	std::deque<std::string> live;
+	char name[FLASH_STORE_NAME_SIZE];
+	for (int i = 0; i < 2 * FLASH_STORE_ENTRIES + 10; ++i) {
+		if (FLASH_STORE_ENTRIES + 1 == i) {
+			// moved to the second directory sector, the first is erased
+			CHECK(0 == memcmp(&mx25_memory[FLASH_SECTOR_SIZE], FLASH_STORE_MAGIC, 4));
+			CHECK_EQUAL(0xff, mx25_memory[0]);
+		}
+		snprintf(name, sizeof(name), "image%d", i);
+		CHECK(store_image(store, name, 1000 + 500 * (i % 5), i) >= 0);
+		live.push_back(name);
+		if (live.size() > 3) {
+			FLASH_STORE_entry entry;
+			CHECK(store.remove(store.find(live.front().c_str(), &entry)));
+			live.pop_front();
+		}
+	}
+	// and back
+	CHECK(0 == memcmp(&mx25_memory[0], FLASH_STORE_MAGIC, 4));
+	CHECK_EQUAL(0xff, mx25_memory[FLASH_SECTOR_SIZE]);
+
+	names expected(live.begin(), live.end());
+	std::sort(expected.begin(), expected.end());
+	CHECK(check_store(store) == expected);
+
+	power_on();
+	FLASH_STORE_Class remounted;
+	CHECK(remounted.begin());
+	CHECK(check_store(remounted) == expected);
+}
+
+
+// replace images, starting from a directory with three empty slots so the
+// fourth add has to compact it
+static const int setup_images = FLASH_STORE_ENTRIES - 3;
+static const int workload_steps = 8;
+
+struct workload {
+	FLASH_STORE_Class &store;
+	std::deque<std::string> live;
+	int added;
+
+	workload(FLASH_STORE_Class &store) : store(store), added(0) {
+		char name[FLASH_STORE_NAME_SIZE];
+		for (int i = setup_images - 2; i < setup_images; ++i) {
+			snprintf(name, sizeof(name), "base%d", i);
+			this->live.push_back(name);
+		}
+	}
+
+	// add and remove in turn, failures are ignored (the power may be off)
+	void step(int i) {
+		if (0 == i % 2) {
+			char name[FLASH_STORE_NAME_SIZE];
+			snprintf(name, sizeof(name), "new%d", this->added);
+			store_image(this->store, name, 2000 + 3000 * (this->added % 2), 100 + this->added);
+			++this->added;
+			this->live.push_back(name);
+		} else {
+			FLASH_STORE_entry entry;
+			int16_t id = this->store.find(this->live.front().c_str(), &entry);
+			if (id >= 0) {
+				this->store.remove(id);
+			}
+			this->live.pop_front();
+		}
+	}
+};
+
+
+static void test_power_cut() {
+	power_on();
+	FLASH_STORE_Class setup;
+	setup.format();
+	char name[FLASH_STORE_NAME_SIZE];
+	for (int i = 0; i < setup_images; ++i) {
+		snprintf(name, sizeof(name), "base%d", i);
+		CHECK(store_image(setup, name, 3000, i) >= 0);
+		if (i >= 2) {
+			FLASH_STORE_entry entry;
+			snprintf(name, sizeof(name), "base%d", i - 2);
+			CHECK(setup.remove(setup.find(name, &entry)));
+		}
+	}
+	CHECK_EQUAL(FLASH_STORE_ENTRIES - 2, setup.free_entries());
+	mx25_detach();
+	CHECK(copy_file(flash_file, snapshot_file));
+
+	// without a cut: the images after each step and the program/erase
+	// commands used up to its end
+	std::vector<names> states;
+	std::vector<unsigned long> commands;
+	power_on();
+	{
+		FLASH_STORE_Class store;
+		CHECK(store.begin());
+		states.push_back(check_store(store));
+		workload w(store);
+		for (int i = 0; i < workload_steps; ++i) {
+			w.step(i);
+			states.push_back(check_store(store));
+			commands.push_back(mx25_commands);
+		}
+		CHECK(0 == memcmp(&mx25_memory[FLASH_SECTOR_SIZE], FLASH_STORE_MAGIC, 4));
+		CHECK_EQUAL(2, states.back().size());
+	}
+
+	for (unsigned long cut = 0; cut <= commands.back(); ++cut) {
+		int failures = test_failures;
+		CHECK(copy_file(snapshot_file, flash_file));
+		power_on();
+		{
+			FLASH_STORE_Class store;
+			CHECK(store.begin());
+			mx25_power_cut(cut);
+			workload w(store);
+			for (int i = 0; i < workload_steps; ++i) {
+				w.step(i);
+			}
+		}
+
+		// the step that was interrupted
+		int step = 0;
+		while (step < workload_steps && commands[step] <= cut) {
+			++step;
+		}
+
+		power_on();
+		FLASH_STORE_Class store;
+		CHECK(store.begin());
+		names found = check_store(store);
+		if (step < workload_steps) {
+			CHECK(found == states[step] || found == states[step + 1]);
+		} else {
+			CHECK(found == states[step]);
+		}
+
+		// still usable
+		CHECK(store_image(store, "after", 7000, 200) >= 0);
+		FLASH_STORE_entry entry;
+		CHECK(store.find("after", &entry) >= 0);
+		CHECK(FLASH_STORE_Class::verify(&entry));
+
+		if (failures != test_failures) {
+			printf("power cut after %lu program/erase commands (in step %d)\n", cut, step);
+		}
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	(void)argc;
+	std::string directory = argv[0];
+	size_t slash = directory.rfind('/');
+	directory = std::string::npos == slash ? "." : directory.substr(0, slash);
+	flash_file = directory + "/flash_store.bin";
+	snapshot_file = directory + "/flash_store_snapshot.bin";
+
+	test_crc32();
+	test_format();
+	test_add_remove();
+	test_compaction();
+	test_wear();
+	test_power_cut();
+	mx25_detach();
+	return test_report("flash_store");
+}
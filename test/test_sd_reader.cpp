@@ -0,0 +1,177 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+// SD_reader on a file written next to this program, with several cache
+// sizes: line by line passes as the EPD stages read them (one card read per
+// block, one seek per pass), random reads, and zeros past the end of the file
+// or with no file or cache
+
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <SPI_BUS.h>
+#include <SD.h>
+#include <SD_READER.h>
+
+#include "test.h"
+
+// 2.7" lines, and a size that is not a multiple of any cache size
+static const uint16_t line_bytes = 264 / 8;
+static const uint32_t file_size = 176 * line_bytes + 13;
+
+static std::vector<uint8_t> contents;
+
+static SPI_BUS_device other_device = {MSBFIRST, SPI_MODE3, SPI_CLOCK_DIV2, -1, LOW};
+
+
+static bool write_file(const std::string &path) {
+	contents.resize(file_size);
+	for (uint32_t i = 0; i < file_size; ++i) {
+		contents[i] = i * 7 + (i >> 8) + 1;  // no zeros before the end
+	}
+	FILE *f = fopen(path.c_str(), "wb");
+	if (0 == f) {
+		return false;
+	}
+	bool ok = fwrite(&contents[0], 1, file_size, f) == file_size;
+	return 0 == fclose(f) && ok;
+}
+
+
+// what read() should give: the file then zeros
+static bool matches(const uint8_t *buffer, uint32_t address, uint16_t length) {
+	for (uint16_t i = 0; i < length; ++i) {
+		uint8_t expected = address + i < file_size ? contents[address + i] : 0;
+		if (expected != buffer[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static void check_passes(SD_reader &reader, uint16_t cache_size) {
+	uint8_t line[line_bytes];
+	uint32_t blocks = (file_size + cache_size - 1) / cache_size;
+
+	for (int pass = 0; pass < 3; ++pass) {
+		// another device has the bus between passes
+		SPI_BUS.acquire(&other_device);
+		mock_sd_reset();
+		for (uint32_t address = 0; address < file_size; address += line_bytes) {
+			memset(line, 0xee, sizeof(line));
+			reader.read(line, address, sizeof(line));
+			CHECK(matches(line, address, sizeof(line)));
+		}
+		// each block read once, a seek back to the top
+		CHECK_EQUAL(blocks, mock_sd_reads);
+		CHECK_EQUAL(1, mock_sd_seeks);
+		CHECK_EQUAL(0, mock_sd_wrong_mode);
+		// the bus is given back
+		CHECK(SPI_BUS.acquire(&other_device));
+	}
+}
+
+
+static void check_random(SD_reader &reader) {
+	uint8_t buffer[700];
+	uint32_t seed = 1;
+	for (int i = 0; i < 2000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		uint32_t address = (seed >> 8) % (file_size + 200);
+		seed = seed * 1103515245 + 12345;
+		uint16_t length = (seed >> 8) % sizeof(buffer);
+		memset(buffer, 0xee, sizeof(buffer));
+		reader.read(buffer, address, length);
+		CHECK(matches(buffer, address, length));
+		CHECK_EQUAL(0xee, buffer[length]);
+	}
+}
+
+
+static void check_end(SD_reader &reader) {
+	uint8_t buffer[40];
+
+	// across the end
+	memset(buffer, 0xee, sizeof(buffer));
+	reader.read(buffer, file_size - 5, sizeof(buffer));
+	CHECK(matches(buffer, file_size - 5, sizeof(buffer)));
+
+	// all past the end
+	memset(buffer, 0xee, sizeof(buffer));
+	reader.read(buffer, file_size + 1000, sizeof(buffer));
+	CHECK(matches(buffer, file_size + 1000, sizeof(buffer)));
+
+	// and back
+	reader.read(buffer, 3, sizeof(buffer));
+	CHECK(matches(buffer, 3, sizeof(buffer)));
+}
+
+
+int main(int argc, char *argv[]) {
+	(void)argc;
+	std::string path = argv[0];
+	size_t slash = path.rfind('/');
+	path = (std::string::npos == slash ? std::string(".") : path.substr(0, slash)) + "/sd_reader.bin";
+	CHECK(write_file(path));
+
+	static const uint16_t cache_sizes[] = {7, 25, 128, 512};
+	for (size_t c = 0; c < sizeof(cache_sizes) / sizeof(cache_sizes[0]); ++c) {
+		mock_reset();
+		File file = SD.open(path.c_str());
+		CHECK(file);
+		CHECK_EQUAL(file_size, file.size());
+
+		std::vector<uint8_t> cache(cache_sizes[c]);
+		SD_reader reader(&cache[0], cache.size());
+		reader.begin(file);
+		check_passes(reader, cache.size());
+		check_random(reader);
+		check_end(reader);
+
+		// begin() forgets the cached block: the file was read by something else
+		reader.begin(file);
+		uint8_t header[4];
+		CHECK_EQUAL(4, file.read(header, 4));
+		uint8_t buffer[10];
+		reader.read(buffer, 5, sizeof(buffer));
+		CHECK(matches(buffer, 5, sizeof(buffer)));
+
+		file.close();
+	}
+
+	// no file: zeros
+	uint8_t cache[16];
+	SD_reader reader(cache, sizeof(cache));
+	uint8_t buffer[8];
+	memset(buffer, 0xee, sizeof(buffer));
+	reader.read(buffer, 0, sizeof(buffer));
+	CHECK(matches(buffer, file_size, sizeof(buffer)));
+
+	// no cache: zeros, without touching the card
+	mock_sd_reset();
+	File file = SD.open(path.c_str());
+	SD_reader uncached(cache, 0);
+	uncached.begin(file);
+	memset(buffer, 0xee, sizeof(buffer));
+	uncached.read(buffer, 5, sizeof(buffer));
+	CHECK(matches(buffer, file_size, sizeof(buffer)));
+	CHECK_EQUAL(0, mock_sd_reads);
+	file.close();
+
+	return test_report("sd_reader");
+}
@@ -0,0 +1,206 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+// TEMPERATURE_filter with millis() from the simulated clock: the first
+// sample, the moving average, the maximum age, and rounding to degrees
+// either side of zero; then an LM75A on the Wire stand-in that stops
+// answering for a while
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <TEMPERATURE.h>
+#include <LM75A.h>
+
+#include "test.h"
+
+static const int16_t scale = TEMPERATURE_SCALE;
+
+
+static void advance_ms(unsigned long ms) {
+	mock_micros += ms * 1000;
+}
+
+
+static void check_first_sample() {
+	TEMPERATURE_filter filter;
+	CHECK(filter.expired());
+
+	// sets the average, whatever the weight of later samples
+	filter.sample(23 * scale + 4);
+	CHECK(!filter.expired());
+	CHECK_EQUAL(23 * scale + 4, filter.average());
+	CHECK_EQUAL(23, filter.read());
+}
+
+
+static void check_average() {
+	TEMPERATURE_filter filter(TEMPERATURE_MAX_AGE_MS, 2);
+
+	// each sample moves the average a quarter of the way
+	filter.sample(400);
+	filter.sample(800);
+	CHECK_EQUAL(500, filter.average());
+	filter.sample(800);
+	CHECK_EQUAL(575, filter.average());
+	filter.sample(800);
+	CHECK_EQUAL(631, filter.average());
+
+	// and settles on a steady value
+	for (int i = 0; i < 40; ++i) {
+		filter.sample(800);
+	}
+	CHECK_EQUAL(800, filter.average());
+
+	// a single noisy sample is damped
+	filter.sample(800 + 4 * scale);
+	CHECK_EQUAL(800 + scale, filter.average());
+
+	// no averaging, keeping the current value
+	filter.set_shift(0);
+	CHECK_EQUAL(800 + scale, filter.average());
+	filter.sample(-100);
+	CHECK_EQUAL(-100, filter.average());
+
+	// a new first sample after invalidate()
+	filter.set_shift(3);
+	filter.invalidate();
+	CHECK(filter.expired());
+	filter.sample(320);
+	CHECK_EQUAL(320, filter.average());
+}
+
+
+static void check_max_age() {
+	TEMPERATURE_filter filter(1000);
+	advance_ms(12345);
+	filter.sample(0);
+
+	advance_ms(999);
+	CHECK(!filter.expired());
+	advance_ms(1);
+	CHECK(filter.expired());
+	filter.sample(0);
+	CHECK(!filter.expired());
+
+	// 0 samples on every read
+	filter.set_max_age(0);
+	CHECK(filter.expired());
+
+	// millis() wrapping round
+	TEMPERATURE_filter wrap(1000);
+	mock_micros = 0xffffffffUL * 1000 - 500 * 1000;
+	CHECK_EQUAL(0xffffffffUL - 500, millis());
+	wrap.sample(0);
+	advance_ms(999);
+	CHECK(!wrap.expired());
+	advance_ms(1);
+	CHECK(wrap.expired());
+	mock_micros = 0;
+}
+
+
+// round half away from zero
+static void check_rounding() {
+	static const struct {
+		int16_t value;
+		int degrees;
+	} cases[] = {
+		{0, 0},
+		{scale / 2 - 1, 0},
+		{scale / 2, 1},
+		{-scale / 2 + 1, 0},
+		{-scale / 2, -1},
+		{-scale - scale / 2 + 1, -1},
+		{-scale - scale / 2, -2},
+		{-10 * scale, -10},
+		{-10 * scale - 1, -10},
+		{-40 * scale + scale / 2, -40},
+		{85 * scale, 85}
+	};
+	TEMPERATURE_filter filter(TEMPERATURE_MAX_AGE_MS, 0);
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		filter.sample(cases[i].value);
+		CHECK_EQUAL(cases[i].degrees, filter.read());
+	}
+}
+
+
+// the LM75A register: 11 bit two's complement degrees in the top bits
+static void lm75a_answers(int16_t eighths) {
+	uint16_t raw = (uint16_t)eighths << 5;
+	mock_wire_response[0] = raw >> 8;
+	mock_wire_response[1] = raw & 0xff;
+	mock_wire_response_length = 2;
+}
+
+
+static void check_lm75a() {
+	mock_reset();
+	mock_wire_reset();
+	LM75A_Class sensor;
+	sensor.setFilter(0);
+
+	// no answer and no reading yet: 0, tried again on the next read()
+	CHECK_EQUAL(0, sensor.read());
+	CHECK_EQUAL(1, mock_wire_requests);
+	lm75a_answers(-4);   // -0.5
+	CHECK_EQUAL(-1, sensor.read());
+	CHECK_EQUAL(2, mock_wire_requests);
+	CHECK_EQUAL(0x49, mock_wire_address);
+
+	// cached until it is too old
+	lm75a_answers(25 * 8 + 3);
+	CHECK_EQUAL(-1, sensor.read());
+	CHECK_EQUAL(2, mock_wire_requests);
+	advance_ms(TEMPERATURE_MAX_AGE_MS);
+	CHECK_EQUAL(25, sensor.read());
+	CHECK_EQUAL(3, mock_wire_requests);
+
+	// a failed read keeps the last value and retries at once
+	advance_ms(TEMPERATURE_MAX_AGE_MS);
+	mock_wire_response_length = 1;
+	CHECK_EQUAL(25, sensor.read());
+	CHECK_EQUAL(4, mock_wire_requests);
+	CHECK_EQUAL(25, sensor.read());
+	CHECK_EQUAL(5, mock_wire_requests);
+	lm75a_answers(-10 * 8 - 4);  // -10.5
+	CHECK_EQUAL(-11, sensor.read());
+	CHECK_EQUAL(6, mock_wire_requests);
+	CHECK_EQUAL(-11, sensor.read());
+	CHECK_EQUAL(6, mock_wire_requests);
+
+	// 1/8 degree steps in 1/TEMPERATURE_SCALE degrees
+	int16_t value;
+	lm75a_answers(-1);
+	CHECK(sensor.sample(&value));
+	CHECK_EQUAL(-scale / 8, value);
+	lm75a_answers(125 * 8);
+	CHECK(sensor.sample(&value));
+	CHECK_EQUAL(125 * scale, value);
+}
+
+
+int main() {
+	mock_reset();
+
+	check_first_sample();
+	check_average();
+	check_max_age();
+	check_rounding();
+	check_lm75a();
+
+	return test_report("temperature");
+}
@@ -0,0 +1,540 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+// UPLOAD.cpp as built for the board, storing into FLASH_STORE on the
+// simulated FLASH, with the host's side of the serial line scripted here in
+// upload.py's framing: a clean upload (long enough for the sequence number
+// to wrap), lost start and end acks, damaged, truncated and short frames,
+// an image longer than announced or with the wrong CRC, abort, replacing an
+// image of the same name, a bad start frame and a host that goes quiet
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <FLASH.h>
+#include <FLASH_STORE.h>
+#include <UPLOAD.h>
+
+#include "mx25.h"
+#include "test.h"
+
+static const uint8_t Pin_FLASH_CS = 9;
+static const uint8_t Pin_RED_LED = 13;
+
+// 10 bits at 115200 baud
+static const unsigned long byte_us = 87;
+
+typedef std::vector<uint8_t> bytes;
+
+struct frame {
+	uint8_t type;
+	uint8_t sequence;
+	bytes payload;
+	bool id_payload;  // expected: the payload is the id receive() returned
+};
+
+
+// upload.py crc16(): binascii.crc_hqx(data, 0xffff)
+static uint16_t crc16(const bytes &data) {
+	uint16_t crc = 0xffff;
+	for (size_t i = 0; i < data.size(); ++i) {
+		crc ^= (uint16_t)data[i] << 8;
+		for (int b = 0; b < 8; ++b) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+
+// upload.py frame()
+static bytes encode(uint8_t type, uint8_t sequence, const bytes &payload = bytes()) {
+	bytes body;
+	body.push_back(type);
+	body.push_back(sequence);
+	body.push_back(payload.size());
+	body.insert(body.end(), payload.begin(), payload.end());
+	uint16_t crc = crc16(body);
+	bytes f(1, UPLOAD_SOF);
+	f.insert(f.end(), body.begin(), body.end());
+	f.push_back(crc & 0xff);
+	f.push_back(crc >> 8);
+	return f;
+}
+
+
+static void put_le32(bytes &b, uint32_t n) {
+	for (int i = 0; i < 32; i += 8) {
+		b.push_back(n >> i);
+	}
+}
+
+
+// upload.py: struct.pack('<IBBI', length, panel, format, crc) + name
+static bytes start_payload(uint32_t length, uint8_t panel, uint8_t format, uint32_t crc, const char *name) {
+	bytes b;
+	put_le32(b, length);
+	b.push_back(panel);
+	b.push_back(format);
+	put_le32(b, crc);
+	b.insert(b.end(), name, name + strlen(name));
+	return b;
+}
+
+
+static bytes image_data(uint32_t length, uint8_t seed) {
+	bytes b(length);
+	for (uint32_t i = 0; i < length; ++i) {
+		b[i] = seed * 29 + i * 7 + (i >> 8);
+	}
+	return b;
+}
+
+
+static uint32_t image_crc(const bytes &image) {
+	return FLASH_STORE_Class::crc32(0, &image[0], image.size());
+}
+
+
+// data frame seq of an image (seq counts from 1 and is sent modulo 256)
+static bytes data_frame(const bytes &image, unsigned seq) {
+	size_t offset = (seq - 1) * UPLOAD_PAYLOAD;
+	size_t end = min(image.size(), offset + UPLOAD_PAYLOAD);
+	return encode(UPLOAD_DATA, seq, bytes(image.begin() + offset, image.begin() + end));
+}
+
+
+static unsigned frame_count(const bytes &image) {
+	return (image.size() + UPLOAD_PAYLOAD - 1) / UPLOAD_PAYLOAD;
+}
+
+
+// host -> board: bytes, a negative value is a pause of that many milliseconds
+static std::deque<int> host_output;
+
+static void host_send(const bytes &b) {
+	host_output.insert(host_output.end(), b.begin(), b.end());
+}
+
+static void host_pause(int ms) {
+	host_output.push_back(-ms);
+}
+
+static void host_send_data(const bytes &image, unsigned first, unsigned last) {
+	for (unsigned seq = first; seq <= last; ++seq) {
+		host_send(data_frame(image, seq));
+	}
+}
+
+
+// time passes while the board waits: a pause runs out a millisecond at a
+// time, and once the script is done the host is quiet
+static int board_available() {
+	if (host_output.empty() || host_output.front() < 0) {
+		mock_micros += 1000;
+		if (!host_output.empty() && 0 == ++host_output.front()) {
+			host_output.pop_front();
+		}
+		return 0;
+	}
+	int n = 0;
+	for (std::deque<int>::iterator i = host_output.begin(); i != host_output.end() && *i >= 0; ++i) {
+		++n;
+	}
+	return n;
+}
+
+
+static int board_read() {
+	if (0 == board_available()) {
+		return -1;
+	}
+	mock_micros += byte_us;
+	int c = host_output.front();
+	host_output.pop_front();
+	return c;
+}
+
+
+// board -> host: frames with a good CRC, anything else is counted
+static std::vector<frame> replies;
+static bytes reply_bytes;
+static unsigned long reply_garbage;
+
+static void board_write(uint8_t c) {
+	if (reply_bytes.empty() && UPLOAD_SOF != c) {
+		++reply_garbage;
+		return;
+	}
+	reply_bytes.push_back(c);
+	if (reply_bytes.size() < 4 || reply_bytes.size() < 6u + reply_bytes[3]) {
+		return;
+	}
+	bytes body(reply_bytes.begin() + 1, reply_bytes.end() - 2);
+	uint16_t crc = reply_bytes[reply_bytes.size() - 2] | (reply_bytes[reply_bytes.size() - 1] << 8);
+	if (crc16(body) == crc) {
+		frame f = {body[0], body[1], bytes(body.begin() + 3, body.end()), false};
+		replies.push_back(f);
+	} else {
+		reply_garbage += reply_bytes.size();
+	}
+	reply_bytes.clear();
+}
+
+
+static frame ack(uint8_t sequence, const bytes &payload = bytes()) {
+	frame f = {UPLOAD_ACK, sequence, payload, false};
+	return f;
+}
+
+static frame nak(uint8_t error, uint8_t expected) {
+	frame f = {UPLOAD_NAK, expected, bytes(), false};
+	f.payload.push_back(error);
+	f.payload.push_back(expected);
+	return f;
+}
+
+static frame start_ack() {
+	bytes limits;
+	limits.push_back(UPLOAD_PAYLOAD);
+	limits.push_back(UPLOAD_WINDOW);
+	return ack(0, limits);
+}
+
+static frame end_ack(uint8_t sequence) {
+	frame f = ack(sequence);
+	f.id_payload = true;
+	return f;
+}
+
+// acks for data frames first..last
+static void add_acks(std::vector<frame> &expected, unsigned first, unsigned last) {
+	for (unsigned seq = first; seq <= last; ++seq) {
+		expected.push_back(ack(seq));
+	}
+}
+
+
+// run the script, the board must answer with expected and read all of it
+static int16_t run(const char *name, const std::vector<frame> &expected) {
+	replies.clear();
+	reply_bytes.clear();
+	reply_garbage = 0;
+	mock_pin[Pin_RED_LED] = HIGH;
+
+	int16_t id = UPLOAD.receive();
+
+	int failures = test_failures;
+	CHECK_EQUAL(expected.size(), replies.size());
+	for (size_t i = 0; i < expected.size() && i < replies.size(); ++i) {
+		CHECK_EQUAL(expected[i].type, replies[i].type);
+		CHECK_EQUAL(expected[i].sequence, replies[i].sequence);
+		CHECK(expected[i].id_payload ? bytes(1, id) == replies[i].payload
+		      : expected[i].payload == replies[i].payload);
+	}
+	CHECK_EQUAL(0, reply_garbage);
+	CHECK(reply_bytes.empty());
+	CHECK(host_output.empty());
+	if (!expected.empty() && UPLOAD_ACK == expected[0].type) {
+		// the upload started: the LED is off at the end
+		CHECK_EQUAL(LOW, mock_pin[Pin_RED_LED]);
+	}
+	if (failures != test_failures) {
+		printf("in %s\n", name);
+	}
+	host_output.clear();
+	return id;
+}
+
+
+// the image is stored once under its name and reads back correctly
+static void check_stored(int16_t id, const char *name, const bytes &image, uint8_t panel, uint8_t format) {
+	FLASH_STORE_entry entry;
+	CHECK(id >= 0);
+	CHECK_EQUAL(id, FLASH_STORE.find(name, &entry));
+	CHECK_EQUAL(image.size(), entry.length);
+	CHECK_EQUAL(panel, entry.panel);
+	CHECK_EQUAL(format, entry.format);
+	CHECK_EQUAL(image_crc(image), entry.crc);
+	CHECK(FLASH_STORE_Class::verify(&entry));
+	CHECK(0 == memcmp(&mx25_memory[FLASH_STORE_Class::address(&entry)], &image[0], image.size()));
+
+	int count = 0;
+	for (int16_t i = FLASH_STORE.next(0, &entry); i >= 0; i = FLASH_STORE.next(i + 1, &entry)) {
+		count += 0 == strcmp(name, entry.name);
+	}
+	CHECK_EQUAL(1, count);
+}
+
+
+static bytes start_frame(const bytes &image, const char *name, uint8_t panel = 3, uint8_t format = FLASH_STORE_XBM) {
+	return encode(UPLOAD_START, 0, start_payload(image.size(), panel, format, image_crc(image), name));
+}
+
+
+static void check_crc16() {
+	const char *check = "123456789";
+	CHECK_EQUAL(0x29b1, crc16(bytes(check, check + 9)));
+}
+
+
+// everything arrives: the sequence numbers wrap after 255 data frames, the
+// end ack carries the id and an abort finishes at once
+static void check_clean() {
+	bytes image = image_data(8000, 1);
+	unsigned n = frame_count(image);
+	CHECK(n > 256);
+
+	// some of the command line before the start frame
+	host_send(bytes(3, 'b'));
+	host_send(start_frame(image, "clean", 2, FLASH_STORE_PACKBITS));
+	host_send_data(image, 1, n);
+	host_send(encode(UPLOAD_END, n + 1));
+	host_send(encode(UPLOAD_ABORT, n + 2));
+
+	std::vector<frame> expected(1, start_ack());
+	add_acks(expected, 1, n);
+	expected.push_back(end_ack(n + 1));
+	uint16_t free_sectors = FLASH_STORE.free_sectors();
+	unsigned long start = millis();
+	int16_t id = run("clean", expected);
+	CHECK(millis() - start < 1000);
+	check_stored(id, "clean", image, 2, FLASH_STORE_PACKBITS);
+	CHECK_EQUAL(free_sectors - (image.size() + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE, FLASH_STORE.free_sectors());
+}
+
+
+// the start ack is lost: the host sends the start frame again
+static void check_start_ack_lost() {
+	bytes image = image_data(60, 2);
+	host_send(start_frame(image, "start"));
+	host_pause(3000);
+	host_send(start_frame(image, "start"));
+	host_send_data(image, 1, 3);
+	host_send(encode(UPLOAD_END, 4));
+	host_send(encode(UPLOAD_ABORT, 5));
+
+	std::vector<frame> expected(2, start_ack());
+	add_acks(expected, 1, 3);
+	expected.push_back(end_ack(4));
+	check_stored(run("start ack lost", expected), "start", image, 3, FLASH_STORE_XBM);
+}
+
+
+// a data frame with a flipped bit, one missing a byte (which takes the
+// next frame's start with it) and one cut short: one NAK for each, the rest
+// of the window is dropped without an answer, and the host goes back
+static void check_damaged() {
+	bytes image = image_data(100, 3);
+	host_send(start_frame(image, "damaged"));
+	host_send_data(image, 1, 1);
+
+	bytes flipped = data_frame(image, 2);
+	flipped[6] ^= 0x10;
+	host_send(flipped);
+	host_send_data(image, 3, 3);
+	host_pause(1000);
+	host_send_data(image, 2, 2);
+
+	bytes short_frame = data_frame(image, 3);
+	short_frame.erase(short_frame.begin() + 8);
+	host_send(short_frame);
+	host_send_data(image, 4, 4);
+	host_pause(1000);
+	host_send_data(image, 3, 3);
+
+	bytes cut = data_frame(image, 4);
+	cut.resize(10);
+	host_send(cut);
+	host_pause(UPLOAD_BYTE_TIMEOUT_MS + 10);
+	host_send_data(image, 4, 4);
+	host_send(encode(UPLOAD_END, 5));
+	host_send(encode(UPLOAD_ABORT, 6));
+
+	std::vector<frame> expected(1, start_ack());
+	expected.push_back(ack(1));
+	expected.push_back(nak(UPLOAD_RETRY, 2));
+	expected.push_back(ack(2));
+	expected.push_back(nak(UPLOAD_RETRY, 3));
+	expected.push_back(ack(3));
+	expected.push_back(nak(UPLOAD_RETRY, 4));
+	expected.push_back(ack(4));
+	expected.push_back(end_ack(5));
+	check_stored(run("damaged", expected), "damaged", image, 3, FLASH_STORE_XBM);
+}
+
+
+// the data acks are lost: the host resends what it has in flight, which is
+// acked again and not stored twice
+static void check_data_ack_lost() {
+	bytes image = image_data(52, 4);
+	host_send(start_frame(image, "data"));
+	host_send_data(image, 1, 2);
+	host_pause(1000);
+	host_send_data(image, 1, 2);
+	host_send(encode(UPLOAD_END, 3));
+	host_send(encode(UPLOAD_ABORT, 4));
+
+	// both resent frames are answered with the last ack
+	std::vector<frame> expected(1, start_ack());
+	add_acks(expected, 1, 2);
+	expected.push_back(ack(2));
+	expected.push_back(ack(2));
+	expected.push_back(end_ack(3));
+	check_stored(run("data ack lost", expected), "data", image, 3, FLASH_STORE_XBM);
+}
+
+
+// the end ack is lost: the host goes back over its last window and the end
+// frame while the board lingers, and later goes quiet instead of aborting
+static void check_end_ack_lost() {
+	bytes image = image_data(78, 5);
+	host_send(start_frame(image, "end"));
+	host_send_data(image, 1, 3);
+	host_send(encode(UPLOAD_END, 4));
+	host_pause(1000);
+	host_send_data(image, 3, 3);
+	host_send(encode(UPLOAD_END, 4));
+
+	std::vector<frame> expected(1, start_ack());
+	add_acks(expected, 1, 3);
+	expected.push_back(end_ack(4));
+	expected.push_back(ack(3));
+	expected.push_back(end_ack(4));
+	unsigned long start = millis();
+	check_stored(run("end ack lost", expected), "end", image, 3, FLASH_STORE_XBM);
+	unsigned long linger = millis() - start - 1000;
+	CHECK(linger >= UPLOAD_LINGER_MS && linger < UPLOAD_LINGER_MS + 100);
+}
+
+
+// the same name again: the new image replaces the old one, whose sectors
+// are free again
+static void check_replace() {
+	bytes image = image_data(5000, 6);
+	host_send(start_frame(image, "again"));
+	host_send_data(image, 1, frame_count(image));
+	host_send(encode(UPLOAD_END, frame_count(image) + 1));
+	host_send(encode(UPLOAD_ABORT, frame_count(image) + 2));
+	std::vector<frame> expected(1, start_ack());
+	add_acks(expected, 1, frame_count(image));
+	expected.push_back(end_ack(frame_count(image) + 1));
+	check_stored(run("first", expected), "again", image, 3, FLASH_STORE_XBM);
+
+	uint16_t free_sectors = FLASH_STORE.free_sectors();
+	image = image_data(5000, 7);
+	host_send(start_frame(image, "again"));
+	host_send_data(image, 1, frame_count(image));
+	host_send(encode(UPLOAD_END, frame_count(image) + 1));
+	host_send(encode(UPLOAD_ABORT, frame_count(image) + 2));
+	check_stored(run("replacement", expected), "again", image, 3, FLASH_STORE_XBM);
+	CHECK_EQUAL(free_sectors, FLASH_STORE.free_sectors());
+}
+
+
+// uploads that fail store nothing and leave the free sectors as they were
+static void check_failed(const char *name, const std::vector<frame> &expected) {
+	uint16_t free_sectors = FLASH_STORE.free_sectors();
+	FLASH_STORE_entry entry;
+	CHECK_EQUAL(-1, run(name, expected));
+	CHECK_EQUAL(-1, FLASH_STORE.find(name, &entry));
+	CHECK_EQUAL(free_sectors, FLASH_STORE.free_sectors());
+}
+
+
+static void check_errors() {
+	// more data than announced
+	bytes image = image_data(60, 8);
+	host_send(encode(UPLOAD_START, 0, start_payload(30, 3, FLASH_STORE_XBM, image_crc(image), "long")));
+	host_send_data(image, 1, 2);
+	std::vector<frame> expected(1, start_ack());
+	expected.push_back(ack(1));
+	expected.push_back(nak(UPLOAD_BAD_LENGTH, 2));
+	check_failed("long", expected);
+
+	// too little data
+	host_send(start_frame(image, "short"));
+	host_send_data(image, 1, 2);
+	host_send(encode(UPLOAD_END, 3));
+	expected.assign(1, start_ack());
+	add_acks(expected, 1, 2);
+	expected.push_back(nak(UPLOAD_BAD_CRC32, 3));
+	check_failed("short", expected);
+
+	// the data does not match the CRC
+	host_send(encode(UPLOAD_START, 0, start_payload(60, 3, FLASH_STORE_XBM, image_crc(image) ^ 1, "crc")));
+	host_send_data(image, 1, 3);
+	host_send(encode(UPLOAD_END, 4));
+	expected.assign(1, start_ack());
+	add_acks(expected, 1, 3);
+	expected.push_back(nak(UPLOAD_BAD_CRC32, 4));
+	check_failed("crc", expected);
+
+	// abort part way
+	host_send(start_frame(image, "abort"));
+	host_send_data(image, 1, 1);
+	host_send(encode(UPLOAD_ABORT, 2));
+	expected.assign(1, start_ack());
+	add_acks(expected, 1, 2);
+	check_failed("abort", expected);
+
+	// start frames without a name, with a name that is too long, and for
+	// more than the FLASH holds
+	host_send(encode(UPLOAD_START, 0, start_payload(60, 3, FLASH_STORE_XBM, 0, "")));
+	check_failed("no name", std::vector<frame>(1, nak(UPLOAD_NO_SPACE, 0)));
+	host_send(encode(UPLOAD_START, 0, start_payload(60, 3, FLASH_STORE_XBM, 0, "sixteen_letters_")));
+	check_failed("sixteen_letters_", std::vector<frame>(1, nak(UPLOAD_NO_SPACE, 0)));
+	host_send(encode(UPLOAD_START, 0, start_payload(MX25_SIZE, 3, FLASH_STORE_XBM, 0, "huge")));
+	check_failed("huge", std::vector<frame>(1, nak(UPLOAD_NO_SPACE, 0)));
+
+	// data frames without a start frame are ignored, then the host goes quiet
+	host_send_data(image, 1, 2);
+	unsigned long start = millis();
+	check_failed("no start", std::vector<frame>());
+	unsigned long idle = millis() - start;
+	CHECK(idle >= UPLOAD_IDLE_TIMEOUT_MS && idle < UPLOAD_IDLE_TIMEOUT_MS + 100);
+}
+
+
+int main(int argc, char *argv[]) {
+	(void)argc;
+	std::string path = argv[0];
+	size_t slash = path.rfind('/');
+	path = (std::string::npos == slash ? std::string(".") : path.substr(0, slash)) + "/upload.bin";
+	remove(path.c_str());
+
+	mock_reset();
+	CHECK(mx25_attach(Pin_FLASH_CS, path.c_str()));
+	FLASH.begin(Pin_FLASH_CS);
+	FLASH_STORE.format();
+	UPLOAD.begin(Pin_RED_LED, LOW);
+	mock_on_serial_available = board_available;
+	mock_on_serial_read = board_read;
+	mock_on_serial_write = board_write;
+
+	check_crc16();
+	check_clean();
+	check_start_ack_lost();
+	check_damaged();
+	check_data_ack_lost();
+	check_end_ack_lost();
+	check_replace();
+	check_errors();
+	mx25_detach();
+	return test_report("upload");
+}
@@ -0,0 +1,186 @@
+// Copyright 2013 Pervasive Displays, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at:
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied.  See the License for the specific language
+// governing permissions and limitations under the License.
+
+
+
+// command.ino's binary upload ('b') and verify ('V') commands on a PC, for
+// upload.py --simulate: UPLOAD.cpp, FLASH.cpp and FLASH_STORE.cpp as built
+// for the board on the simulated MX25 FLASH (test/mx25.cpp) kept in a
+// flash_store.py file, with the serial line on stdin and stdout and the
+// clock in real time.  The receive buffer holds 64 bytes, as on the AVR, and
+// drops what arrives while it is full; the count is printed at the end.
+//
+// usage: upload_board flash.bin
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <Arduino.h>
+#include <FLASH.h>
+#include <FLASH_STORE.h>
+#include <UPLOAD.h>
+
+#include "mx25.h"
+
+static const uint8_t Pin_FLASH_CS = 9;
+static const size_t receive_buffer_size = 64;
+
+static std::mutex lock;
+static std::condition_variable arrived;
+static std::deque<uint8_t> receive_buffer;
+static unsigned long dropped;
+static bool closed;
+
+static std::chrono::steady_clock::time_point last_update;
+
+
+// the UART: bytes arrive whether or not the sketch is reading
+static void receive_line() {
+	uint8_t buffer[256];
+	ssize_t n;
+	while ((n = read(0, buffer, sizeof(buffer))) > 0) {
+		std::lock_guard<std::mutex> hold(lock);
+		for (ssize_t i = 0; i < n; ++i) {
+			if (receive_buffer.size() < receive_buffer_size) {
+				receive_buffer.push_back(buffer[i]);
+			} else {
+				++dropped;
+			}
+		}
+		arrived.notify_one();
+	}
+	std::lock_guard<std::mutex> hold(lock);
+	closed = true;
+	arrived.notify_one();
+}
+
+
+// real time passes on top of the time the simulated SPI bytes and delays
+// took, so millis() never goes backwards
+static void update_clock() {
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	mock_micros += std::chrono::duration_cast<std::chrono::microseconds>(now - last_update).count();
+	last_update = now;
+}
+
+
+// the sketch is waiting for input: send what it wrote and sleep a little
+static int board_available() {
+	fflush(stdout);
+	std::unique_lock<std::mutex> hold(lock);
+	if (receive_buffer.empty() && !closed) {
+		arrived.wait_for(hold, std::chrono::microseconds(500));
+	}
+	update_clock();
+	return receive_buffer.size();
+}
+
+
+static int board_read() {
+	std::lock_guard<std::mutex> hold(lock);
+	if (receive_buffer.empty()) {
+		return -1;
+	}
+	uint8_t c = receive_buffer.front();
+	receive_buffer.pop_front();
+	return c;
+}
+
+
+static void board_write(uint8_t c) {
+	putchar(c);
+}
+
+
+// next command character, -1 once the host has closed the line
+static int command() {
+	for (;;) {
+		if (Serial.available()) {
+			return Serial.read();
+		}
+		std::lock_guard<std::mutex> hold(lock);
+		if (closed && receive_buffer.empty()) {
+			return -1;
+		}
+	}
+}
+
+
+// command.ino 'V'
+static void verify_all() {
+	char line[80];
+	int count = 0;
+	int bad = 0;
+	FLASH_STORE_entry entry;
+	Serial.println();
+	for (int16_t id = FLASH_STORE.next(0, &entry); id >= 0; id = FLASH_STORE.next(id + 1, &entry)) {
+		uint32_t crc = FLASH_STORE.crc32_flash(FLASH_STORE.address(&entry), entry.length);
+		snprintf(line, sizeof(line), "verify: %02x %s %08lx", id, entry.name, (unsigned long)entry.crc);
+		Serial.print(line);
+		if (crc == entry.crc) {
+			Serial.println(" ok");
+		} else {
+			snprintf(line, sizeof(line), " BAD %08lx", (unsigned long)crc);
+			Serial.println(line);
+			++bad;
+		}
+		++count;
+	}
+	snprintf(line, sizeof(line), "verify: images = %02x bad = %02x", count, bad);
+	Serial.println(line);
+}
+
+
+int main(int argc, char *argv[]) {
+	if (2 != argc) {
+		fprintf(stderr, "usage: %s flash.bin\n", argv[0]);
+		return 2;
+	}
+	mock_reset();
+	last_update = std::chrono::steady_clock::now();
+	if (!mx25_attach(Pin_FLASH_CS, argv[1])) {
+		fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	FLASH.begin(Pin_FLASH_CS);
+	if (!FLASH_STORE.begin()) {
+		FLASH_STORE.format();
+	}
+	UPLOAD.begin();
+	mock_on_serial_available = board_available;
+	mock_on_serial_read = board_read;
+	mock_on_serial_write = board_write;
+
+	std::thread line(receive_line);
+	for (int c; (c = command()) >= 0; ) {
+		if ('b' == c) {
+			UPLOAD.receive();
+		} else if ('V' == c) {
+			verify_all();
+		}
+	}
+	fflush(stdout);
+	line.join();
+	mx25_detach();
+	if (0 != dropped) {
+		fprintf(stderr, "receive buffer overflow: %lu bytes dropped\n", dropped);
+	}
+	return 0;
+}
@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+# Upload images into the FLASH_STORE of a board running command.ino
+#
+# Uses the binary upload ('b' command) instead of pasting XBM text:
+# frames of raw image bytes with a CRC-16, acknowledged by the board, with a
+# small window of frames in flight (see the protocol comment in the UPLOAD
+# library).
+#
+# With --simulate the board is test/build/upload_board (make -C test upload):
+# the UPLOAD library built for the PC, storing into a flash_store.py FLASH
+# file, and --loss damages that fraction of the frames in both directions,
+# to exercise the retries.
+#
+# -V asks the board to read back every stored image and check its CRC, any
+# images given must also be stored with the same data.
+#
+# usage: upload.py [-d /dev/ttyACM0] [-s 115200] [-p] [-n name] image.xbm...
+#        upload.py [-d /dev/ttyACM0] -V [image.xbm...]
+#        upload.py --simulate flash.bin [--loss 0.05] [-p] image.xbm...
+
+import argparse
+import binascii
+import os
+import random
+import struct
+import subprocess
+import sys
+import threading
+import time
+import zlib
+
+from convert_xbm_to_packbits import packbits, read_xbm
+import flash_store
+
+SOF = 0xa5
+START, DATA, END, ABORT, ACK, NAK = b'SDEAKN'
+RETRY, NO_SPACE, BAD_LENGTH, BAD_CRC32, DIRECTORY_FULL = range(5)
+ERRORS = ['retry', 'no free sectors', 'too much data', 'image CRC mismatch', 'directory full']
+
+ACK_TIMEOUT = 1.0
+START_TIMEOUT = 3.0
+RETRIES = 10
+
+
+def crc16(data):
+	return binascii.crc_hqx(data, 0xffff)
+
+
+def frame(type, seq, payload=b''):
+	body = bytes([type, seq & 0xff, len(payload)]) + payload
+	return bytes([SOF]) + body + struct.pack('<H', crc16(body))
+
+
+class FrameReader:
+	# collects frames out of a byte stream, skipping anything else
+	def __init__(self, read_byte):
+		self.read_byte = read_byte
+
+	def read(self, timeout):
+		end = time.time() + timeout
+		while True:
+			b = self.read_byte(end - time.time())
+			if None is b:
+				return None
+			if SOF != b:
+				continue
+			body = bytearray()
+			for n in (3, None, 2):
+				want = n if n else body[2]
+				while want:
+					b = self.read_byte(0.1)
+					if None is b:
+						return False
+					body.append(b)
+					want -= 1
+			data, crc = bytes(body[:-2]), struct.unpack('<H', bytes(body[-2:]))[0]
+			if crc16(data) != crc:
+				return False
+			return data[0], data[1], data[3:]
+
+
+class SerialLink:
+	def __init__(self, device, speed):
+		import serial
+		self.port = serial.Serial(device, speed, timeout=0)
+		time.sleep(2)  # the board resets when the port opens
+		self.port.reset_input_buffer()
+
+	def write(self, data):
+		self.port.write(data)
+
+	def read_byte(self, timeout):
+		end = time.time() + max(timeout, 0)
+		while True:
+			b = self.port.read(1)
+			if b:
+				return b[0]
+			if time.time() >= end:
+				return None
+			time.sleep(0.0005)
+
+
+def damage(data, loss):
+	# a dropped or a flipped byte in loss of the frames
+	if random.random() >= loss:
+		return data
+	data = bytearray(data)
+	if random.random() < 0.5:
+		del data[random.randrange(len(data))]
+	else:
+		data[random.randrange(len(data))] ^= 0x10
+	return bytes(data)
+
+
+class BoardProcess:
+	# test/build/upload_board on a flash_store.py file, over its stdin and stdout
+	PROGRAM = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'test', 'build', 'upload_board')
+
+	def __init__(self, flash_name, loss):
+		if not os.path.exists(self.PROGRAM):
+			sys.exit('%s not found, build it with: make -C test build/upload_board' % self.PROGRAM)
+		self.process = subprocess.Popen([self.PROGRAM, flash_name], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+		self.loss = loss
+		self.buffer = bytearray()
+		self.cond = threading.Condition()
+		self.reader = threading.Thread(target=self.receive)
+		self.reader.start()
+
+	def write(self, data):
+		self.process.stdin.write(damage(data, self.loss))
+		self.process.stdin.flush()
+
+	def receive(self):
+		# split the board's output into frames to damage them, the rest is text
+		out = self.process.stdout
+		while True:
+			b = out.read(1)
+			if not b:
+				break
+			if SOF == b[0]:
+				header = out.read(3)
+				b += header
+				if 3 == len(header):
+					b = damage(b + out.read(header[2] + 2), self.loss)
+			with self.cond:
+				self.buffer += b
+				self.cond.notify()
+
+	def read_byte(self, timeout):
+		end = time.time() + max(timeout, 0)
+		with self.cond:
+			while not self.buffer:
+				left = end - time.time()
+				if left <= 0:
+					return None
+				self.cond.wait(left)
+			return self.buffer.pop(0)
+
+	def close(self):
+		self.process.stdin.close()
+		self.process.wait()
+		self.reader.join()
+
+
+def upload(link, name, data, panel, format, verbose):
+	reader = FrameReader(link.read_byte)
+	start = struct.pack('<IBBI', len(data), panel, format, zlib.crc32(data) & 0xffffffff) + name.encode('latin-1')
+
+	for attempt in range(RETRIES):
+		# the 'b' command is skipped if the board is already waiting for frames
+		link.write(b'b' + frame(START, 0, start))
+		r = reader.read(START_TIMEOUT)
+		if r and ACK == r[0] and 0 == r[1] and 2 == len(r[2]):
+			payload_size, window = r[2][0], r[2][1]
+			break
+		if r and NAK == r[0]:
+			sys.exit('upload refused: %s' % ERRORS[r[2][0]])
+	else:
+		sys.exit('no answer to the start frame')
+
+	frames = [frame(DATA, i + 1, data[o:o + payload_size])
+	          for i, o in enumerate(range(0, len(data), payload_size))]
+	frames.append(frame(END, len(frames) + 1))
+	seqs = [(i + 1) & 0xff for i in range(len(frames))]
+
+	base = 0     # first frame not acknowledged
+	next = 0     # next frame to send
+	retries = 0
+	resent = 0
+	begin = time.time()
+	while base < len(frames):
+		while next < len(frames) and next < base + window:
+			link.write(frames[next])
+			next += 1
+		r = reader.read(ACK_TIMEOUT)
+		if not r:
+			# nothing (or garbage) back: go back to the first unacknowledged frame
+			retries += 1
+			if retries > RETRIES:
+				sys.exit('no answer after frame %d' % base)
+			resent += next - base
+			next = base
+			continue
+		type, seq, payload = r
+		in_flight = [i for i in range(base, next + 1) if i < len(frames) and seqs[i] == seq]
+		if ACK == type and in_flight:
+			retries = 0
+			base = in_flight[0] + 1
+			if base == len(frames):
+				id = payload[0]
+		elif NAK == type and payload and RETRY == payload[0]:
+			if in_flight:
+				resent += next - in_flight[0]
+				base = next = in_flight[0]
+		elif NAK == type and payload:
+			sys.exit('upload failed: %s' % ERRORS[payload[0]] if payload[0] < len(ERRORS) else payload[0])
+		if verbose:
+			sys.stdout.write('\r%5d / %d bytes' % (min(base * payload_size, len(data)), len(data)))
+			sys.stdout.flush()
+	# done, the board stops waiting for a repeated end frame
+	link.write(frame(ABORT, seqs[-1] + 1))
+	seconds = time.time() - begin
+	if verbose:
+		sys.stdout.write('\n')
+	print('%s stored as image %d: %d bytes in %.2f s (%d frames of %d, window %d, %d resent)' % (
+		name, id, len(data), seconds, len(frames), payload_size, window, resent))
+
+
+def verify(link, expected):
+	# 'V': one line per image, then a summary
+	link.write(b'V')
+	line = bytearray()
+	results = []
+	while True:
+		b = link.read_byte(10.0)
+		if None is b:
+			sys.exit('no answer to verify')
+		if ord('\n') != b:
+			line.append(b)
+			continue
+		text = line.decode('latin-1').strip()
+		line = bytearray()
+		if not text.startswith('verify: '):
+			continue
+		fields = text.split()
+		if 'images' == fields[1]:
+			break
+		results.append((int(fields[1], 16), fields[2], int(fields[3], 16), 'ok' == fields[4]))
+
+	bad = 0
+	for id, name, crc, ok in results:
+		status = 'ok' if ok else 'BAD (read back does not match)'
+		if ok and name in expected and expected[name] != crc:
+			status = 'differs from %s' % name
+			ok = False
+		bad += not ok
+		print('%3d %-15s %08x %s' % (id, name, crc, status))
+	for name in sorted(set(expected) - set(r[1] for r in results)):
+		print('    %-15s missing' % name)
+		bad += 1
+	print('%d images, %d bad' % (len(results), bad))
+	return 0 == bad
+
+
+def load_image(file_name, name, compress):
+	width, height, data = read_xbm(file_name)
+	panel = flash_store.panel_for(width, height)
+	if None is panel:
+		sys.exit('%s: %d x %d does not match a panel' % (file_name, width, height))
+	format = flash_store.XBM
+	if compress:
+		data = packbits(data)
+		format = flash_store.PACKBITS
+	name = name or os.path.splitext(os.path.basename(file_name))[0]
+	if len(name) >= flash_store.NAME_SIZE:
+		sys.exit('%s: name longer than %d characters' % (name, flash_store.NAME_SIZE - 1))
+	return name, data, panel, format
+
+
+def main():
+	parser = argparse.ArgumentParser(description='binary image upload for command.ino')
+	parser.add_argument('-d', '--device', default='/dev/ttyACM0', help='serial port')
+	parser.add_argument('-s', '--speed', type=int, default=115200)
+	parser.add_argument('-p', '--packbits', action='store_true', help='store PackBits compressed')
+	parser.add_argument('-n', '--name', help='image name (default: file name)')
+	parser.add_argument('--simulate', metavar='FLASH', help='upload into test/build/upload_board using this flash_store.py file')
+	parser.add_argument('--loss', type=float, default=0.0, help='fraction of frames damaged in simulation')
+	parser.add_argument('-q', '--quiet', action='store_true')
+	parser.add_argument('-V', '--verify', action='store_true',
+	                    help='have the board check every stored image, and that the given images match')
+	parser.add_argument('images', nargs='*')
+	args = parser.parse_args()
+	if args.name and 1 != len(args.images):
+		sys.exit('--name needs a single image')
+
+	images = [load_image(f, args.name, args.packbits) for f in args.images]
+
+	if args.simulate:
+		link = BoardProcess(args.simulate, args.loss)
+	else:
+		link = SerialLink(args.device, args.speed)
+
+	ok = True
+	try:
+		if args.verify:
+			ok = verify(link, dict((name, zlib.crc32(data) & 0xffffffff) for name, data, _, _ in images))
+		else:
+			for name, data, panel, format in images:
+				upload(link, name, data, panel, format, not args.quiet)
+	finally:
+		if args.simulate:
+			link.close()
+	sys.exit(0 if ok else 1)
+
+
+if '__main__' == __name__:
+	main()